@@ -0,0 +1,139 @@
+#!/usr/bin/env python3
+"""Merge and compare the JSON benchmark results produced by RunGen.
+
+    compare_benchmarks.py merge [--target=T] -o results.json inputs...
+
+        Merge the output of one or more `RunGen --benchmark_json=...` runs
+        (and/or previously merged results files) into a single results file,
+        with one entry per pipeline holding the statistics of every run.
+
+    compare_benchmarks.py compare [--min_threshold=F] [--noise_sigmas=N] \\
+        baseline.json results.json
+
+        Compare two merged results files, print a table of the change in
+        median time for each pipeline, and exit with a nonzero status if any
+        pipeline got slower by more than the noise threshold.
+"""
+
+import argparse
+import json
+import math
+import sys
+
+# The per-run statistics we keep from each RunGen result.
+RUN_KEYS = ['calls', 'throughput_mpix_per_sec']
+LATENCY_KEYS = ['min', 'mean', 'stddev', 'p50', 'p90', 'p99', 'max']
+
+
+def median(values):
+    values = sorted(values)
+    n = len(values)
+    if n % 2:
+        return values[n // 2]
+    return 0.5 * (values[n // 2 - 1] + values[n // 2])
+
+
+def summarize(runs):
+    """Returns (median time, relative standard error of that median)."""
+    times = [r['p50'] for r in runs]
+    m = median(times)
+    if len(times) > 1:
+        # Run-to-run noise: a robust estimate of the standard deviation of a
+        # single run (from the median absolute deviation), scaled to the
+        # standard error of the median of all the runs.
+        mad = median([abs(t - m) for t in times])
+        sigma = 1.4826 * mad * 1.2533 / math.sqrt(len(times))
+    else:
+        # With only one run, all we have is the call-to-call noise within it.
+        r = runs[0]
+        sigma = r['stddev'] / math.sqrt(max(1, r['calls']))
+    return m, sigma / m
+
+
+def merge(args):
+    merged = {'target': args.target, 'benchmarks': {}}
+    for path in args.inputs:
+        with open(path) as f:
+            data = json.load(f)
+        if 'benchmarks' in data:
+            # A previously merged results file.
+            if not merged['target']:
+                merged['target'] = data.get('target')
+            for name, entry in data['benchmarks'].items():
+                merged['benchmarks'].setdefault(name, {'runs': []})['runs'].extend(entry['runs'])
+        else:
+            # The output of a single RunGen run.
+            run = {k: data[k] for k in RUN_KEYS}
+            run.update({k: data['latency_sec'][k] for k in LATENCY_KEYS})
+            merged['benchmarks'].setdefault(data['name'], {'runs': []})['runs'].append(run)
+    for entry in merged['benchmarks'].values():
+        entry['median_sec'], entry['relative_error'] = summarize(entry['runs'])
+    with open(args.output, 'w') as f:
+        json.dump(merged, f, indent=2, sort_keys=True)
+        f.write('\n')
+
+
+def compare(args):
+    with open(args.baseline) as f:
+        baseline = json.load(f)
+    with open(args.results) as f:
+        results = json.load(f)
+    if baseline.get('target') != results.get('target'):
+        print('Warning: comparing results for target %s against a baseline for target %s' %
+              (results.get('target'), baseline.get('target')))
+
+    names = sorted(set(baseline['benchmarks']) | set(results['benchmarks']))
+    print('%-20s %12s %12s %9s %9s  %s' % ('benchmark', 'baseline ms', 'current ms', 'change', 'noise', 'status'))
+    regressions = 0
+    for name in names:
+        if name not in baseline['benchmarks']:
+            print('%-20s %12s %12s %9s %9s  %s' % (name, '-', '-', '-', '-', 'no baseline'))
+            continue
+        if name not in results['benchmarks']:
+            print('%-20s %12s %12s %9s %9s  %s' % (name, '-', '-', '-', '-', 'missing'))
+            regressions += 1
+            continue
+        base_time, base_error = summarize(baseline['benchmarks'][name]['runs'])
+        time, error = summarize(results['benchmarks'][name]['runs'])
+        change = time / base_time - 1.0
+        threshold = max(args.min_threshold, args.noise_sigmas * math.sqrt(base_error ** 2 + error ** 2))
+        if change > threshold:
+            status = 'REGRESSION'
+            regressions += 1
+        elif change < -threshold:
+            status = 'improved'
+        else:
+            status = 'ok'
+        print('%-20s %12.3f %12.3f %+8.1f%% %8.1f%%  %s' %
+              (name, base_time * 1e3, time * 1e3, change * 100, threshold * 100, status))
+    if regressions:
+        print('%d benchmark(s) regressed.' % regressions)
+        return 1
+    return 0
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    subparsers = parser.add_subparsers(dest='command')
+    subparsers.required = True
+
+    merge_parser = subparsers.add_parser('merge')
+    merge_parser.add_argument('--target', default='')
+    merge_parser.add_argument('-o', dest='output', required=True)
+    merge_parser.add_argument('inputs', nargs='+')
+
+    compare_parser = subparsers.add_parser('compare')
+    compare_parser.add_argument('--min_threshold', type=float, default=0.05)
+    compare_parser.add_argument('--noise_sigmas', type=float, default=3)
+    compare_parser.add_argument('baseline')
+    compare_parser.add_argument('results')
+
+    args = parser.parse_args()
+    if args.command == 'merge':
+        merge(args)
+        return 0
+    return compare(args)
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,50 @@
+#include <cstdio>
+#include <cstdlib>
+
+#include "HalideBuffer.h"
+#include "halide_benchmark.h"
+#include "bench_c.h"
+#include "bench_native.h"
+
+using namespace Halide::Runtime;
+using namespace Halide::Tools;
+
+// Compare the performance of the C backend against the native backend on a
+// vectorized pipeline, and check that they compute the same thing.
+int main(int argc, char **argv) {
+    Buffer<uint8_t> in(1536, 2560);
+
+    for (int y = 0; y < in.height(); y++) {
+        for (int x = 0; x < in.width(); x++) {
+            in(x, y) = (uint8_t)rand();
+        }
+    }
+
+    Buffer<uint8_t> out_native(in.width(), in.height());
+    Buffer<uint8_t> out_c(in.width(), in.height());
+
+    double t_native = benchmark(10, 10, [&]() {
+        bench_native(in, out_native);
+    });
+
+    double t_c = benchmark(10, 10, [&]() {
+        bench_c(in, out_c);
+    });
+
+    for (int y = 0; y < out_native.height(); y++) {
+        for (int x = 0; x < out_native.width(); x++) {
+            if (out_native(x, y) != out_c(x, y)) {
+                printf("out_native(%d, %d) = %d, but out_c(%d, %d) = %d\n",
+                       x, y, out_native(x, y),
+                       x, y, out_c(x, y));
+                return -1;
+            }
+        }
+    }
+
+    printf("Native backend: %f ms\n", t_native * 1e3);
+    printf("C backend:      %f ms (%.2fx)\n", t_c * 1e3, t_c / t_native);
+
+    printf("Success!\n");
+    return 0;
+}
@@ -0,0 +1,43 @@
+#include "Halide.h"
+
+namespace {
+
+// A vectorized pipeline used to compare the performance of the C backend
+// against the native (LLVM) backend. It exercises the vector operations
+// the C backend emits most often: widening and narrowing casts, min/max,
+// select and shuffles of dense loads.
+class Bench : public Halide::Generator<Bench> {
+public:
+    Input<Buffer<uint8_t>> input{"input", 2};
+    Output<Buffer<uint8_t>> output{"output", 2};
+
+    void generate() {
+        Var x("x"), y("y"), xi("xi"), yi("yi");
+
+        Func clamped = Halide::BoundaryConditions::repeat_edge(input);
+
+        Func in16("in16");
+        in16(x, y) = cast<uint16_t>(clamped(x, y));
+
+        Func blur_x("blur_x");
+        blur_x(x, y) = in16(x - 1, y) + 2 * in16(x, y) + in16(x + 1, y);
+
+        Func blur_y("blur_y");
+        blur_y(x, y) = (blur_x(x, y - 1) + 2 * blur_x(x, y) + blur_x(x, y + 1) + 8) / 16;
+
+        // Sharpen and clamp to the range of the input.
+        Expr sharpened = 2 * cast<int16_t>(in16(x, y)) - cast<int16_t>(blur_y(x, y));
+        Expr high = max(clamped(x - 1, y), clamped(x + 1, y));
+        Expr low = min(clamped(x - 1, y), clamped(x + 1, y));
+        output(x, y) = select(blur_y(x, y) > 128,
+                              cast<uint8_t>(clamp(sharpened, low, high)),
+                              cast<uint8_t>(blur_y(x, y)));
+
+        output.tile(x, y, xi, yi, 64, 32).vectorize(xi, 16);
+        blur_x.compute_at(output, x).vectorize(x, 16);
+    }
+};
+
+}  // namespace
+
+HALIDE_REGISTER_GENERATOR(Bench, bench)
@@ -73,6 +73,18 @@ int main(int argc, char **argv) {
     });
     fprintf(stderr, "Halide (manual):\t%gus\n", best * 1e6);
 
+    halide_enable_malloc_pool(nullptr, 256 * 1024 * 1024);
+    best = benchmark(timing_iterations, 1, [&]() {
+        camera_pipe(input, matrix_3200, matrix_7000,
+                    color_temp, gamma, contrast, sharpen, blackLevel, whiteLevel,
+                    output);
+    });
+    halide_malloc_pool_stats_t stats;
+    halide_malloc_pool_get_stats(nullptr, &stats);
+    halide_disable_malloc_pool(nullptr);
+    fprintf(stderr, "Halide (manual, malloc pool):\t%gus (%llu of %llu allocations reused)\n",
+            best * 1e6, (unsigned long long)stats.hits, (unsigned long long)stats.allocations);
+
     #ifndef NO_AUTO_SCHEDULE
     best = benchmark(timing_iterations, 1, [&]() {
         camera_pipe_auto_schedule(input, matrix_3200, matrix_7000,
@@ -27,6 +27,13 @@ function(halide_use_image_io TARGET)
       target_compile_definitions(${TARGET} PRIVATE -DHALIDE_NO_${PKG})
     endif()
   endforeach()
+  # halide_image_io.h converts pixels on multiple threads.
+  find_package(Threads QUIET)
+  if(Threads_FOUND)
+    target_link_libraries(${TARGET} PRIVATE Threads::Threads)
+  else()
+    target_compile_definitions(${TARGET} PRIVATE -DHALIDE_NO_IMAGE_IO_THREADS)
+  endif()
 endfunction()
 
 # Make a build target for a Generator.
@@ -506,6 +513,7 @@ function(_halide_runtime_target_name HALIDE_TARGET OUTVAR)
         asan
         check_unsafe_promises
         hexagon_dma
+        cancellable
       )
     # Synthesize a one-or-two-char abbreviation based on the feature's position
     # in the KNOWN_FEATURES list.
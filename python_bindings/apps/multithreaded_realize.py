@@ -0,0 +1,89 @@
+"""
+Realize one JIT-compiled pipeline from several Python threads at once.
+
+realize() releases the GIL while the compiled code runs, so independent
+calls from different Python threads run concurrently; with a pipeline that is not
+itself parallelized, the throughput should scale with the number of
+threads (up to the number of cores). Inputs and outputs are numpy arrays
+shared with Halide without copying, and each thread binds its own input
+with a ParamMap.
+"""
+
+import halide as hl
+
+import numpy as np
+import multiprocessing
+import threading
+import time
+
+
+def get_blur(input):
+    x, y = hl.Var("x"), hl.Var("y")
+
+    clamped = hl.BoundaryConditions.repeat_edge(input)
+
+    blur_x = hl.Func("blur_x")
+    blur_y = hl.Func("blur_y")
+    blur_x[x, y] = (clamped[x, y] + clamped[x + 1, y] + clamped[x + 2, y]) / 3
+    blur_y[x, y] = (blur_x[x, y] + blur_x[x, y + 1] + blur_x[x, y + 2]) / 3
+
+    # Deliberately not parallel: here the parallelism comes from the
+    # Python threads.
+    xi, yi = hl.Var("xi"), hl.Var("yi")
+    blur_y.tile(x, y, xi, yi, 64, 32).vectorize(xi, 8)
+    blur_x.compute_at(blur_y, x).vectorize(x, 8)
+
+    return blur_y
+
+
+def run(blur, input, inputs, outputs, num_threads, iterations):
+    def worker(i):
+        param_map = hl.ParamMap()
+        param_map.set(input, hl.Buffer(inputs[i]))
+        output = hl.Buffer(outputs[i])
+        for _ in range(iterations):
+            blur.realize(output, param_map=param_map)
+
+    threads = [threading.Thread(target=worker, args=(i,)) for i in range(num_threads)]
+    start = time.time()
+    for t in threads:
+        t.start()
+    for t in threads:
+        t.join()
+    return time.time() - start
+
+
+def main():
+    width, height = 1536, 2560
+    iterations = 10
+    max_threads = min(8, multiprocessing.cpu_count())
+
+    input = hl.ImageParam(hl.Float(32), 2, "input")
+    blur = get_blur(input)
+    blur.compile_jit()
+
+    np.random.seed(0)
+    inputs = [np.asfortranarray(np.random.rand(width, height), dtype=np.float32) for _ in range(max_threads)]
+    outputs = [np.empty((width, height), dtype=np.float32, order="F") for _ in range(max_threads)]
+
+    # Check the threaded results against a single-threaded run.
+    expected = np.empty((width, height), dtype=np.float32, order="F")
+    input.set(hl.Buffer(inputs[0]))
+    blur.realize(hl.Buffer(expected))
+
+    base = None
+    num_threads = 1
+    while num_threads <= max_threads:
+        t = run(blur, input, inputs, outputs, num_threads, iterations)
+        throughput = num_threads * iterations * width * height / t / 1e6
+        if base is None:
+            base = throughput
+        print("%d thread(s): %8.1f MP/s (%.2fx)" % (num_threads, throughput, throughput / base))
+        assert np.array_equal(outputs[0], expected)
+        num_threads *= 2
+
+    print("Success!")
+
+
+if __name__ == "__main__":
+    main()
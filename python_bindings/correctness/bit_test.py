@@ -2,19 +2,24 @@ from __future__ import print_function
 
 import array
 import bit
+import numpy
 import sys
 
 
 def test():
     bool_constant = True
-    input_u1 = array.array('B', [0, 1, 0, 1])
-    output_u1 = array.array('B', [0, 1, 0, 1])
+    input_u1 = numpy.array([False, True, False, True])
+    output_u1 = numpy.zeros(4, dtype=numpy.bool_)
 
+    bit.bit(input_u1, bool_constant, output_u1)
+    assert (output_u1 == (input_u1 != bool_constant)).all()
+
+    # Bools are stored one per byte, but a uint8 array isn't a bool array.
     try:
         bit.bit(
-            input_u1, bool_constant, output_u1
+            array.array('B', [0, 1, 0, 1]), bool_constant, output_u1
         )
-    except NotImplementedError:
+    except ValueError:
         pass  # OK - that's what we expected.
     else:
         print("Expected Exception not raised.", file=sys.stderr)
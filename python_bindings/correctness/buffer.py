@@ -123,6 +123,73 @@ def test_float16():
     hl_img = hl.Buffer(array_in)
     array_out = np.array(hl_img, copy = False)
 
+def test_all_element_types():
+    # numpy spells some types differently from the canonical struct format
+    # (e.g. int64 is usually 'l' rather than 'q'); all of them should work.
+    for dtype, t in [(np.bool_, hl.Bool()),
+                     (np.uint8, hl.UInt(8)), (np.uint16, hl.UInt(16)),
+                     (np.uint32, hl.UInt(32)), (np.uint64, hl.UInt(64)),
+                     (np.int8, hl.Int(8)), (np.int16, hl.Int(16)),
+                     (np.int32, hl.Int(32)), (np.int64, hl.Int(64)),
+                     (np.intc, hl.Int(32)), (np.longlong, hl.Int(64)),
+                     (np.float16, hl.Float(16)), (np.float32, hl.Float(32)),
+                     (np.float64, hl.Float(64))]:
+        a = np.zeros((3, 4), dtype=dtype)
+        b = hl.Buffer(a)
+        assert b.type() == t, (dtype, b.type())
+        a_out = np.asarray(b)
+        assert a_out.dtype == a.dtype
+        assert a_out.ctypes.data == a.ctypes.data
+
+    # Non-native byte order can't be shared, so it's an error rather than a copy.
+    try:
+        hl.Buffer(np.zeros((3, 4), dtype=np.dtype(np.int32).newbyteorder()))
+    except ValueError:
+        pass
+    else:
+        assert False, "Expected a ValueError"
+
+
+def test_arbitrary_strides():
+    a = np.arange(60, dtype=np.int32).reshape(6, 10)
+    v = a[::-1, ::2]
+    b = hl.Buffer(v)
+    assert b.dim(0).extent() == 6
+    assert b.dim(0).stride() == -10
+    assert b.dim(1).extent() == 5
+    assert b.dim(1).stride() == 2
+    for i in range(6):
+        for j in range(5):
+            assert b[i, j] == v[i, j]
+
+    # Writes go straight through to the original array, in both directions.
+    b[1, 1] = -5
+    assert a[4, 2] == -5
+    a[0, 8] = -7
+    assert b[5, 4] == -7
+
+    # And the round trip back to numpy preserves the (negative) strides.
+    v_out = np.asarray(b)
+    assert v_out.strides == v.strides
+    assert (v_out == v).all()
+
+
+def test_realize_into_ndarray():
+    x, y = hl.Var("x"), hl.Var("y")
+    f = hl.Func("f")
+    f[x, y] = hl.cast(hl.Float(32), x + y * 10)
+
+    # Realizing into a Buffer that wraps an ndarray writes the ndarray
+    # directly, even if it's not densely packed.
+    out = np.zeros((8, 12), dtype=np.float32)
+    view = out[:, ::2]
+    f.realize(hl.Buffer(view))
+    for i in range(8):
+        for j in range(6):
+            assert view[i, j] == i + j * 10
+    assert (out[:, 1::2] == 0).all()
+
+
 if __name__ == "__main__":
     test_ndarray_to_buffer()
     test_buffer_to_ndarray()
@@ -130,4 +197,7 @@ if __name__ == "__main__":
     test_fill_all_equal()
     test_bufferinfo_sharing()
     test_float16()
+    test_all_element_types()
+    test_arbitrary_strides()
+    test_realize_into_ndarray()
 
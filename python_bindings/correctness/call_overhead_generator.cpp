@@ -0,0 +1,23 @@
+#include "Halide.h"
+
+using namespace Halide;
+
+// A pipeline that does almost no work, so that calling it from Python
+// measures the overhead of the generated extension itself.
+class CallOverheadGenerator : public Halide::Generator<CallOverheadGenerator> {
+public:
+    Input<Buffer<float>> input{"input", 2};
+    Input<float> offset{"offset"};
+    Output<Buffer<float>> output{"output", 2};
+
+    Var x, y;
+
+    void generate() {
+        output(x, y) = input(x, y) + offset;
+    }
+
+    void schedule() {
+    }
+};
+
+HALIDE_REGISTER_GENERATOR(CallOverheadGenerator, call_overhead)
@@ -0,0 +1,60 @@
+from __future__ import print_function
+
+import call_overhead
+import numpy
+import timeit
+
+
+def test_strided():
+    # Non-contiguous views are passed through without copying.
+    input = numpy.arange(48, dtype=numpy.float32).reshape(8, 6)
+    output = numpy.zeros((8, 6), dtype=numpy.float32)
+    call_overhead.call_overhead(input[::2, ::-1], 0.5, output[::2, ::-1])
+    assert (output[::2] == input[::2] + 0.5).all()
+    assert (output[1::2] == 0).all()
+
+    try:
+        call_overhead.call_overhead(input.astype(numpy.float64), 0.5, output)
+    except ValueError:
+        pass  # OK - the type doesn't match the generator's.
+    else:
+        assert False, "Expected ValueError for a float64 input"
+
+
+def test_batch():
+    inputs = [numpy.full((4, 4), i, dtype=numpy.float32) for i in range(10)]
+    outputs = [numpy.zeros((4, 4), dtype=numpy.float32) for i in range(10)]
+    calls = [(i, 1.0, o) for i, o in zip(inputs, outputs)]
+    calls.append({"input": inputs[0], "offset": 2.0, "output": outputs[0]})
+    call_overhead.call_overhead_batch(calls)
+    for i in range(1, 10):
+        assert (outputs[i] == i + 1).all()
+    assert (outputs[0] == 2).all()
+
+
+def benchmark():
+    input = numpy.ones((4, 4), dtype=numpy.float32)
+    output = numpy.zeros((4, 4), dtype=numpy.float32)
+    n = 100000
+
+    def empty(input, offset, output):
+        pass
+
+    t_empty = timeit.timeit(lambda: empty(input, 1.0, output), number=n) / n
+    t_call = timeit.timeit(lambda: call_overhead.call_overhead(input, 1.0, output), number=n) / n
+    t_kwargs = timeit.timeit(lambda: call_overhead.call_overhead(input=input, offset=1.0, output=output),
+                             number=n) / n
+    calls = [(input, 1.0, output)] * n
+    t_batch = timeit.timeit(lambda: call_overhead.call_overhead_batch(calls), number=1) / n
+
+    print("Python function call: %6.0f ns" % (t_empty * 1e9))
+    print("Positional arguments: %6.0f ns per call" % (t_call * 1e9))
+    print("Keyword arguments:    %6.0f ns per call" % (t_kwargs * 1e9))
+    print("Batched:              %6.0f ns per call" % (t_batch * 1e9))
+
+
+if __name__ == "__main__":
+    test_strided()
+    test_batch()
+    benchmark()
+    print("Success!")
@@ -132,31 +132,41 @@ std::string type_to_format_descriptor(const Type &type) {
     return std::string();
 }
 
-Type format_descriptor_to_type(const std::string &fd) {
-
-    #define HANDLE_BUFFER_TYPE(TYPE) \
-        if (fd == format_descriptor<TYPE>()) return type_of<TYPE>();
-
-    HANDLE_BUFFER_TYPE(bool)
-    HANDLE_BUFFER_TYPE(uint8_t)
-    HANDLE_BUFFER_TYPE(uint16_t)
-    HANDLE_BUFFER_TYPE(uint32_t)
-    HANDLE_BUFFER_TYPE(uint64_t)
-    HANDLE_BUFFER_TYPE(int8_t)
-    HANDLE_BUFFER_TYPE(int16_t)
-    HANDLE_BUFFER_TYPE(int32_t)
-    HANDLE_BUFFER_TYPE(int64_t)
-    HANDLE_BUFFER_TYPE(float16_t)
-    HANDLE_BUFFER_TYPE(float)
-    HANDLE_BUFFER_TYPE(double)
+// Buffer-protocol producers don't agree on a single spelling for each
+// type (e.g. numpy reports int64 as 'l' on most 64-bit platforms but 'q'
+// on Windows, and may add a byte-order prefix), so decode the format from
+// its kind and item size rather than matching exact strings.
+Type buffer_info_to_type(const py::buffer_info &info) {
+    std::string fd = info.format;
+    const int bits = (int) info.itemsize * 8;
+
+    if (!fd.empty() && (fd[0] == '@' || fd[0] == '=' || fd[0] == '<' || fd[0] == '>' || fd[0] == '!')) {
+        const uint16_t one = 1;
+        const bool host_is_little_endian = *(const uint8_t *) &one == 1;
+        const char foreign = host_is_little_endian ? '>' : '<';
+        if (fd[0] == foreign || fd[0] == '!') {
+            throw py::value_error("Buffers with non-native byte order are not supported.");
+        }
+        fd = fd.substr(1);
+    }
 
-    #undef HANDLE_BUFFER_TYPE
+    if (fd.size() == 1) {
+        switch (fd[0]) {
+        case '?':
+            return Bool();
+        case 'b': case 'h': case 'i': case 'l': case 'q': case 'n':
+            return Int(bits);
+        case 'B': case 'H': case 'I': case 'L': case 'Q': case 'N':
+            return UInt(bits);
+        case 'e': case 'f': case 'd':
+            return Float(bits);
+        }
+    }
 
-    throw py::value_error("Unsupported Buffer<> type.");
+    throw py::value_error("Unsupported buffer format '" + info.format + "'.");
     return Type();
 }
 
-
 py::object buffer_getitem_operator(Buffer<> &buf, const std::vector<int> &pos) {
     if ((size_t) pos.size() != (size_t) buf.dimensions()) {
         throw py::value_error("Incorrect number of dimensions.");
@@ -220,20 +230,28 @@ py::object buffer_setitem_operator(Buffer<> &buf, const std::vector<int> &pos, p
 class PyBuffer : public Buffer<> {
     py::buffer_info info;
 
+    // Describe the buffer's memory exactly as-is (including arbitrary and
+    // negative strides), so that we never need to copy it.
     static std::vector<halide_dimension_t> make_dim_vec(const py::buffer_info &info) {
-        const Type t = format_descriptor_to_type(info.format);
         std::vector<halide_dimension_t> dims;
         dims.reserve(info.ndim);
         for (int i = 0; i < info.ndim; i++) {
-            // TODO: check for ssize_t -> int32_t overflow
-            dims.push_back({0, (int32_t) info.shape[i], (int32_t) (info.strides[i] / t.bytes())});
+            const ssize_t extent = info.shape[i];
+            const ssize_t stride = info.strides[i] / info.itemsize;
+            if (stride * info.itemsize != info.strides[i]) {
+                throw py::value_error("Buffer strides must be a multiple of the element size.");
+            }
+            if (extent != (int32_t) extent || stride != (int32_t) stride) {
+                throw py::value_error("Buffer extents and strides must fit in 32 bits.");
+            }
+            dims.push_back({0, (int32_t) extent, (int32_t) stride});
         }
         return dims;
     }
 
     PyBuffer(py::buffer_info &&info, const std::string &name)
         : Buffer<>(
-            format_descriptor_to_type(info.format),
+            buffer_info_to_type(info),
             info.ptr,
             (int) info.ndim,
             make_dim_vec(info).data(),
@@ -5,6 +5,7 @@
 #include "PyExpr.h"
 #include "PyFuncRef.h"
 #include "PyLoopLevel.h"
+#include "PyPipeline.h"
 #include "PyScheduleMethods.h"
 #include "PyStage.h"
 #include "PyTuple.h"
@@ -46,6 +47,25 @@ py::object realization_to_object(const Realization &r) {
     return to_python_tuple(r);
 }
 
+// As with Pipeline, only running the compiled code happens with the
+// GIL released. Func::pipeline() creates the Pipeline lazily, so fetch
+// it first, while we still hold the GIL.
+Pipeline pipeline_for_realize(Func &f) {
+    _halide_user_assert(f.defined()) << "Can't realize undefined Func.\n";
+    return f.pipeline();
+}
+
+py::object realize_to_object(Func &f, const std::vector<int32_t> &sizes,
+                             const Target &target, const ParamMap &param_map) {
+    Pipeline p = pipeline_for_realize(f);
+    const Target t = compile_for_realize(p, target);
+    auto realize = [&]() -> Realization {
+        py::gil_scoped_release release;
+        return p.realize(sizes, t, param_map);
+    };
+    return realization_to_object(realize());
+}
+
 }  // namespace
 
 void define_func(py::module &m) {
@@ -56,6 +76,13 @@ void define_func(py::module &m) {
     // TODO: ParamMap to its own file?
     auto param_map_class = py::class_<ParamMap>(m, "ParamMap")
         .def(py::init<>())
+        // Binding ImageParams per-call (rather than with ImageParam.set())
+        // lets several threads realize the same Func on different inputs.
+        .def("set", [](ParamMap &pm, const ImageParam &p, Buffer<> &buf) -> void {
+            pm.set(p, buf);
+        }, py::arg("p"), py::arg("buffer"),
+           py::keep_alive<1, 3>() // Keep the Buffer<> alive while the ParamMap refers to it
+        )
     ;
 
     // Deliberately not supported, because they don't seem to make sense for Python:
@@ -83,36 +110,42 @@ void define_func(py::module &m) {
         .def(py::init([](const ImageParam &im) -> Func { return im; }))
 
         .def("realize", [](Func &f, Buffer<> buffer, const Target &target, const ParamMap &param_map) -> void {
-            f.realize(buffer, target);
+            Pipeline p = pipeline_for_realize(f);
+            const Target t = compile_for_realize(p, target);
+            py::gil_scoped_release release;
+            p.realize(buffer, t, param_map);
         }, py::arg("dst"), py::arg("target") = Target(), py::arg("param_map") = ParamMap())
 
         // This will actually allow a list-of-buffers as well as a tuple-of-buffers, but that's OK.
-        .def("realize", [](Func &f, std::vector<Buffer<>> buffers, const Target &t, const ParamMap &param_map) -> void {
-            f.realize(Realization(buffers), t);
+        .def("realize", [](Func &f, std::vector<Buffer<>> buffers, const Target &target, const ParamMap &param_map) -> void {
+            Pipeline p = pipeline_for_realize(f);
+            const Target t = compile_for_realize(p, target);
+            py::gil_scoped_release release;
+            p.realize(Realization(buffers), t, param_map);
         }, py::arg("dst"), py::arg("target") = Target(), py::arg("param_map") = ParamMap())
 
         .def("realize", [](Func &f, std::vector<int32_t> sizes, const Target &target, const ParamMap &param_map) -> py::object {
-            return realization_to_object(f.realize(sizes, target, param_map));
+            return realize_to_object(f, sizes, target, param_map);
         }, py::arg("sizes") = std::vector<int32_t>{}, py::arg("target") = Target(), py::arg("param_map") = ParamMap())
 
         // TODO: deprecate in favor of std::vector<int32_t> size version?
         .def("realize", [](Func &f, int x_size, const Target &target, const ParamMap &param_map) -> py::object {
-            return realization_to_object(f.realize(x_size, target, param_map));
+            return realize_to_object(f, {x_size}, target, param_map);
         }, py::arg("x_size"), py::arg("target") = Target(), py::arg("param_map") = ParamMap())
 
         // TODO: deprecate in favor of std::vector<int32_t> size version?
         .def("realize", [](Func &f, int x_size, int y_size, const Target &target, const ParamMap &param_map) -> py::object {
-            return realization_to_object(f.realize(x_size, y_size, target, param_map));
+            return realize_to_object(f, {x_size, y_size}, target, param_map);
         }, py::arg("x_size"), py::arg("y_size"), py::arg("target") = Target(), py::arg("param_map") = ParamMap())
 
         // TODO: deprecate in favor of std::vector<int32_t> size version?
         .def("realize", [](Func &f, int x_size, int y_size, int z_size, const Target &target, const ParamMap &param_map) -> py::object {
-            return realization_to_object(f.realize(x_size, y_size, z_size, target, param_map));
+            return realize_to_object(f, {x_size, y_size, z_size}, target, param_map);
         }, py::arg("x_size"), py::arg("y_size"), py::arg("z_size"), py::arg("target") = Target(), py::arg("param_map") = ParamMap())
 
         // TODO: deprecate in favor of std::vector<int32_t> size version?
         .def("realize", [](Func &f, int x_size, int y_size, int z_size, int w_size, const Target &target, const ParamMap &param_map) -> py::object {
-            return realization_to_object(f.realize(x_size, y_size, z_size, w_size, target, param_map));
+            return realize_to_object(f, {x_size, y_size, z_size, w_size}, target, param_map);
         }, py::arg("x_size"), py::arg("y_size"), py::arg("z_size"), py::arg("w_size"), py::arg("target") = Target(), py::arg("param_map") = ParamMap())
 
         .def("defined", &Func::defined)
@@ -213,12 +246,16 @@ void define_func(py::module &m) {
         .def("compile_to_module", &Func::compile_to_module,
             py::arg("arguments"), py::arg("fn_name") = "", py::arg("target") = get_target_from_environment())
 
-        .def("compile_jit", &Func::compile_jit, py::arg("target") = get_jit_target_from_environment())
+        .def("compile_jit", [](Func &f, const Target &target) -> void {
+            Pipeline p = pipeline_for_realize(f);
+            (void) p.compile_jit(target);
+        }, py::arg("target") = get_jit_target_from_environment())
 
         .def("has_update_definition", &Func::has_update_definition)
         .def("num_update_definitions", &Func::num_update_definitions)
 
         .def("update", &Func::update, py::arg("idx") = 0)
+        .def("parallel_reduce", &Func::parallel_reduce, py::arg("r"), py::arg("factor"))
         .def("update_args", &Func::update_args, py::arg("idx") = 0)
         .def("update_value", &Func::update_value, py::arg("idx") = 0)
         .def("update_value", &Func::update_value, py::arg("idx") = 0)
@@ -5,13 +5,18 @@ namespace PythonBindings {
 
 void define_machine_params(py::module &m) {
     auto machine_params_class = py::class_<MachineParams>(m, "MachineParams")
-        .def(py::init<int32_t, int32_t, int32_t>(),
-            py::arg("parallelism"), py::arg("last_level_cache_size"), py::arg("balance"))
+        .def(py::init<int32_t, int32_t, int32_t, int32_t, int32_t, int32_t>(),
+            py::arg("parallelism"), py::arg("last_level_cache_size"), py::arg("balance"),
+            py::arg("l1_cache_size") = 0, py::arg("l2_cache_size") = 0, py::arg("cache_line_size") = 0)
         .def(py::init<std::string>())
         .def_readwrite("parallelism", &MachineParams::parallelism)
         .def_readwrite("last_level_cache_size", &MachineParams::last_level_cache_size)
         .def_readwrite("balance", &MachineParams::balance)
+        .def_readwrite("l1_cache_size", &MachineParams::l1_cache_size)
+        .def_readwrite("l2_cache_size", &MachineParams::l2_cache_size)
+        .def_readwrite("cache_line_size", &MachineParams::cache_line_size)
         .def_static("generic", &MachineParams::generic)
+        .def_static("host", &MachineParams::host)
         .def("__str__", &MachineParams::to_string)
         .def("__repr__", [](const MachineParams &mp) -> std::string {
             std::ostringstream o;
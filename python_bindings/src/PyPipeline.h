@@ -8,6 +8,13 @@ namespace PythonBindings {
 
 void define_pipeline(py::module &m);
 
+// Lowering mutates the Funcs in a Pipeline, which other Pipelines may
+// share, so it has to happen with the GIL held. This jit-compiles the
+// Pipeline for the target that realize(target) would use, and returns
+// that target. Passing it to realize() then only runs the compiled code,
+// which is safe to do with the GIL released.
+Target compile_for_realize(Pipeline &p, const Target &target);
+
 }  // namespace PythonBindings
 }  // namespace Halide
 
@@ -14,6 +14,8 @@ void define_stage(py::module &m) {
             py::arg("preserved"))
         .def("rfactor", (Func (Stage::*)(RVar, Var)) &Stage::rfactor,
             py::arg("r"), py::arg("v"))
+        .def("parallel_reduce", &Stage::parallel_reduce,
+            py::arg("r"), py::arg("factor"))
 
         // These two variants of compute_with are specific to Stage
         .def("compute_with", (Stage &(Stage::*)(LoopLevel, const std::vector<std::pair<VarOrRVar, LoopAlignStrategy>> &)) &Stage::compute_with,
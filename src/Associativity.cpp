@@ -340,6 +340,12 @@ AssociativeOp prove_associativity(const string &f, vector<Expr> args, vector<Exp
     // For a Tuple of exprs to be associative, each element of the Tuple
     // has to be associative.
     for (int idx = exprs.size()-1; idx >= 0; --idx) {
+        // Simplifying a let may reassociate its value, so a subexpression
+        // an element uses twice (e.g. the index of an argmax, which rfactor
+        // may have lifted into a let) would no longer match the same
+        // subexpression in the other elements. Keep the lets out of the
+        // simplifier.
+        exprs[idx] = substitute_in_all_lets(exprs[idx]);
         exprs[idx] = simplify(exprs[idx]);
         exprs[idx] = common_subexpression_elimination(exprs[idx]);
         // Calling Simplify or the original expr itself might have let exprs,
@@ -361,7 +367,6 @@ AssociativeOp prove_associativity(const string &f, vector<Expr> args, vector<Exp
         // its previous values) for the purpose of computing the subgraph
         dependencies[idx].insert(idx);
 
-        exprs[idx] = common_subexpression_elimination(exprs[idx]);
         exprs[idx] = simplify(exprs[idx]);
         exprs[idx] = solve_expression(exprs[idx], op_x_names[idx]).result; // Move 'x' to the left as possible
         exprs[idx] = substitute_in_all_lets(exprs[idx]);
@@ -1,8 +1,12 @@
 #include <algorithm>
+#include <fstream>
+#include <limits>
 #include <regex>
+#include <thread>
 
 #include "AutoSchedule.h"
 #include "AutoScheduleUtils.h"
+#include "Associativity.h"
 #include "ExprUsesVar.h"
 #include "FindCalls.h"
 #include "Func.h"
@@ -1145,6 +1149,12 @@ struct Partitioner {
     // groups within the pipeline.
     Cost get_pipeline_cost();
 
+    // Return the factor by which the cost of a load is scaled when the loads
+    // are spread over a memory footprint of 'footprint' bytes. This is 1 for
+    // footprints that fit in the fastest cache and 'balance' for footprints
+    // that exceed the last-level cache.
+    Expr load_cost_factor(const Expr &footprint);
+
     // Return the maximum access stride to allocation of 'func_acc' along any
     // loop variable specified in 'vars'. Access expressions along each dimension
     // of the allocation are specified by 'acc_exprs'. The dimension bounds of the
@@ -1185,6 +1195,53 @@ struct Partitioner {
                                      const set<string> &inlines,
                                      AutoSchedule &sched);
 
+    // Describes how the update definition at the output of a group may be
+    // rfactored to expose parallelism over its outermost RVar, when its pure
+    // dimensions alone don't provide enough parallelism.
+    struct RFactorChoice {
+        // Name of the outermost RVar of the update, which is split into
+        // 'num_tasks' pieces that are reduced in parallel.
+        string rvar;
+        // Number of partial results computed in parallel.
+        int num_tasks = 0;
+        // Whether the associative operator is commutative, in which case the
+        // innermost RVar may also be rfactored to expose a vector dimension.
+        bool commutative = false;
+
+        bool defined() const { return !rvar.empty(); }
+    };
+
+    // Return the rfactor choice for the output stage of 'g', or an undefined
+    // choice if rfactoring is not possible or not worthwhile.
+    RFactorChoice find_rfactor_choice(const Group &g);
+
+    // Apply the rfactor choice 'rf' to the output stage of 'g' and append the
+    // corresponding schedule to 'sched'.
+    void rfactor_stage(const Group &g, Stage f_handle, const RFactorChoice &rf,
+                       const Target &t, map<string, Expr> &estimates,
+                       AutoSchedule &sched);
+
+    // Estimate the benefit of fusing the loop nests of stages 'a' and 'b',
+    // which don't depend on each other, via compute_with. Without fusion, the
+    // second of the two stages reloads the producers they share from wherever
+    // those fit in the memory hierarchy; with fusion those loads hit in the
+    // fastest cache. Return an undefined Expr if the benefit can't be estimated.
+    Expr estimate_fusion_benefit(const FStage &a, const FStage &b,
+                                 const set<string> &inlines);
+
+    // Return pairs (parent, child) of group outputs where 'child' should be
+    // computed with 'parent'. This needs the stage bounds, so it must be
+    // called before any schedules are applied to the group outputs.
+    vector<pair<Function, Function>> find_fusion_candidates(const set<string> &inlines);
+
+    // Return the innermost loop of the scheduled stage 0 of 'parent' at which
+    // 'child' may be computed with it, or an empty string if there is none.
+    string find_fuse_var(const Function &parent, const Function &child);
+
+    // Apply compute_with to the pairs returned by find_fusion_candidates()
+    // and append the corresponding schedules to 'sched'.
+    void fuse_groups(const vector<pair<Function, Function>> &fusions, AutoSchedule &sched);
+
     // Split the dimension of stage 'f_handle' along 'v' into inner and outer
     // dimensions. Modify 'estimates' according to the split and append the split
     // schedule to 'sched'.
@@ -1926,6 +1983,18 @@ Partitioner::GroupAnalysis Partitioner::analyze_group(const Group &g, bool show_
 
     Cost per_tile_cost(group_cost.arith, make_zero(Int(64)));
 
+    // If the group output is a reduction that will be rfactored, the partial
+    // reductions run in parallel, at the expense of having to merge the
+    // partial results at the end.
+    RFactorChoice rf = find_rfactor_choice(g);
+    if (rf.defined()) {
+        parallelism *= rf.num_tasks;
+        Expr out_size = box_size(out_tile_extent);
+        if (out_size.defined()) {
+            per_tile_cost.arith += out_size * rf.num_tasks;
+        }
+    }
+
     // This is the old cost model; keeping it here for reference, for now.
     /*
     if (tile_inter_size > arch_params.l1_size) {
@@ -1943,21 +2012,20 @@ Partitioner::GroupAnalysis Partitioner::analyze_group(const Group &g, bool show_
                                      tile_cost.second);
     }*/
 
-    // TODO: Use smooth step curve from Jon to better model cache behavior,
-    // where each step corresponds to different cache level.
-    //
-    // The current cost model drops off linearly. Larger memory footprint is
-    // penalized more than smaller memory footprint (since smaller one can fit
-    // more in the cache). The cost is clamped at 'balance', which is roughly at
-    // memory footprint equal to or larger than the last level cache size.
+    // The cost of a load grows with the memory footprint it is accessing
+    // (see load_cost_factor). Larger memory footprint is penalized more than
+    // smaller memory footprint (since smaller one can fit more in the cache).
+    // The cost is clamped at 'balance', which is roughly at memory footprint
+    // equal to or larger than the last level cache size.
 
     // If 'model_reuse' is set, the cost model should take into account memory
     // reuse within the tile, e.g. matrix multiply reuses inputs multiple times.
     // TODO: Implement a better reuse model.
     bool model_reuse = false;
 
-    // Linear dropoff
-    Expr load_slope = cast<float>(arch_params.balance) / arch_params.last_level_cache_size;
+    // Footprints are measured in whole cache lines if the line size is known.
+    const Expr &line = arch_params.cache_line_size;
+
     for (const auto &f_load : group_load_costs) {
         internal_assert(g.inlined.find(f_load.first) == g.inlined.end())
             << "Intermediates of inlined pure fuction \"" << f_load.first
@@ -1973,7 +2041,7 @@ Partitioner::GroupAnalysis Partitioner::analyze_group(const Group &g, bool show_
         // the loads could be from any random locations of the allocated regions.
 
         if (!is_output && is_group_member) {
-            footprint = costs.region_size(f_load.first, alloc_reg);
+            footprint = costs.region_size(f_load.first, alloc_reg, line);
         } else {
             Expr initial_footprint;
             const auto &f_load_pipeline_bounds = get_element(pipeline_bounds, f_load.first);
@@ -1981,26 +2049,25 @@ Partitioner::GroupAnalysis Partitioner::analyze_group(const Group &g, bool show_
             bool is_function = (dep_analysis.env.find(f_load.first) != dep_analysis.env.end());
             if (!is_function) { // It is a load to some input buffer
                 // Initial loads
-                initial_footprint = costs.input_region_size(f_load.first, f_load_pipeline_bounds);
+                initial_footprint = costs.input_region_size(f_load.first, f_load_pipeline_bounds, line);
                 // Subsequent loads
-                footprint = costs.input_region_size(f_load.first, alloc_reg);
+                footprint = costs.input_region_size(f_load.first, alloc_reg, line);
             } else if (is_output) { // Load to the output function of the group
                 internal_assert(is_group_member)
                     << "Output " << f_load.first << " should have been a group member\n";
                 // Initial loads
-                initial_footprint = costs.region_size(f_load.first, f_load_pipeline_bounds);
+                initial_footprint = costs.region_size(f_load.first, f_load_pipeline_bounds, line);
                 // Subsequent loads
-                footprint = costs.region_size(f_load.first, out_tile_extent);
+                footprint = costs.region_size(f_load.first, out_tile_extent, line);
             } else { // Load to some non-member function (i.e. function from other groups)
                 // Initial loads
-                initial_footprint = costs.region_size(f_load.first, f_load_pipeline_bounds);
+                initial_footprint = costs.region_size(f_load.first, f_load_pipeline_bounds, line);
                 // Subsequent loads
-                footprint = costs.region_size(f_load.first, alloc_reg);
+                footprint = costs.region_size(f_load.first, alloc_reg, line);
             }
 
             if (model_reuse) {
-                Expr initial_factor =
-                    cast<int64_t>(min(1 + initial_footprint * load_slope, arch_params.balance));
+                Expr initial_factor = load_cost_factor(initial_footprint);
                 per_tile_cost.memory += initial_factor * footprint;
             } else {
                 footprint = initial_footprint;
@@ -2011,7 +2078,7 @@ Partitioner::GroupAnalysis Partitioner::analyze_group(const Group &g, bool show_
             }
         }
 
-        Expr cost_factor = cast<int64_t>(min(1 + footprint * load_slope, arch_params.balance));
+        Expr cost_factor = load_cost_factor(footprint);
         per_tile_cost.memory += cost_factor * f_load.second;
     }
 
@@ -2034,6 +2101,51 @@ Partitioner::GroupAnalysis Partitioner::analyze_group(const Group &g, bool show_
     return g_analysis;
 }
 
+Expr Partitioner::load_cost_factor(const Expr &footprint) {
+    const Expr &balance = arch_params.balance;
+    const Expr &llc = arch_params.last_level_cache_size;
+
+    // Collect the capacities of the cache levels we know about, smallest
+    // first. Levels that are unknown (zero) or not smaller than the next
+    // level up are ignored.
+    vector<Expr> levels;
+    for (const Expr &size : {arch_params.l1_cache_size, arch_params.l2_cache_size}) {
+        if (size.defined() && !is_zero(size) && can_prove(size < llc) &&
+            (levels.empty() || can_prove(levels.back() < size))) {
+            levels.push_back(size);
+        }
+    }
+
+    const int64_t *balance_val = as_const_int(balance);
+    if (levels.empty() || !balance_val) {
+        // Only the last level cache is modeled; the cost drops off
+        // linearly from 1 to 'balance' as the footprint approaches the
+        // last-level cache size.
+        Expr load_slope = cast<float>(balance) / llc;
+        return cast<int64_t>(min(1 + footprint * load_slope, balance));
+    }
+    levels.push_back(llc);
+
+    // Each cache level contributes a linear ramp in cost between the
+    // capacity of the level below it and its own capacity. The cost
+    // once a level overflows is spaced geometrically between 1 (an L1
+    // hit) and 'balance' (a miss in the last-level cache), which
+    // roughly matches the latencies of real memory hierarchies.
+    Expr factor = make_const(Float(32), 1.0f);
+    Expr prev_size = make_zero(Int(64));
+    double prev_cost = 1.0;
+    for (size_t i = 0; i < levels.size(); i++) {
+        double cost = std::pow((double)*balance_val, (double)(i + 1) / levels.size());
+        Expr size = cast<int64_t>(levels[i]);
+        Expr span = simplify(size - prev_size);
+        Expr covered = clamp(cast<int64_t>(footprint) - prev_size, make_zero(Int(64)), span);
+        factor += cast<float>(covered) * (float)(cost - prev_cost) / cast<float>(span);
+        prev_size = size;
+        prev_cost = cost;
+    }
+    return cast<int64_t>(min(factor, cast<float>(balance)));
+}
+
 Partitioner::Group Partitioner::merge_groups(const Group &prod_group,
                                              const Group &cons_group) {
     vector<FStage> group_members;
@@ -2343,6 +2455,159 @@ bool access_inputs_or_outputs(Definition def, VarOrRVar var,
     return false;
 }
 
+Partitioner::RFactorChoice Partitioner::find_rfactor_choice(const Group &g) {
+    // Each partial result must reduce over at least this many iterations of
+    // the split RVar, so that the cost of merging the partial results stays
+    // small compared to the work done by the reduction itself.
+    const int min_rvar_extent_per_task = 16;
+
+    RFactorChoice rf;
+    const FStage &stg = g.output;
+    if ((stg.stage_num == 0) || stg.func.has_extern_definition()) {
+        return rf;
+    }
+
+    // The members of the group would be computed at tiles of the merge
+    // stage rather than of the rfactored intermediate, so only consider
+    // groups that contain nothing but the reduction itself.
+    for (const FStage &mem : g.members) {
+        if ((mem.func.name() != stg.func.name()) &&
+            (g.inlined.find(mem.func.name()) == g.inlined.end())) {
+            return rf;
+        }
+    }
+
+    const int64_t *machine_par = as_const_int(arch_params.parallelism);
+    if (!machine_par) {
+        return rf;
+    }
+
+    Definition def = get_stage_definition(stg.func, stg.stage_num);
+    const vector<Dim> &dims = def.schedule().dims();
+    map<string, Expr> estimates = bounds_to_estimates(get_bounds(stg));
+
+    // Compute the parallelism available from the pure dimensions, and find
+    // the outermost RVar.
+    int64_t pure_par = 1;
+    string outer_rvar;
+    for (int d = 0; d < (int)dims.size() - 1; d++) {
+        string var = get_base_name(dims[d].var);
+        const auto &iter = estimates.find(var);
+        if ((iter == estimates.end()) || !iter->second.defined()) {
+            return rf;
+        }
+        const int64_t *extent = as_const_int(iter->second);
+        if (!extent) {
+            return rf;
+        }
+        if (dims[d].is_rvar()) {
+            if (can_parallelize_rvar(var, stg.func.name(), def)) {
+                // The reduction is already parallelizable without rfactor
+                return rf;
+            }
+            outer_rvar = var;
+        } else {
+            pure_par *= *extent;
+        }
+    }
+    if (outer_rvar.empty() || (pure_par >= *machine_par)) {
+        return rf;
+    }
+
+    int num_tasks = (int)((*machine_par + pure_par - 1) / pure_par);
+    const int64_t *rvar_extent = as_const_int(get_element(estimates, outer_rvar));
+    if ((num_tasks < 2) || (*rvar_extent < num_tasks * min_rvar_extent_per_task)) {
+        return rf;
+    }
+
+    AssociativeOp prover_result =
+        prove_associativity(stg.func.name(), def.args(), def.values());
+    if (!prover_result.associative()) {
+        return rf;
+    }
+
+    rf.rvar = outer_rvar;
+    rf.num_tasks = num_tasks;
+    rf.commutative = prover_result.commutative();
+    return rf;
+}
+
+void Partitioner::rfactor_stage(const Group &g, Stage f_handle, const RFactorChoice &rf,
+                                const Target &t, map<string, Expr> &estimates,
+                                AutoSchedule &sched) {
+    int stage_num = g.output.stage_num;
+    Definition def = get_stage_definition(g.output.func, stage_num);
+    const vector<Dim> &dims = def.schedule().dims();
+
+    int vec_len = 0;
+    for (const auto &type : g.output.func.output_types()) {
+        vec_len = std::max(vec_len, t.natural_vector_size(type));
+    }
+
+    // If the operator is commutative, we can also rfactor a vector's worth of
+    // the innermost RVar, so that the partial reductions vectorize.
+    string inner_rvar;
+    if (rf.commutative && dims[0].is_rvar()) {
+        inner_rvar = get_base_name(dims[0].var);
+        const int64_t *extent = as_const_int(get_element(estimates, inner_rvar));
+        if (!extent || (*extent < 2 * vec_len)) {
+            inner_rvar = "";
+        }
+    }
+
+    // Split the outermost RVar into one piece per task. If it is also the
+    // innermost RVar, make sure each piece is a multiple of the vector size.
+    const int64_t *outer_extent = as_const_int(get_element(estimates, rf.rvar));
+    internal_assert(outer_extent);
+    int64_t factor = (*outer_extent + rf.num_tasks - 1) / rf.num_tasks;
+    if (inner_rvar == rf.rvar) {
+        factor = ((factor + vec_len - 1) / vec_len) * vec_len;
+    }
+    pair<VarOrRVar, VarOrRVar> par_split =
+        split_dim(g, f_handle, stage_num, def, true, VarOrRVar(rf.rvar, true),
+                  (int)factor, "_i", "_o", estimates, sched);
+    if (inner_rvar == rf.rvar) {
+        inner_rvar = par_split.first.name();
+    }
+
+    vector<pair<RVar, Var>> preserved;
+    std::ostringstream preserved_ss;
+
+    string par_var = par_split.second.name() + "_par";
+    sched.internal_vars.emplace(par_var, VarOrRVar(par_var, false));
+    preserved.emplace_back(RVar(par_split.second.name()), Var(par_var));
+    preserved_ss << "{" << par_split.second.name() << ", " << par_var << "}";
+
+    string vec_var;
+    if (!inner_rvar.empty()) {
+        pair<VarOrRVar, VarOrRVar> vec_split =
+            split_dim(g, f_handle, stage_num, def, true, VarOrRVar(inner_rvar, true),
+                      vec_len, "_vi", "_vo", estimates, sched);
+        vec_var = vec_split.first.name() + "_vec";
+        sched.internal_vars.emplace(vec_var, VarOrRVar(vec_var, false));
+        preserved.emplace_back(RVar(vec_split.first.name()), Var(vec_var));
+        preserved_ss << ", {" << vec_split.first.name() << ", " << vec_var << "}";
+    }
+
+    Func intm = f_handle.rfactor(preserved);
+    intm.compute_root();
+    Stage intm_update = intm.update(0);
+    std::ostringstream oss;
+    oss << "rfactor({" << preserved_ss.str() << "})"
+        << ".compute_root()"
+        << ".update(0)";
+    if (!vec_var.empty()) {
+        intm_update.vectorize(Var(vec_var));
+        oss << ".vectorize(" << vec_var << ")";
+    }
+    intm_update.parallel(Var(par_var));
+    oss << ".parallel(" << par_var << ")";
+
+    // The directives chained after rfactor() apply to the intermediate
+    // Func, so this must be the last schedule pushed for this stage.
+    sched.push_schedule(f_handle.name(), stage_num, oss.str(), {});
+}
+
 pair<VarOrRVar, VarOrRVar> Partitioner::split_dim(
         const Group &g, Stage f_handle, int stage_num, Definition def,
         bool is_group_output, VarOrRVar v, const Expr &factor, string in_suffix,
@@ -2680,6 +2945,15 @@ void Partitioner::generate_group_cpu_schedule(
         sched.push_schedule(f_handle.name(), g.output.stage_num, "compute_root()", {});
     }
 
+    // If the group output is a reduction that doesn't have enough parallelism
+    // in its pure dimensions, rfactor it instead. The remaining merge stage
+    // is small, so it is left serial.
+    RFactorChoice rf = find_rfactor_choice(g);
+    if (rf.defined()) {
+        rfactor_stage(g, f_handle, rf, t, stg_estimates, sched);
+        return;
+    }
+
     // Realize tiling and update the dimension estimates
     vector<VarOrRVar> outer_dims;
     vector<VarOrRVar> inner_dims;
@@ -2925,11 +3199,156 @@ void Partitioner::generate_cpu_schedule(const Target &t, AutoSchedule &sched) {
     // Since the default schedule is compute inline, we don't need to
     // explicitly call compute_inline() on the function.
 
+    // Decide which sibling groups to fuse before any of the group outputs are
+    // scheduled, since the cost estimates rely on their original dimensions.
+    vector<pair<Function, Function>> fusions = find_fusion_candidates(inlines);
+
     // Realize schedule for each group in the pipeline.
     for (const auto &g : groups) {
         generate_group_cpu_schedule(g.second, t, get_element(loop_bounds, g.first),
                                     get_element(storage_bounds, g.first), inlines, sched);
     }
+
+    fuse_groups(fusions, sched);
+}
+
+Expr Partitioner::estimate_fusion_benefit(const FStage &a, const FStage &b,
+                                          const set<string> &inlines) {
+    DimBounds a_bounds = get_bounds(a);
+    DimBounds b_bounds = get_bounds(b);
+    map<string, Expr> a_loads =
+        costs.stage_detailed_load_costs(a.func.name(), a.stage_num, a_bounds, inlines);
+    map<string, Expr> b_loads =
+        costs.stage_detailed_load_costs(b.func.name(), b.stage_num, b_bounds, inlines);
+
+    Expr benefit = make_zero(Int(64));
+    for (const auto &load : b_loads) {
+        if ((load.first == b.func.name()) || (a_loads.find(load.first) == a_loads.end())) {
+            continue;
+        }
+        const Box &region = get_element(pipeline_bounds, load.first);
+        bool is_function = (dep_analysis.env.find(load.first) != dep_analysis.env.end());
+        Expr size = is_function ?
+            costs.region_size(load.first, region, arch_params.cache_line_size) :
+            costs.input_region_size(load.first, region, arch_params.cache_line_size);
+        if (!size.defined() || !load.second.defined()) {
+            return Expr();
+        }
+        benefit += (load_cost_factor(size) - 1) * load.second;
+    }
+    return simplify(benefit);
+}
+
+vector<pair<Function, Function>> Partitioner::find_fusion_candidates(const set<string> &inlines) {
+    // Only consider pure, single-stage group outputs. These are all computed
+    // at root.
+    vector<FStage> stages;
+    map<string, map<string, Function>> callees;
+    for (const auto &g : groups) {
+        const FStage &out = g.second.output;
+        if ((out.stage_num != 0) || !out.func.updates().empty() ||
+            out.func.has_extern_definition()) {
+            continue;
+        }
+        stages.push_back(out);
+        callees.emplace(out.func.name(), find_transitive_calls(out.func));
+    }
+
+    auto depends_on = [&callees](const string &a, const string &b) {
+        const map<string, Function> &calls = get_element(callees, a);
+        return calls.find(b) != calls.end();
+    };
+
+    // Greedily fuse each stage with the first earlier stage it benefits
+    // from being fused with. All the stages fused together must be
+    // independent of each other.
+    vector<pair<Function, Function>> fusions;
+    vector<bool> is_child(stages.size(), false);
+    for (size_t i = 0; i < stages.size(); i++) {
+        if (is_child[i]) {
+            continue;
+        }
+        vector<string> fused = {stages[i].func.name()};
+        for (size_t j = i + 1; j < stages.size(); j++) {
+            if (is_child[j]) {
+                continue;
+            }
+            const string &name = stages[j].func.name();
+            bool independent = true;
+            for (const string &other : fused) {
+                if (depends_on(name, other) || depends_on(other, name)) {
+                    independent = false;
+                    break;
+                }
+            }
+            if (!independent) {
+                continue;
+            }
+
+            Expr benefit = estimate_fusion_benefit(stages[i], stages[j], inlines);
+            debug(3) << "Fusion benefit of " << stages[j] << " with " << stages[i]
+                     << ": " << benefit << '\n';
+            if (benefit.defined() && can_prove(benefit > 0)) {
+                fusions.emplace_back(stages[i].func, stages[j].func);
+                fused.push_back(name);
+                is_child[j] = true;
+            }
+        }
+    }
+    return fusions;
+}
+
+string Partitioner::find_fuse_var(const Function &parent, const Function &child) {
+    // Loops at which other Funcs are computed can't be fused past, since
+    // those Funcs would then be computed inside the fused loop nest.
+    set<string> compute_at_vars;
+    for (const auto &iter : dep_analysis.env) {
+        LoopLevel level = iter.second.schedule().compute_level();
+        level.lock();
+        if (!level.is_inlined() && !level.is_root() &&
+            ((level.func() == parent.name()) || (level.func() == child.name()))) {
+            compute_at_vars.insert(level.var().name());
+        }
+    }
+
+    const vector<Dim> &p_dims = get_stage_dims(parent, 0);
+    const vector<Dim> &c_dims = get_stage_dims(child, 0);
+
+    // Walk the loops of both stages from the outside in (ignoring
+    // __outermost), for as long as they match.
+    string fuse_var;
+    int p = (int)p_dims.size() - 2, c = (int)c_dims.size() - 2;
+    for (; (p >= 0) && (c >= 0); p--, c--) {
+        const Dim &pd = p_dims[p];
+        const Dim &cd = c_dims[c];
+        if ((pd.var != cd.var) || (pd.for_type != cd.for_type) ||
+            (pd.dim_type != cd.dim_type) ||
+            ((pd.for_type != ForType::Serial) && (pd.for_type != ForType::Parallel))) {
+            break;
+        }
+        fuse_var = get_base_name(pd.var);
+        if (compute_at_vars.count(fuse_var)) {
+            break;
+        }
+    }
+    return fuse_var;
+}
+
+void Partitioner::fuse_groups(const vector<pair<Function, Function>> &fusions,
+                              AutoSchedule &sched) {
+    for (const auto &fusion : fusions) {
+        const Function &parent = fusion.first;
+        const Function &child = fusion.second;
+        string var = find_fuse_var(parent, child);
+        if (var.empty()) {
+            continue;
+        }
+        Func(child).compute_with(Func(parent), Var(var));
+        string sanitized_parent = get_sanitized_name(parent.name());
+        sched.push_schedule(child.name(), 0,
+                            "compute_with(" + sanitized_parent + ", " + var + ")",
+                            {sanitized_parent, var});
+    }
 }
 
 Expr Partitioner::find_max_access_stride(const Scope<> &vars,
@@ -3551,21 +3970,123 @@ MachineParams MachineParams::generic() {
     return MachineParams(16, 16 * 1024 * 1024, 40);
 }
 
+namespace {
+
+// Read a single line from a sysfs file. Returns the empty string on failure.
+std::string read_sysfs_line(const std::string &path) {
+    std::ifstream f(path);
+    std::string line;
+    if (f.is_open()) {
+        std::getline(f, line);
+    }
+    return line;
+}
+
+// Parse a sysfs cache size such as "32K" or "8192K" into bytes.
+int64_t parse_sysfs_size(const std::string &s) {
+    if (s.empty()) {
+        return 0;
+    }
+    char *end = nullptr;
+    int64_t size = strtoll(s.c_str(), &end, 10);
+    if (*end == 'K') {
+        size *= 1024;
+    } else if (*end == 'M') {
+        size *= 1024 * 1024;
+    } else if (*end == 'G') {
+        size *= 1024 * 1024 * 1024;
+    }
+    return size;
+}
+
+}  // namespace
+
+MachineParams MachineParams::host() {
+    MachineParams params = generic();
+
+    int parallelism = (int)std::thread::hardware_concurrency();
+    if (parallelism > 0) {
+        params.parallelism = parallelism;
+    }
+
+#ifdef __linux__
+    int64_t l1 = 0, l2 = 0, llc = 0, line = 0;
+    int llc_level = 0;
+    for (int i = 0; ; i++) {
+        std::string dir = "/sys/devices/system/cpu/cpu0/cache/index" + std::to_string(i) + "/";
+        std::string level_str = read_sysfs_line(dir + "level");
+        if (level_str.empty()) {
+            break;
+        }
+        std::string type = read_sysfs_line(dir + "type");
+        if (type == "Instruction") {
+            continue;
+        }
+        int level = Internal::string_to_int(level_str);
+        int64_t size = parse_sysfs_size(read_sysfs_line(dir + "size"));
+        if (level == 1) {
+            l1 = size;
+        } else if (level == 2) {
+            l2 = size;
+        }
+        if (level >= llc_level) {
+            llc_level = level;
+            llc = size;
+        }
+        std::string line_str = read_sysfs_line(dir + "coherency_line_size");
+        if (!line_str.empty()) {
+            line = std::max(line, (int64_t)Internal::string_to_int(line_str));
+        }
+    }
+    // Expr constants are 32-bit, which is plenty for any cache size.
+    const int64_t max_size = std::numeric_limits<int32_t>::max();
+    if (llc > 0) {
+        params.last_level_cache_size = (int)std::min(llc, max_size);
+    }
+    if (llc_level > 1) {
+        params.l1_cache_size = (int)std::min(l1, max_size);
+    }
+    if (llc_level > 2) {
+        params.l2_cache_size = (int)std::min(l2, max_size);
+    }
+    params.cache_line_size = (int)line;
+#endif
+
+    return params;
+}
+
 std::string MachineParams::to_string() const {
     internal_assert(parallelism.type().is_int() &&
                     last_level_cache_size.type().is_int() &&
-                    balance.type().is_int());
+                    balance.type().is_int() &&
+                    l1_cache_size.type().is_int() &&
+                    l2_cache_size.type().is_int() &&
+                    cache_line_size.type().is_int());
     std::ostringstream o;
     o << parallelism << "," << last_level_cache_size << "," << balance;
+    // Only emit the cache hierarchy if some of it is known, so that the
+    // canonical form of generic parameters doesn't change.
+    if (!is_zero(l1_cache_size) || !is_zero(l2_cache_size) || !is_zero(cache_line_size)) {
+        o << "," << l1_cache_size << "," << l2_cache_size << "," << cache_line_size;
+    }
     return o.str();
 }
 
 MachineParams::MachineParams(const std::string &s) {
     std::vector<std::string> v = Internal::split_string(s, ",");
-    user_assert(v.size() == 3) << "Unable to parse MachineParams: " << s;
+    user_assert(v.size() == 3 || v.size() == 6) << "Unable to parse MachineParams: " << s;
     parallelism = Internal::string_to_int(v[0]);
     last_level_cache_size = Internal::string_to_int(v[1]);
     balance = Internal::string_to_int(v[2]);
+    if (v.size() == 6) {
+        l1_cache_size = Internal::string_to_int(v[3]);
+        l2_cache_size = Internal::string_to_int(v[4]);
+        cache_line_size = Internal::string_to_int(v[5]);
+    } else {
+        l1_cache_size = 0;
+        l2_cache_size = 0;
+        cache_line_size = 0;
+    }
 }
 
 }  // namespace Halide
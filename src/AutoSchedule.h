@@ -16,22 +16,38 @@ namespace Halide {
 struct MachineParams {
     /** Maximum level of parallelism avalaible. */
     Expr parallelism;
-    /** Size of the last-level cache (in KB). */
+    /** Size of the last-level cache (in bytes). */
     Expr last_level_cache_size;
     /** Indicates how much more expensive is the cost of a load compared to
      * the cost of an arithmetic operation at last level cache. */
     Expr balance;
+    /** Sizes of the per-core L1 data cache and L2 cache (in bytes). Zero
+     * means unknown, in which case the cost model only considers the
+     * last-level cache. */
+    Expr l1_cache_size, l2_cache_size;
+    /** Size of a cache line (in bytes). Zero means unknown, in which case
+     * memory footprints are not rounded up to whole cache lines. */
+    Expr cache_line_size;
 
-    explicit MachineParams(int32_t parallelism, int32_t llc, int32_t balance)
-        : parallelism(parallelism), last_level_cache_size(llc), balance(balance) {}
+    explicit MachineParams(int32_t parallelism, int32_t llc, int32_t balance,
+                           int32_t l1 = 0, int32_t l2 = 0, int32_t cache_line = 0)
+        : parallelism(parallelism), last_level_cache_size(llc), balance(balance),
+          l1_cache_size(l1), l2_cache_size(l2), cache_line_size(cache_line) {}
 
     /** Default machine parameters for generic CPU architecture. */
     static MachineParams generic();
 
+    /** Machine parameters for the host CPU. The cache hierarchy and the
+     * number of cores are detected from sysfs on Linux; anything that
+     * can't be detected falls back to the values in generic(). */
+    static MachineParams host();
+
     /** Convert the MachineParams into canonical string form. */
     std::string to_string() const;
 
-    /** Reconstruct a MachineParams from canonical string form. */
+    /** Reconstruct a MachineParams from canonical string form. Accepts
+     * either "parallelism,llc,balance" or
+     * "parallelism,llc,balance,l1,l2,cache_line". */
     explicit MachineParams(const std::string &s);
 };
 
@@ -402,6 +402,7 @@ public:
     HALIDE_BUFFER_FORWARD(device_wrap_native)
     HALIDE_BUFFER_FORWARD(device_detach_native)
     HALIDE_BUFFER_FORWARD(allocate)
+    HALIDE_BUFFER_FORWARD(adopt_host)
     HALIDE_BUFFER_FORWARD(deallocate)
     HALIDE_BUFFER_FORWARD(device_deallocate)
     HALIDE_BUFFER_FORWARD(device_free)
@@ -434,6 +435,34 @@ public:
         return *this;
     }
 
+    template<typename Fn, typename ...Args>
+    Buffer<T> &for_each_value_parallel(Fn &&f, Args... other_buffers) {
+        get()->for_each_value_parallel(std::forward<Fn>(f), (*std::forward<Args>(other_buffers).get())...);
+        return *this;
+    }
+
+    template<typename Fn, typename ...Args>
+    const Buffer<T> &for_each_value_parallel(Fn &&f, Args... other_buffers) const {
+        get()->for_each_value_parallel(std::forward<Fn>(f), (*std::forward<Args>(other_buffers).get())...);
+        return *this;
+    }
+
+    template<typename Fn>
+    Buffer<T> &for_each_element_parallel(Fn &&f) {
+        get()->for_each_element_parallel(std::forward<Fn>(f));
+        return *this;
+    }
+
+    template<typename Fn>
+    const Buffer<T> &for_each_element_parallel(Fn &&f) const {
+        get()->for_each_element_parallel(std::forward<Fn>(f));
+        return *this;
+    }
+
+    static halide_do_par_for_t set_parallel_for(halide_do_par_for_t fn) {
+        return Runtime::Buffer<T>::set_parallel_for(fn);
+    }
+
     template<typename FnOrValue>
     Buffer<T> &fill(FnOrValue &&f) {
         get()->fill(std::forward<FnOrValue>(f));
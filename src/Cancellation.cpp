@@ -0,0 +1,78 @@
+#include "Cancellation.h"
+#include "IRMutator.h"
+#include "IROperator.h"
+#include "IRVisitor.h"
+
+namespace Halide {
+namespace Internal {
+
+namespace {
+
+class ContainsLoop : public IRVisitor {
+    using IRVisitor::visit;
+    void visit(const For *op) override {
+        result = true;
+    }
+public:
+    bool result = false;
+};
+
+bool contains_loop(Stmt s) {
+    ContainsLoop c;
+    s.accept(&c);
+    return c.result;
+}
+
+class InjectCancellationChecks : public IRMutator2 {
+    using IRMutator2::visit;
+
+    // The number of loops we're inside of.
+    int loop_depth = 0;
+
+    Stmt check_cancelled() {
+        // The runtime fills in the user_context.
+        Expr cancelled = Call::make(Int(32), "halide_cancelled", {}, Call::Extern);
+        std::string name = unique_name("cancelled");
+        Expr var = Variable::make(Int(32), name);
+        return LetStmt::make(name, cancelled, AssertStmt::make(var == 0, var));
+    }
+
+    Stmt visit(const For *op) override {
+        if ((op->device_api != DeviceAPI::None &&
+             op->device_api != DeviceAPI::Host) ||
+            op->for_type == ForType::GPUBlock ||
+            op->for_type == ForType::GPUThread ||
+            op->for_type == ForType::GPULane) {
+            // The runtime isn't available on devices.
+            return op;
+        }
+
+        loop_depth++;
+        Stmt body = mutate(op->body);
+        loop_depth--;
+
+        // Each task of a parallel loop checks before it starts. Serial
+        // loops only check if they're outermost, and not innermost,
+        // so that the check is cheap compared to an iteration.
+        if (op->for_type == ForType::Parallel ||
+            (op->for_type == ForType::Serial && loop_depth == 0 && contains_loop(op->body))) {
+            body = Block::make(check_cancelled(), body);
+        }
+
+        if (body.same_as(op->body)) {
+            return op;
+        } else {
+            return For::make(op->name, op->min, op->extent,
+                             op->for_type, op->device_api, body);
+        }
+    }
+};
+
+}  // namespace
+
+Stmt inject_cancellation_checks(Stmt s) {
+    return InjectCancellationChecks().mutate(s);
+}
+
+}  // namespace Internal
+}  // namespace Halide
@@ -0,0 +1,24 @@
+#ifndef HALIDE_CANCELLATION_H
+#define HALIDE_CANCELLATION_H
+
+/** \file
+ * Defines the lowering pass that injects polls of halide_cancelled,
+ * for Target::Cancellable.
+ */
+
+#include "IR.h"
+
+namespace Halide {
+namespace Internal {
+
+/** Inject a check of halide_cancelled at the start of the body of
+ * each parallel loop, and at the start of each iteration of the
+ * outermost serial loops that contain other loops. If it returns
+ * nonzero, the pipeline (or parallel task) returns that value. Loops
+ * that run on a device are left alone. */
+Stmt inject_cancellation_checks(Stmt s);
+
+}  // namespace Internal
+}  // namespace Halide
+
+#endif
@@ -200,10 +200,14 @@ public:
         IRGraphVisitor::include(e);
     }
 
-    // GCC's __builtin_shuffle takes an integer vector of
-    // the size of its input vector. Make sure this type exists.
+    // Shuffles of multiple vectors concatenate them first. Make
+    // sure the type of the concatenation exists.
     void visit(const Shuffle *op) override {
-        vector_types_used.insert(Int(32, op->vectors[0].type().lanes()));
+        Type t = op->vectors[0].type();
+        if (t.is_bool()) {
+            t = UInt(8, t.lanes());
+        }
+        vector_types_used.insert(t.with_lanes(t.lanes() * op->vectors.size()));
         IRGraphVisitor::visit(op);
     }
 
@@ -515,7 +519,10 @@ public:
         }
     }
 
-    static Vec shuffle(const Vec &a, const int32_t indices[Lanes]) {
+    template<typename InputVec, int... Indices>
+    static Vec shuffle(const InputVec &a) {
+        static_assert(sizeof...(Indices) == Lanes, "shuffle with incorrect number of indices");
+        const int32_t indices[Lanes] = { Indices... };
         Vec r(empty);
         for (size_t i = 0; i < Lanes; i++) {
             if (indices[i] < 0) {
@@ -842,6 +849,23 @@ private:
 
         const char *native_vector_decl = R"INLINE_CODE(
 #if __has_attribute(ext_vector_type) || __has_attribute(vector_size)
+
+// Whether the ?: operator can be applied to native vectors, which lets
+// select, min and max compile to blend/min/max instructions.
+#if __clang__
+    #define halide_cpp_native_vector_ternary (__clang_major__ >= 15)
+#elif __GNUC__
+    #define halide_cpp_native_vector_ternary (__GNUC__ >= 5)
+#else
+    #define halide_cpp_native_vector_ternary 0
+#endif
+
+template <size_t Bytes> struct halide_cpp_uint_of_size;
+template <> struct halide_cpp_uint_of_size<1> { typedef uint8_t type; };
+template <> struct halide_cpp_uint_of_size<2> { typedef uint16_t type; };
+template <> struct halide_cpp_uint_of_size<4> { typedef uint32_t type; };
+template <> struct halide_cpp_uint_of_size<8> { typedef uint64_t type; };
+
 template <typename ElementType_, size_t Lanes_>
 class NativeVector {
 public:
@@ -915,24 +939,18 @@ public:
         }
     }
 
-    // TODO: this should be improved by taking advantage of native operator support.
-    static Vec shuffle(const Vec &a, const int32_t indices[Lanes]) {
-        Vec r(empty);
-        for (size_t i = 0; i < Lanes; i++) {
-            if (indices[i] < 0) {
-                continue;
-            }
-            r.native_vector[i] = a[indices[i]];
-        }
-        return r;
+    template<typename InputVec, int... Indices>
+    static Vec shuffle(const InputVec &a) {
+        static_assert(sizeof...(Indices) == Lanes, "shuffle with incorrect number of indices");
+        return shuffle_impl<Indices...>(a);
     }
 
-    // TODO: this should be improved by taking advantage of native operator support.
     template<size_t InputLanes>
     static Vec concat(size_t count, const NativeVector<ElementType, InputLanes> vecs[]) {
         Vec r(empty);
-        for (size_t i = 0; i < Lanes; i++) {
-            r.native_vector[i] = vecs[i / InputLanes][i % InputLanes];
+        for (size_t i = 0; i < count; i++) {
+            memcpy((ElementType *)&r.native_vector + i * InputLanes, &vecs[i].native_vector,
+                   InputLanes * sizeof(ElementType));
         }
         return r;
     }
@@ -1036,67 +1054,93 @@ public:
         return Vec(from_native_vector, a | b.native_vector);
     }
 
-    // TODO: this should be improved by taking advantage of native operator support.
     friend Mask operator<(const Vec &a, const Vec &b) {
+#if __has_builtin(__builtin_convertvector)
+        return to_mask(a.native_vector < b.native_vector);
+#else
         Mask r;
         for (size_t i = 0; i < Lanes; i++) {
             r.native_vector[i] = a[i] < b[i] ? 0xff : 0x00;
         }
         return r;
+#endif
     }
 
-    // TODO: this should be improved by taking advantage of native operator support.
     friend Mask operator<=(const Vec &a, const Vec &b) {
+#if __has_builtin(__builtin_convertvector)
+        return to_mask(a.native_vector <= b.native_vector);
+#else
         Mask r;
         for (size_t i = 0; i < Lanes; i++) {
             r.native_vector[i] = a[i] <= b[i] ? 0xff : 0x00;
         }
         return r;
+#endif
     }
 
-    // TODO: this should be improved by taking advantage of native operator support.
     friend Mask operator>(const Vec &a, const Vec &b) {
+#if __has_builtin(__builtin_convertvector)
+        return to_mask(a.native_vector > b.native_vector);
+#else
         Mask r;
         for (size_t i = 0; i < Lanes; i++) {
             r.native_vector[i] = a[i] > b[i] ? 0xff : 0x00;
         }
         return r;
+#endif
     }
 
-    // TODO: this should be improved by taking advantage of native operator support.
     friend Mask operator>=(const Vec &a, const Vec &b) {
+#if __has_builtin(__builtin_convertvector)
+        return to_mask(a.native_vector >= b.native_vector);
+#else
         Mask r;
         for (size_t i = 0; i < Lanes; i++) {
             r.native_vector[i] = a[i] >= b[i] ? 0xff : 0x00;
         }
         return r;
+#endif
     }
 
-    // TODO: this should be improved by taking advantage of native operator support.
     friend Mask operator==(const Vec &a, const Vec &b) {
+#if __has_builtin(__builtin_convertvector)
+        return to_mask(a.native_vector == b.native_vector);
+#else
         Mask r;
         for (size_t i = 0; i < Lanes; i++) {
             r.native_vector[i] = a[i] == b[i] ? 0xff : 0x00;
         }
         return r;
+#endif
     }
 
-    // TODO: this should be improved by taking advantage of native operator support.
     friend Mask operator!=(const Vec &a, const Vec &b) {
+#if __has_builtin(__builtin_convertvector)
+        return to_mask(a.native_vector != b.native_vector);
+#else
         Mask r;
         for (size_t i = 0; i < Lanes; i++) {
             r.native_vector[i] = a[i] != b[i] ? 0xff : 0x00;
         }
         return r;
+#endif
     }
 
-    // TODO: this should be improved by taking advantage of native operator support.
     static Vec select(const Mask &cond, const Vec &true_value, const Vec &false_value) {
+#if __has_builtin(__builtin_convertvector) && halide_cpp_native_vector_ternary
+        // Widen the mask to the element size, so that it can be used as
+        // the condition of a native vector ?:.
+        typedef typename halide_cpp_uint_of_size<sizeof(ElementType)>::type MaskElementType;
+        typedef typename NativeVector<MaskElementType, Lanes>::NativeVectorType WideMask;
+        WideMask wide_cond = __builtin_convertvector(cond.native_vector, WideMask);
+        return Vec(from_native_vector, (wide_cond != 0) ? true_value.native_vector : false_value.native_vector);
+#else
         Vec r(empty);
         for (size_t i = 0; i < Lanes; i++) {
             r.native_vector[i] = cond[i] ? true_value[i] : false_value[i];
         }
         return r;
+#endif
     }
 
     template <typename OtherVec>
@@ -1104,37 +1148,45 @@ public:
         #if __cplusplus >= 201103L
         static_assert(Vec::Lanes == OtherVec::Lanes, "Lanes mismatch");
         #endif
-#if 0 // __has_builtin(__builtin_convertvector)
-        // Disabled (for now) because __builtin_convertvector appears to have
-        // different float->int rounding behavior in at least some situations;
-        // for now we'll use the much-slower-but-correct explicit C++ code.
+#if __has_builtin(__builtin_convertvector)
+        // __builtin_convertvector appears to have different float->int
+        // rounding behavior in at least some situations, so only use it
+        // when the source is an integer type, and use the
+        // much-slower-but-correct explicit C++ code otherwise.
         // (https://github.com/halide/Halide/issues/2080)
-        return Vec(from_native_vector, __builtin_convertvector(src.native_vector, NativeVectorType));
-#else
+        if ((typename OtherVec::ElementType)0.5 == 0) {
+            return Vec(from_native_vector, __builtin_convertvector(src.native_vector, NativeVectorType));
+        }
+#endif
         Vec r(empty);
         for (size_t i = 0; i < Lanes; i++) {
             r.native_vector[i] = static_cast<typename Vec::ElementType>(src.native_vector[i]);
         }
         return r;
-#endif
     }
 
-    // TODO: this should be improved by taking advantage of native operator support.
     static Vec max(const Vec &a, const Vec &b) {
+#if halide_cpp_native_vector_ternary
+        return Vec(from_native_vector, (a.native_vector > b.native_vector) ? a.native_vector : b.native_vector);
+#else
         Vec r(empty);
         for (size_t i = 0; i < Lanes; i++) {
             r.native_vector[i] = ::halide_cpp_max(a[i], b[i]);
         }
         return r;
+#endif
     }
 
-    // TODO: this should be improved by taking advantage of native operator support.
     static Vec min(const Vec &a, const Vec &b) {
+#if halide_cpp_native_vector_ternary
+        return Vec(from_native_vector, (a.native_vector < b.native_vector) ? a.native_vector : b.native_vector);
+#else
         Vec r(empty);
         for (size_t i = 0; i < Lanes; i++) {
             r.native_vector[i] = ::halide_cpp_min(a[i], b[i]);
         }
         return r;
+#endif
     }
 
 private:
@@ -1151,6 +1203,37 @@ private:
     inline NativeVector(FromNativeVector, const NativeVectorType &src) {
         native_vector = src;
     }
+
+    // The input of a shuffle may be a CppVector if its width isn't
+    // supported natively.
+    template<int... Indices, typename InputVec>
+    static Vec shuffle_impl(const InputVec &a) {
+        const int32_t indices[Lanes] = { Indices... };
+        Vec r(empty);
+        for (size_t i = 0; i < Lanes; i++) {
+            if (indices[i] < 0) {
+                continue;
+            }
+            r.native_vector[i] = a[indices[i]];
+        }
+        return r;
+    }
+
+#if __has_builtin(__builtin_shufflevector)
+    template<int... Indices, size_t InputLanes>
+    static Vec shuffle_impl(const NativeVector<ElementType, InputLanes> &a) {
+        return Vec(from_native_vector, __builtin_shufflevector(a.native_vector, a.native_vector, Indices...));
+    }
+#endif
+
+#if __has_builtin(__builtin_convertvector)
+    // Narrow the all-ones/all-zeros lanes produced by a native vector
+    // comparison to a Mask.
+    template <typename ComparisonType>
+    static Mask to_mask(const ComparisonType &cmp) {
+        return Mask(Mask::from_native_vector, __builtin_convertvector(cmp, typename Mask::NativeVectorType));
+    }
+#endif
 };
 #endif  // __has_attribute(ext_vector_type) || __has_attribute(vector_size)
 
@@ -2685,6 +2768,9 @@ void CodeGen_C::visit(const Shuffle *op) {
         internal_assert(i >= -1 && i < max_index);
     }
 
+    // The type of the concatenation of all the input vectors.
+    Type src_type = op->vectors[0].type().with_lanes(max_index);
+
     std::vector<string> vecs;
     for (Expr v : op->vectors) {
         vecs.push_back(print_expr(v));
@@ -2696,17 +2782,17 @@ void CodeGen_C::visit(const Shuffle *op) {
         do_indent();
         stream << "const " << print_type(op->vectors[0].type()) << " " << storage_name << "[] = { " << with_commas(vecs) << " };\n";
 
-        rhs << print_type(op->type) << "::concat(" << op->vectors.size() << ", " << storage_name << ")";
-        src = print_assignment(op->type, rhs.str());
+        rhs << print_type(src_type) << "::concat(" << op->vectors.size() << ", " << storage_name << ")";
+        src = print_assignment(src_type, rhs.str());
     }
     ostringstream rhs;
     if (op->type.is_scalar()) {
         rhs << src << "[" << op->indices[0] << "]";
     } else {
-        string indices_name = unique_name('_');
-        do_indent();
-        stream << "const int32_t " << indices_name << "[" << op->indices.size() << "] = { " << with_commas(op->indices) << " };\n";
-        rhs << print_type(op->type) << "::shuffle(" << src << ", " << indices_name << ")";
+        // The indices are template arguments, so that native vectors can
+        // use them as the immediate operands of __builtin_shufflevector.
+        rhs << print_type(op->type) << "::shuffle<" << print_type(src_type) << ", "
+            << with_commas(op->indices) << ">(" << src << ")";
     }
     print_assignment(op->type, rhs.str());
 }
@@ -140,6 +140,7 @@ llvm::Type *llvm_type_of(LLVMContext *c, Halide::Type t) {
 bool function_takes_user_context(const std::string &name) {
     static const char *user_context_runtime_funcs[] = {
         "halide_buffer_copy",
+        "halide_cancelled",
         "halide_copy_to_host",
         "halide_copy_to_device",
         "halide_current_time_ns",
@@ -153,6 +154,7 @@ bool function_takes_user_context(const std::string &name) {
         "halide_device_and_host_malloc",
         "halide_device_sync",
         "halide_do_par_for",
+        "halide_do_loop_par_for",
         "halide_do_loop_task",
         "halide_do_task",
         "halide_do_async_consumer",
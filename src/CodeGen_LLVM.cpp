@@ -3174,8 +3174,6 @@ void CodeGen_LLVM::do_parallel_tasks(const vector<ParallelTask> &tasks) {
     // Make space on the stack for the tasks
     llvm::Value *task_stack_ptr = create_alloca_at_entry(parallel_task_t_type, num_tasks);
 
-    llvm::Type *args_t[] = {i8_t->getPointerTo(), i32_t, i8_t->getPointerTo()};
-    FunctionType *task_t = FunctionType::get(i32_t, args_t, false);
     llvm::Type *loop_args_t[] = {i8_t->getPointerTo(), i32_t, i32_t, i8_t->getPointerTo(), i8_t->getPointerTo()};
     FunctionType *loop_task_t = FunctionType::get(i32_t, loop_args_t, false);
 
@@ -3295,10 +3293,11 @@ void CodeGen_LLVM::do_parallel_tasks(const vector<ParallelTask> &tasks) {
         MinThreads min_threads;
         t.body.accept(&min_threads);
 
-        // Decide if we're going to call do_par_for or
-        // do_parallel_tasks. halide_do_par_for is simpler, but
+        // Decide if we're going to call do_loop_par_for or
+        // do_parallel_tasks. halide_do_loop_par_for is simpler, but
         // assumes a bunch of things. Programs that don't use async
-        // can also enter the task system via do_par_for.
+        // can also enter the task system via do_loop_par_for, which
+        // hands the task a slice of the loop at a time.
         Value *task_parent = sym_get("__task_parent", false);
         bool use_do_par_for = (
             num_tasks == 1 &&
@@ -3324,20 +3323,17 @@ void CodeGen_LLVM::do_parallel_tasks(const vector<ParallelTask> &tasks) {
             semaphores = ConstantPointerNull::get(semaphore_acquire_t_type->getPointerTo());
         }
 
-        FunctionType *fn_type = use_do_par_for ? task_t : loop_task_t;
-        int closure_arg_idx = use_do_par_for ? 2 : 3;
-
         // Make a new function that does the body
         llvm::Function *containing_function = function;
-        function = llvm::Function::Create(fn_type, llvm::Function::InternalLinkage,
+        function = llvm::Function::Create(loop_task_t, llvm::Function::InternalLinkage,
                                           t.name, module.get());
 
-        llvm::Value *task_ptr = builder->CreatePointerCast(function, fn_type->getPointerTo());
+        llvm::Value *task_ptr = builder->CreatePointerCast(function, loop_task_t->getPointerTo());
 
         #if LLVM_VERSION < 50
-        function->setDoesNotAlias(closure_arg_idx + 1);
+        function->setDoesNotAlias(4);
         #else
-        function->addParamAttr(closure_arg_idx, Attribute::NoAlias);
+        function->addParamAttr(3, Attribute::NoAlias);
         #endif
 
         set_function_attributes_for_target(function, target);
@@ -3364,11 +3360,7 @@ void CodeGen_LLVM::do_parallel_tasks(const vector<ParallelTask> &tasks) {
         llvm::Function::arg_iterator iter = function->arg_begin();
         sym_push("__user_context", iterator_to_pointer(iter));
 
-        if (use_do_par_for) {
-            // Next is the loop variable.
-            ++iter;
-            sym_push(t.loop_var, iterator_to_pointer(iter));
-        } else if (!t.loop_var.empty()) {
+        if (!t.loop_var.empty()) {
             // We peeled off a loop. Wrap a new loop around the body
             // that just does the slice given by the arguments.
             string loop_min_name = unique_name('t');
@@ -3389,8 +3381,7 @@ void CodeGen_LLVM::do_parallel_tasks(const vector<ParallelTask> &tasks) {
             ++iter;
         }
 
-        // The closure pointer is either the last (for halide_do_par_for) or
-        // second to last argument (for halide_do_parallel_tasks).
+        // The closure pointer is the second to last argument.
         ++iter;
         iter->setName("closure");
         Value *closure_handle = builder->CreatePointerCast(iterator_to_pointer(iter),
@@ -3401,7 +3392,9 @@ void CodeGen_LLVM::do_parallel_tasks(const vector<ParallelTask> &tasks) {
 
         if (!use_do_par_for) {
             // For halide_do_parallel_tasks the threading runtime task parent
-            // is the last argument.
+            // is the last argument. Tasks run by halide_do_loop_par_for
+            // ignore it, so that the loops inside them can in turn go
+            // through halide_do_loop_par_for.
             ++iter;
             iter->setName("task_parent");
             sym_push("__task_parent", iterator_to_pointer(iter));
@@ -3428,16 +3421,16 @@ void CodeGen_LLVM::do_parallel_tasks(const vector<ParallelTask> &tasks) {
         Value *serial = codegen(cast(UInt(8), t.serial));
 
         if (use_do_par_for) {
-            llvm::Function *do_par_for = module->getFunction("halide_do_par_for");
-            internal_assert(do_par_for) << "Could not find halide_do_par_for in initial module\n";
+            llvm::Function *do_loop_par_for = module->getFunction("halide_do_loop_par_for");
+            internal_assert(do_loop_par_for) << "Could not find halide_do_loop_par_for in initial module\n";
             #if LLVM_VERSION < 50
-            do_par_for->setDoesNotAlias(5);
+            do_loop_par_for->setDoesNotAlias(5);
             #else
-            do_par_for->addParamAttr(4, Attribute::NoAlias);
+            do_loop_par_for->addParamAttr(4, Attribute::NoAlias);
             #endif
             Value *args[] = {get_user_context(), task_ptr, min, extent, closure_ptr};
-            debug(4) << "Creating call to do_par_for\n";
-            result = builder->CreateCall(do_par_for, args);
+            debug(4) << "Creating call to do_loop_par_for\n";
+            result = builder->CreateCall(do_loop_par_for, args);
         } else {
             // Populate the task struct
             Value *slot_ptr = builder->CreateConstGEP2_32(parallel_task_t_type, task_stack_ptr, i, 0);
@@ -590,6 +590,67 @@ Func Stage::rfactor(RVar r, Var v) {
     return rfactor({{r, v}});
 }
 
+Func Stage::parallel_reduce(RVar r, int factor) {
+    user_assert(!definition.is_init()) << "parallel_reduce() must be called on an update definition\n";
+    user_assert(factor > 0) << "In schedule for " << name()
+                            << ", parallel_reduce() requires a positive factor\n";
+    user_assert(factor <= (1 << 16)) << "In schedule for " << name()
+                                     << ", parallel_reduce() can't make more than 65536 partial results\n";
+    Expr extent = r.extent();
+    user_assert(extent.defined())
+        << "In schedule for " << name() << ", can't perform parallel_reduce() on " << r.name()
+        << " since it is not an RVar of an RDom\n";
+
+    // Split the domain into 2^levels contiguous slices, and the index
+    // of the slice into one bit per level, outermost first. Each bit is
+    // rfactored out into a Func with twice as many partial results as
+    // the one above it, so the last Func holds one partial result per
+    // slice, and the ones above it merge them pairwise.
+    int levels = 0;
+    while ((1 << levels) < factor) {
+        levels++;
+    }
+    RVar slice(unique_name(r.name() + "_slice")), slice_inner(unique_name(r.name() + "_inner"));
+    Expr slice_size = max((extent + ((1 << levels) - 1)) / (1 << levels), 1);
+    split(r, slice, slice_inner, slice_size, TailStrategy::GuardWithIf);
+    vector<RVar> bits;
+    for (int i = levels - 1; i > 0; i--) {
+        RVar bit(unique_name(r.name() + "_bit")), rest(unique_name(r.name() + "_rest"));
+        split(slice, bit, rest, 1 << i, TailStrategy::GuardWithIf);
+        bits.push_back(bit);
+        slice = rest;
+    }
+    bits.push_back(slice);
+
+    vector<Func> tree;
+    vector<Var> partial_vars;
+    for (const RVar &bit : bits) {
+        Var v(unique_name(r.name() + "_partial"));
+        Stage s = tree.empty() ? *this : tree.back().update(0);
+        tree.push_back(s.rfactor(bit, v));
+        partial_vars.push_back(v);
+    }
+
+    // Every level is computed in parallel over its partial results.
+    for (size_t i = 0; i + 1 < tree.size(); i++) {
+        tree[i].compute_root();
+        for (size_t j = 0; j <= i; j++) {
+            tree[i].parallel(partial_vars[j]).update(0).parallel(partial_vars[j]);
+        }
+    }
+
+    // Each task of the last level accumulates its slice into storage of
+    // its own, and writes its partial result out once at the end.
+    Func partials = tree.back();
+    Func task_partials = partials.in();
+    task_partials.compute_root();
+    for (const Var &v : partial_vars) {
+        task_partials.parallel(v);
+    }
+    partials.compute_at(task_partials, partial_vars[0]);
+    return partials;
+}
+
 Func Stage::rfactor(vector<pair<RVar, Var>> preserved) {
     user_assert(!definition.is_init()) << "rfactor() must be called on an update definition\n";
 
@@ -2002,6 +2063,17 @@ Func &Func::async() {
     return *this;
 }
 
+Func &Func::ring_buffer(Expr extent) {
+    invalidate_cache();
+    user_assert(extent.defined() && extent.type().is_int())
+        << "The extent passed to ring_buffer() for Func " << name() << " must be an integer\n";
+    const int64_t *depth = as_const_int(extent);
+    user_assert(!depth || *depth >= 1)
+        << "The extent passed to ring_buffer() for Func " << name() << " must be at least one\n";
+    func.schedule().ring_buffer() = extent;
+    return *this;
+}
+
 Stage Func::specialize(Expr c) {
     invalidate_cache();
     return Stage(func, func.definition(), 0, args()).specialize(c);
@@ -2493,6 +2565,20 @@ Stage Func::update(int idx) {
     return Stage(func, func.update(idx), idx+1, args());
 }
 
+Func Func::parallel_reduce(RVar r, int factor) {
+    // Find the update definition that reduces over r.
+    for (int i = num_update_definitions() - 1; i >= 0; i--) {
+        for (const ReductionVariable &rv : func.update(i).schedule().rvars()) {
+            if (var_name_match(rv.var, r.name())) {
+                return update(i).parallel_reduce(r, factor);
+            }
+        }
+    }
+    user_error << "In schedule for " << name() << ", can't perform parallel_reduce() on "
+               << r.name() << " since no update definition reduces over it\n";
+    return Func();
+}
+
 Func::operator Stage() const {
     user_assert(!func.has_extern_definition())
         << "Extern func \"" << name() << "\" cannot be converted into Stage\n";
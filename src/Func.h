@@ -182,6 +182,28 @@ public:
     Func rfactor(RVar r, Var v);
     // @}
 
+    /** Parallelize an associative reduction over the RVar r. The
+     * domain of r is split into 'factor' contiguous slices (rounded up
+     * to a power of two), and each slice is reduced into a partial
+     * result by its own parallel task, in storage local to that task.
+     * The partial results are then merged pairwise by a tree of
+     * log2(factor) Funcs, each computed in parallel, so neither the
+     * reduction nor the merge has a serial loop longer than a slice.
+     *
+     * Each level of the tree is made with rfactor, so it is an error
+     * if the update can't be proven to be associative. Its operator
+     * need not be commutative: partial results are always merged in
+     * order. r must be an RVar of an RDom, not one created by
+     * splitting one. All the slices are the same size, so bounds
+     * inference rounds the domain of r up to a whole number of slices
+     * per partial result: whatever the update reads must be defined
+     * there (e.g. by reading its inputs through a boundary
+     * condition), although it is never evaluated past the end of r.
+     *
+     * Returns the Func holding the partial result of each slice,
+     * which can be scheduled further (e.g. to vectorize it). */
+    Func parallel_reduce(RVar r, int factor);
+
     /** Schedule the iteration over this stage to be fused with another
      * stage 's' from outermost loop to a given LoopLevel. 'this' stage will
      * be computed AFTER 's' in the innermost fused dimension. There should not
@@ -1014,9 +1036,15 @@ public:
      * fails, we may skip over other tasks, and if two tasks return
      * different error codes, we may select one arbitrarily to return.
      *
+     * Without a custom do_par_for or do_task, parallel loops are
+     * handed to the thread pool through halide_do_loop_par_for, which
+     * runs slices of the loop at a time. Setting either of them makes
+     * parallel loops run one iteration per task instead.
+     *
      * If you are statically compiling, you can also just define your
      * own version of the above function, and it will clobber Halide's
-     * version.
+     * version. In that case, also define halide_do_loop_par_for (see
+     * HalideRuntime.h), which is what compiled pipelines call.
      */
     void set_custom_do_par_for(
         int (*custom_do_par_for)(void *, int (*)(void *, int, uint8_t *), int,
@@ -1089,7 +1117,18 @@ public:
      * 5, uint32_t = 6, int32_t = 7, uint64_t = 8, int64_t = 9. The
      * data follows the header, as a densely packed array of the given
      * size and the given type. If given the extension .tmp, this file
-     * format can be natively read by the program ImageStack. */
+     * format can be natively read by the program ImageStack.
+     *
+     * If the filename has ".lz4" appended (e.g. "foo.tmp.lz4"), the
+     * file is compressed as an LZ4 frame, which can be decompressed
+     * with the lz4 command-line tool, and .tmp.lz4 files can be read
+     * with Halide::Tools::load_image.
+     *
+     * By default the file is written before the pipeline continues.
+     * To write it on a background thread instead, call
+     * halide_set_debug_to_file_async(1) or set the environment
+     * variable HL_DEBUG_TO_FILE_ASYNC=1, and call
+     * halide_debug_to_file_wait before reading the files. */
     void debug_to_file(const std::string &filename);
 
     /** The name of this function, either given during construction,
@@ -2120,10 +2159,10 @@ public:
      * production is complete. If this Func's store level is different
      * to its compute level, consumers will be run concurrently,
      * blocking as necessary to prevent reading ahead of what the
-     * producer has computed. If storage is folded, then the producer
-     * will additionally not be permitted to run too far ahead of the
-     * consumer, to avoid clobbering data that has not yet been
-     * used.
+     * producer has computed. If storage is folded (or ring-buffered,
+     * see \ref Func::ring_buffer), then the producer will additionally
+     * not be permitted to run too far ahead of the consumer, to avoid
+     * clobbering data that has not yet been used.
      *
      * Take special care when combining this with custom thread pool
      * implementations, as avoiding deadlock with producer-consumer
@@ -2134,6 +2173,33 @@ public:
      */
     Func &async();
 
+    /** Give an async() Func an N-deep ring of copies of its storage,
+     * so that its producer can run up to extent iterations ahead of
+     * its consumers (of the loop it is computed at) without
+     * clobbering values they have yet to read. The producer blocks
+     * when all the copies are in use. This requires the Func to be
+     * stored outside the loop it is computed at, and multiplies the
+     * memory it uses by extent.
+     *
+     * This is for producers that write the same region on every
+     * iteration, e.g. an extern stage that decodes successive frames
+     * of a video into one buffer. If the region written instead
+     * moves with the loop, use \ref Func::fold_storage, which lets
+     * an async producer run ahead in the same way without the extra
+     * memory. For example:
+     *
+     \code
+     Func decoded, consumer;
+     decoded.define_extern("decode_next_frame", {}, UInt(8), 2);
+     consumer(x, y, t) = f(decoded(x, y));
+     decoded.compute_at(consumer, t).store_root().async().ring_buffer(3);
+     \endcode
+     *
+     * Lets decode_next_frame run up to two frames ahead of the
+     * consumer.
+     */
+    Func &ring_buffer(Expr extent);
+
     /** Allocate storage for this function within f's loop over
      * var. Scheduling storage is optional, and can be used to
      * separate the loop level at which storage occurs from the loop
@@ -2274,6 +2340,10 @@ public:
      * it. */
     Stage update(int idx = 0);
 
+    /** Parallelize the associative update definition of this Func
+     * that reduces over r. See Stage::parallel_reduce. */
+    Func parallel_reduce(RVar r, int factor);
+
     /** Set the type of memory this Func should be stored in. Controls
      * whether allocations go on the stack or the heap on the CPU, and
      * in global vs shared vs local on the GPU. See the documentation
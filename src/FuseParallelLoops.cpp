@@ -0,0 +1,204 @@
+#include "FuseParallelLoops.h"
+#include "Bounds.h"
+#include "ExprUsesVar.h"
+#include "IRMutator.h"
+#include "IROperator.h"
+#include "IRVisitor.h"
+#include "Simplify.h"
+#include "Util.h"
+
+namespace Halide {
+namespace Internal {
+
+using std::pair;
+using std::string;
+using std::vector;
+
+namespace {
+
+class ContainsAsync : public IRVisitor {
+    using IRVisitor::visit;
+    void visit(const Acquire *op) override {
+        result = true;
+    }
+    void visit(const Fork *op) override {
+        result = true;
+    }
+public:
+    bool result = false;
+};
+
+bool contains_async(Stmt s) {
+    ContainsAsync c;
+    s.accept(&c);
+    return c.result;
+}
+
+class ContainsLoad : public IRVisitor {
+    using IRVisitor::visit;
+    void visit(const Load *op) override {
+        result = true;
+    }
+public:
+    bool result = false;
+};
+
+bool contains_load(Expr e) {
+    ContainsLoad c;
+    e.accept(&c);
+    return c.result;
+}
+
+bool is_host_parallel_loop(const For *op) {
+    return (op &&
+            op->for_type == ForType::Parallel &&
+            (op->device_api == DeviceAPI::None ||
+             op->device_api == DeviceAPI::Host));
+}
+
+class FuseParallelLoops : public IRMutator2 {
+    using IRMutator2::visit;
+
+    // Track constant bounds, to skip the runtime check that the fused
+    // loop's extent fits in an Int(32) where it's known to.
+    Scope<Interval> scope;
+
+    Stmt visit(const LetStmt *op) override {
+        Interval b = find_constant_bounds(op->value, scope);
+        ScopedBinding<Interval> bind(scope, op->name, b);
+        return IRMutator2::visit(op);
+    }
+
+    Stmt visit(const For *op) override {
+        Interval min_bounds = find_constant_bounds(op->min, scope);
+        Interval max_bounds = find_constant_bounds(op->min + op->extent - 1, scope);
+        ScopedBinding<Interval> bind(scope, op->name, Interval::make_union(min_bounds, max_bounds));
+
+        Stmt body = mutate(op->body);
+
+        if (!is_host_parallel_loop(op)) {
+            if (body.same_as(op->body)) {
+                return op;
+            }
+            return For::make(op->name, op->min, op->extent,
+                             op->for_type, op->device_api, body);
+        }
+
+        // Look through any LetStmts for the inner loop. Inner loops
+        // have already been fused with the loops inside them. The
+        // LetStmts that don't depend on the outer loop variable can be
+        // lifted out of the fused loop, which also takes care of the
+        // extent of an inner loop that was itself fused. Those that
+        // load from memory stay where they are, as the loop may be
+        // what makes the load safe, or the memory may be written
+        // before the loop.
+        vector<pair<string, Expr>> outer_lets, inner_lets;
+        Scope<> let_vars;
+        Scope<Interval> let_bounds;
+        let_bounds.set_containing_scope(&scope);
+        Stmt s = body;
+        while (const LetStmt *let = s.as<LetStmt>()) {
+            let_bounds.push(let->name, find_constant_bounds(let->value, let_bounds));
+            if (expr_uses_var(let->value, op->name) ||
+                expr_uses_vars(let->value, let_vars) ||
+                contains_load(let->value)) {
+                inner_lets.push_back({let->name, let->value});
+                let_vars.push(let->name);
+            } else {
+                outer_lets.push_back({let->name, let->value});
+            }
+            s = let->body;
+        }
+        const For *inner = s.as<For>();
+
+        if (!is_host_parallel_loop(inner) ||
+            expr_uses_var(inner->min, op->name) ||
+            expr_uses_var(inner->extent, op->name) ||
+            expr_uses_vars(inner->min, let_vars) ||
+            expr_uses_vars(inner->extent, let_vars) ||
+            contains_async(inner->body)) {
+            if (body.same_as(op->body)) {
+                return op;
+            }
+            return For::make(op->name, op->min, op->extent,
+                             op->for_type, op->device_api, body);
+        }
+
+        // The fused loop variable is an Int(32). If the product of the
+        // extents can't be shown to fit in one, it's checked at
+        // runtime, unless it's known not to.
+        Expr fits;
+        if (!fused_extent_fits(op->extent, inner->extent, let_bounds)) {
+            fits = simplify(cast<int64_t>(max(op->extent, 0)) * cast<int64_t>(max(inner->extent, 0)) <=
+                            cast<int64_t>(Int(32).max()));
+            if (is_zero(fits)) {
+                if (body.same_as(op->body)) {
+                    return op;
+                }
+                return For::make(op->name, op->min, op->extent,
+                                 op->for_type, op->device_api, body);
+            }
+        }
+
+        // Name the fused loop like Func::fuse would, e.g. f.s0.z.y
+        string prefix = op->name.substr(0, op->name.rfind('.') + 1);
+        string inner_var = (starts_with(inner->name, prefix) ?
+                            inner->name.substr(prefix.size()) :
+                            inner->name.substr(inner->name.rfind('.') + 1));
+        string fused_name = op->name + "." + inner_var;
+        string inner_extent_name = fused_name + ".inner_extent";
+        Expr fused = Variable::make(Int(32), fused_name);
+        Expr inner_extent = Variable::make(Int(32), inner_extent_name);
+
+        // Recover both loop variables from the fused one, with the
+        // remaining LetStmts between them as before.
+        Stmt fused_body = LetStmt::make(inner->name, inner->min + fused % inner_extent, inner->body);
+        for (size_t i = inner_lets.size(); i > 0; i--) {
+            fused_body = LetStmt::make(inner_lets[i - 1].first, inner_lets[i - 1].second, fused_body);
+        }
+        fused_body = LetStmt::make(op->name, op->min + fused / inner_extent, fused_body);
+
+        // Empty loops have extents less than or equal to zero, and the
+        // product of two of those might not be.
+        Expr fused_extent = max(op->extent, 0) * inner_extent;
+        Stmt result = For::make(fused_name, 0, fused_extent,
+                                ForType::Parallel, op->device_api, fused_body);
+
+        // If the check fails, run the nest as it was. The LetStmts
+        // lifted out of the outer loop stay lifted out of it.
+        if (fits.defined()) {
+            Stmt nest = s;
+            for (size_t i = inner_lets.size(); i > 0; i--) {
+                nest = LetStmt::make(inner_lets[i - 1].first, inner_lets[i - 1].second, nest);
+            }
+            nest = For::make(op->name, op->min, op->extent,
+                             op->for_type, op->device_api, nest);
+            result = IfThenElse::make(fits, result, nest);
+        }
+
+        result = LetStmt::make(inner_extent_name, max(inner->extent, 0), result);
+        for (size_t i = outer_lets.size(); i > 0; i--) {
+            result = LetStmt::make(outer_lets[i - 1].first, outer_lets[i - 1].second, result);
+        }
+        return result;
+    }
+
+    // Check whether the product of the extents is known to fit in an
+    // Int(32) from their constant bounds.
+    bool fused_extent_fits(Expr outer_extent, Expr inner_extent,
+                           const Scope<Interval> &bounds) {
+        Expr product = (cast<int64_t>(max(outer_extent, 0)) *
+                        cast<int64_t>(max(inner_extent, 0)));
+        Expr bound = find_constant_bound(product, Direction::Upper, bounds);
+        return bound.defined() && can_prove(bound <= Int(32).max());
+    }
+};
+
+}  // namespace
+
+Stmt fuse_parallel_loops(Stmt s) {
+    return FuseParallelLoops().mutate(s);
+}
+
+}  // namespace Internal
+}  // namespace Halide
@@ -0,0 +1,28 @@
+#ifndef HALIDE_FUSE_PARALLEL_LOOPS_H
+#define HALIDE_FUSE_PARALLEL_LOOPS_H
+
+/** \file
+ * Defines the lowering pass that flattens nests of parallel loops
+ * into a single parallel loop.
+ */
+
+#include "IR.h"
+
+namespace Halide {
+namespace Internal {
+
+/** Replace each parallel loop whose body is just another parallel
+ * loop (perhaps under some LetStmts) with a single parallel loop over
+ * the product of their extents, so that the whole nest is one task
+ * space for the thread pool instead of one for the outer loop and
+ * another for each iteration of it. If the product of their extents
+ * can't be shown to fit in 32 bits, it's checked at runtime, and the
+ * nest runs unfused if it doesn't. Nests are left alone if the bounds
+ * of the inner loop depend on the outer one, if they run on a device,
+ * or if they contain async producers. */
+Stmt fuse_parallel_loops(Stmt s);
+
+}  // namespace Internal
+}  // namespace Halide
+
+#endif
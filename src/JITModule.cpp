@@ -545,6 +545,37 @@ int do_par_for_handler(void *context, halide_task f,
     }
 }
 
+typedef int (*halide_loop_task)(void *user_context, int, int, uint8_t *, void *);
+
+// The runtime's own halide_do_loop_par_for, which hands out slices of
+// the loop to the thread pool.
+int (*runtime_do_loop_par_for)(void *, halide_loop_task, int, int, uint8_t *) = nullptr;
+
+struct LoopTaskIteration {
+    halide_loop_task f;
+    uint8_t *closure;
+};
+
+int loop_task_iteration(void *context, int idx, uint8_t *closure) {
+    LoopTaskIteration *iteration = (LoopTaskIteration *)closure;
+    return (*iteration->f)(context, idx, 1, iteration->closure, nullptr);
+}
+
+int do_loop_par_for_handler(void *context, halide_loop_task f,
+                            int min, int size, uint8_t *closure) {
+    const JITHandlers &handlers =
+        context ? ((JITUserContext *)context)->handlers : active_handlers;
+    if (handlers.custom_do_par_for != runtime_internal_handlers.custom_do_par_for ||
+        handlers.custom_do_task != runtime_internal_handlers.custom_do_task) {
+        // There's a custom do_par_for or do_task, which only know how
+        // to run one iteration at a time.
+        LoopTaskIteration iteration = {f, closure};
+        return (*handlers.custom_do_par_for)(context, loop_task_iteration,
+                                             min, size, (uint8_t *)&iteration);
+    }
+    return (*runtime_do_loop_par_for)(context, f, min, size, closure);
+}
+
 void error_handler_handler(void *context, const char *msg) {
     if (context) {
         JITUserContext *jit_user_context = (JITUserContext *)context;
@@ -778,6 +809,9 @@ JITModule &make_module(llvm::Module *for_module, Target target,
             runtime_internal_handlers.custom_do_par_for =
                 hook_function(runtime.exports(), "halide_set_custom_do_par_for", do_par_for_handler);
 
+            runtime_do_loop_par_for =
+                hook_function(runtime.exports(), "halide_set_custom_do_loop_par_for", do_loop_par_for_handler);
+
             runtime_internal_handlers.custom_error =
                 hook_function(runtime.exports(), "halide_set_error_handler", error_handler_handler);
 
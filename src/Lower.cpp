@@ -13,6 +13,7 @@
 #include "Bounds.h"
 #include "BoundsInference.h"
 #include "CSE.h"
+#include "Cancellation.h"
 #include "CanonicalizeGPUVars.h"
 #include "Debug.h"
 #include "DebugArguments.h"
@@ -23,6 +24,7 @@
 #include "Func.h"
 #include "Function.h"
 #include "FuseGPUThreadLoops.h"
+#include "FuseParallelLoops.h"
 #include "FuzzFloatStores.h"
 #include "HexagonOffload.h"
 #include "IRMutator.h"
@@ -303,6 +305,18 @@ Module lower(const vector<Function> &output_funcs, const string &pipeline_name,
     s = inject_early_frees(s);
     debug(2) << "Lowering after injecting early frees:\n" << s << "\n\n";
 
+    debug(1) << "Fusing nested parallel loops...\n";
+    s = fuse_parallel_loops(s);
+    debug(2) << "Lowering after fusing nested parallel loops:\n" << s << "\n\n";
+
+    if (t.has_feature(Target::Cancellable)) {
+        user_assert(t.arch != Target::Hexagon)
+            << "Target feature cancellable is not supported on Hexagon.\n";
+        debug(1) << "Injecting cancellation checks...\n";
+        s = inject_cancellation_checks(s);
+        debug(2) << "Lowering after injecting cancellation checks:\n" << s << "\n\n";
+    }
+
     if (t.has_feature(Target::Profile)) {
         debug(1) << "Injecting profiling...\n";
         s = inject_profiling(s, pipeline_name);
@@ -1,4 +1,5 @@
 #include <algorithm>
+#include <mutex>
 
 #include "Argument.h"
 #include "FindCalls.h"
@@ -57,6 +58,10 @@ struct PipelineContents {
     JITModule jit_module;
     Target jit_target;
 
+    // Guards jit_module and jit_target, so that several threads can
+    // realize the same Pipeline without racing to compile it.
+    std::mutex jit_mutex;
+
     /** Clear all cached state */
     void invalidate_cache() {
         module = Module("", Target());
@@ -408,6 +413,20 @@ std::string Pipeline::generate_function_name() const {
     return name;
 }
 
+Target Pipeline::resolve_jit_target(const Target &target) {
+    user_assert(defined()) << "Pipeline is undefined\n";
+    if (target.os != Target::OSUnknown) {
+        return target;
+    }
+    std::lock_guard<std::mutex> lock(contents->jit_mutex);
+    // If we've already jit-compiled for a specific target, use that.
+    if (contents->jit_module.compiled()) {
+        return contents->jit_target;
+    }
+    // Otherwise get the target from the environment
+    return get_jit_target_from_environment();
+}
+
 void *Pipeline::compile_jit(const Target &target_arg) {
     user_assert(defined()) << "Pipeline is undefined\n";
 
@@ -417,6 +436,8 @@ void *Pipeline::compile_jit(const Target &target_arg) {
 
     debug(2) << "jit-compiling for: " << target_arg << "\n";
 
+    std::lock_guard<std::mutex> lock(contents->jit_mutex);
+
     // If we're re-jitting for the same target, we can just keep the
     // old jit module.
     if (contents->jit_target == target &&
@@ -670,8 +691,9 @@ struct JITFuncCallContext {
                           std::to_string(exit_status) +
                           " but halide_error was never called.\n");
             }
-            halide_runtime_error << output;
+            // Reset first, as halide_runtime_error may throw.
             error_buffer.end = 0;
+            halide_runtime_error << output;
         }
     }
 
@@ -851,16 +873,9 @@ void Pipeline::realize(RealizationArg outputs, const Target &t,
             << "The Buffers passed to realize must all be allocated\n";
     }
 
-    // If target is unspecified...
-    if (target.os == Target::OSUnknown) {
-        // If we've already jit-compiled for a specific target, use that.
-        if (contents->jit_module.compiled()) {
-            target = contents->jit_target;
-        } else {
-            // Otherwise get the target from the environment
-            target = get_jit_target_from_environment();
-        }
-    }
+    // If target is unspecified, use the one we last jit-compiled for,
+    // or failing that the one from the environment.
+    target = resolve_jit_target(target);
 
     // We need to make a context for calling the jitted function to
     // carry the the set of custom handlers. Here's how handlers get
@@ -956,6 +971,189 @@ void Pipeline::realize(RealizationArg outputs, const Target &t,
     jit_context.finalize(exit_status);
 }
 
+struct PreparedCallContents {
+    mutable RefCount ref_count;
+
+    // Held so that the compiled code outlives any later
+    // recompilation of the Pipeline.
+    JITModule jit_module;
+    JITModule::argv_wrapper argv_function{nullptr};
+
+    JITFuncCallContext jit_context;
+    void *user_context_storage{nullptr};
+
+    // The argument slots passed to the argv function. The inputs are
+    // filled in by prepare; the outputs are filled in on each call.
+    vector<const void *> args;
+    size_t num_inputs{0};
+
+    // Buffer inputs may be rebound between calls, so we remember
+    // which slots they occupy and re-read them on each call.
+    vector<std::pair<size_t, Parameter>> buffer_params;
+
+    // Every Parameter bound into the argument slots, including those
+    // from the ParamMap passed to prepare. The slots for scalars
+    // point into these, so they must live as long as we do.
+    vector<Parameter> params;
+
+    // The reusable output buffers.
+    std::unique_ptr<Realization> outputs;
+
+    // Only set if the target has the profile feature.
+    void (*profiler_report)(void *){nullptr};
+    void (*profiler_reset)(){nullptr};
+
+    PreparedCallContents(const JITHandlers &handlers) : jit_context(handlers) {
+        user_context_storage = &jit_context.jit_context;
+    }
+};
+
+namespace Internal {
+template<>
+RefCount &ref_count<PreparedCallContents>(const PreparedCallContents *p) {
+    return p->ref_count;
+}
+
+template<>
+void destroy<PreparedCallContents>(const PreparedCallContents *p) {
+    delete p;
+}
+}
+
+PreparedCall Pipeline::prepare(vector<int32_t> sizes, const Target &t,
+                               const ParamMap &param_map) {
+    user_assert(defined()) << "Can't prepare an undefined Pipeline\n";
+
+    Target target = resolve_jit_target(t);
+    compile_jit(target);
+
+    IntrusivePtr<PreparedCallContents> c(new PreparedCallContents(jit_handlers()));
+    {
+        std::lock_guard<std::mutex> lock(contents->jit_mutex);
+        c->jit_module = contents->jit_module;
+    }
+    c->argv_function = c->jit_module.argv_function();
+
+    vector<Buffer<>> bufs;
+    for (auto &out : contents->outputs) {
+        for (Type t : out.output_types()) {
+            bufs.emplace_back(t, sizes);
+        }
+    }
+    c->outputs.reset(new Realization(bufs));
+
+    // Do the argument binding once, using the same path as realize.
+    RealizationArg outputs(*c->outputs);
+    JITCallArgs args(contents->inferred_args.size() + outputs.size());
+    prepare_jit_call_arguments(outputs, target, param_map,
+                               &c->user_context_storage, false, args);
+    c->args.assign(args.store, args.store + args.size);
+    c->num_inputs = contents->inferred_args.size();
+
+    const bool no_param_map = &param_map == &ParamMap::empty_map();
+    for (size_t i = 0; i < contents->inferred_args.size(); i++) {
+        const InferredArgument &arg = contents->inferred_args[i];
+        if (arg.param.defined()) {
+            Buffer<> *buf_out_param = nullptr;
+            const Parameter &p = no_param_map ? arg.param : param_map.map(arg.param, buf_out_param);
+            c->params.push_back(p);
+            if (p.is_buffer()) {
+                c->buffer_params.emplace_back(i, p);
+            }
+        }
+    }
+
+    if (target.has_feature(Target::Profile)) {
+        JITModule::Symbol report_sym =
+            c->jit_module.find_symbol_by_name("halide_profiler_report");
+        JITModule::Symbol reset_sym =
+            c->jit_module.find_symbol_by_name("halide_profiler_reset");
+        if (report_sym.address && reset_sym.address) {
+            c->profiler_report = (void (*)(void *))(report_sym.address);
+            c->profiler_reset = (void (*)())(reset_sym.address);
+        }
+    }
+
+    return PreparedCall(c);
+}
+
+PreparedCall::PreparedCall() : contents(nullptr) {
+}
+
+bool PreparedCall::defined() const {
+    return contents.defined();
+}
+
+int PreparedCall::call(Pipeline::RealizationArg &outputs) {
+    user_assert(defined()) << "Can't call an undefined PreparedCall\n";
+    PreparedCallContents &c = *contents;
+
+    user_assert(c.num_inputs + outputs.size() == c.args.size())
+        << "PreparedCall expected " << c.args.size() - c.num_inputs
+        << " output buffers, but was passed " << outputs.size() << "\n";
+
+    for (const auto &b : c.buffer_params) {
+        const Buffer<> &buf = b.second.buffer();
+        c.args[b.first] = buf.defined() ? buf.raw_buffer() : nullptr;
+    }
+
+    size_t arg_index = c.num_inputs;
+    if (outputs.r) {
+        for (size_t i = 0; i < outputs.r->size(); i++) {
+            const Buffer<> &buf = (*outputs.r)[i];
+            user_assert(buf.data() != nullptr || buf.has_device_allocation())
+                << "Buffer at " << &buf << " is unallocated. "
+                << "The Buffers in a Realization passed to realize must all be allocated\n";
+            c.args[arg_index++] = buf.raw_buffer();
+        }
+    } else if (outputs.buf) {
+        user_assert(outputs.buf->host || outputs.buf->device)
+            << "Buffer at " << (void *)outputs.buf << " is unallocated. "
+            << "The Buffers passed to realize must all be allocated\n";
+        c.args[arg_index++] = outputs.buf;
+    } else {
+        for (const Buffer<> &buf : *outputs.buffer_list) {
+            user_assert(buf.data() != nullptr || buf.has_device_allocation())
+                << "Buffer at " << &buf << " is unallocated. "
+                << "The Buffers in a Realization passed to realize must all be allocated\n";
+            c.args[arg_index++] = buf.raw_buffer();
+        }
+    }
+
+    // The context is reused across calls, so drop any messages left
+    // over from an earlier one.
+    c.jit_context.error_buffer.end = 0;
+    int exit_status = c.argv_function(c.args.data());
+
+    if (c.profiler_report) {
+        c.profiler_report(&c.jit_context.jit_context);
+        c.profiler_reset();
+    }
+
+    c.jit_context.finalize(exit_status);
+    return exit_status;
+}
+
+Realization &PreparedCall::realize() {
+    user_assert(defined()) << "Can't call an undefined PreparedCall\n";
+    Realization &r = *contents->outputs;
+    Pipeline::RealizationArg arg(r);
+    call(arg);
+    for (size_t i = 0; i < r.size(); i++) {
+        r[i].copy_to_host();
+    }
+    return r;
+}
+
+void PreparedCall::realize(Pipeline::RealizationArg outputs) {
+    call(outputs);
+}
+
+Realization &PreparedCall::outputs() {
+    user_assert(defined()) << "PreparedCall is undefined\n";
+    return *contents->outputs;
+}
+
 void Pipeline::infer_input_bounds(RealizationArg outputs, const ParamMap &param_map) {
     Target target = get_jit_target_from_environment();
 
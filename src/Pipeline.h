@@ -24,6 +24,8 @@ struct Argument;
 class Func;
 struct Outputs;
 struct PipelineContents;
+struct PreparedCallContents;
+class PreparedCall;
 
 namespace Internal {
 class IRMutator2;
@@ -254,6 +256,13 @@ public:
      */
      void *compile_jit(const Target &target = get_jit_target_from_environment());
 
+    /** Return the target that realize() and prepare() jit-compile for
+     * when passed the given one: that target itself if its OS is
+     * specified, otherwise the target this Pipeline was last
+     * jit-compiled for, or failing that the target returned from
+     * Halide::get_jit_target_from_environment(). */
+    Target resolve_jit_target(const Target &target = Target());
+
     /** Set the error handler function that be called in the case of
      * runtime errors during halide pipelines. If you are compiling
      * statically, you can also just define your own function with
@@ -322,9 +331,15 @@ public:
      * fails, we may skip over other tasks, and if two tasks return
      * different error codes, we may select one arbitrarily to return.
      *
+     * Without a custom do_par_for or do_task, parallel loops are
+     * handed to the thread pool through halide_do_loop_par_for, which
+     * runs slices of the loop at a time. Setting either of them makes
+     * parallel loops run one iteration per task instead.
+     *
      * If you are statically compiling, you can also just define your
      * own version of the above function, and it will clobber Halide's
-     * version.
+     * version. In that case, also define halide_do_loop_par_for (see
+     * HalideRuntime.h), which is what compiled pipelines call.
      */
     void set_custom_do_par_for(
         int (*custom_do_par_for)(void *, int (*)(void *, int, uint8_t *), int,
@@ -406,6 +421,17 @@ public:
                         const ParamMap &param_map = ParamMap::empty_map());
     // @}
 
+    /** Compile the pipeline and bind its arguments once, returning a
+     * PreparedCall that can be invoked repeatedly with very low
+     * overhead. Scalar Params are bound by address, so values set on
+     * them after prepare() are seen by subsequent calls. ImageParams
+     * are re-read on each call. If a ParamMap is supplied, it is
+     * resolved here rather than on every call. A set of output
+     * buffers of the given size is allocated once and reused by
+     * PreparedCall::realize(). */
+    PreparedCall prepare(std::vector<int32_t> sizes = {}, const Target &target = Target(),
+                         const ParamMap &param_map = ParamMap::empty_map());
+
     /** Evaluate this Pipeline into an existing allocated buffer or
      * buffers. If the buffer is also one of the arguments to the
      * function, strange things may happen, as the pipeline isn't
@@ -453,6 +479,43 @@ private:
     std::string generate_function_name() const;
 };
 
+/** A Pipeline that has been compiled and had its arguments bound
+ * ahead of time via Pipeline::prepare. Invoking it does no heap
+ * allocation and no ParamMap or JIT cache lookups. A PreparedCall
+ * holds onto the compiled code it was made from, so rescheduling the
+ * Pipeline afterwards has no effect on it; call prepare() again to
+ * pick up the new schedule. A PreparedCall must not be invoked from
+ * more than one thread at a time. */
+class PreparedCall {
+    Internal::IntrusivePtr<PreparedCallContents> contents;
+
+    friend class Pipeline;
+    PreparedCall(Internal::IntrusivePtr<PreparedCallContents> c) : contents(c) {}
+
+    int call(Pipeline::RealizationArg &outputs);
+
+public:
+    /** Make an undefined PreparedCall object. */
+    PreparedCall();
+
+    /** Check if this PreparedCall object is defined. */
+    bool defined() const;
+
+    /** Run the pipeline into the output buffers allocated by
+     * prepare(), and return them. The same Realization is returned
+     * by every call. */
+    Realization &realize();
+
+    /** Run the pipeline into some existing allocated buffer or
+     * buffers. They must have the same types as the Pipeline
+     * outputs. As with Pipeline::realize, this does *not*
+     * automatically copy data back from the GPU. */
+    void realize(Pipeline::RealizationArg outputs);
+
+    /** The output buffers allocated by prepare(). */
+    Realization &outputs();
+};
+
 struct ExternSignature {
 private:
     Type ret_type_;       // Only meaningful if is_void_return is false; must be default value otherwise
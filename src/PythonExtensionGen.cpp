@@ -62,10 +62,6 @@ static bool can_convert(const LoweredArgument* arg) {
   if (arg->type.is_float() && arg->type.bits() != 32 && arg->type.bits() != 64) {
       return false;
   }
-  if (arg->is_buffer() && arg->type.bits() == 1) {
-      // The Python buffer API doesn't support bit arrays.
-      return false;
-  }
   if ((arg->type.is_int() || arg->type.is_uint()) &&
       arg->type.bits() != 1 &&
       arg->type.bits() != 8 && arg->type.bits() != 16 &&
@@ -105,23 +101,62 @@ std::pair<string, string> print_type(const LoweredArgument* arg) {
     }
 }
 
-void PythonExtensionGen::convert_buffer(string name, const LoweredArgument* arg) {
+static const char *type_code_name(const Type &t) {
+    if (t.is_float()) {
+        return "halide_type_float";
+    } else if (t.is_int()) {
+        return "halide_type_int";
+    } else {
+        return "halide_type_uint";
+    }
+}
+
+static const char *scalar_converter(const LoweredArgument* arg) {
+    const string c_type = print_type(arg).second;
+    if (c_type == "PyObject*") {
+        return "_convert_py_object";
+    } else if (c_type == "float") {
+        return "_convert_py_float";
+    } else if (c_type == "double") {
+        return "_convert_py_double";
+    } else if (c_type == "bool") {
+        return "_convert_py_bool";
+    } else if (c_type == "long long") {
+        return "_convert_py_long_long";
+    } else if (c_type == "unsigned long long") {
+        return "_convert_py_unsigned_long_long";
+    } else if (c_type == "int") {
+        return "_convert_py_int";
+    } else {
+        return "_convert_py_unsigned_int";
+    }
+}
+
+void PythonExtensionGen::convert_buffer(string name, const LoweredArgument* arg, const std::vector<string> &acquired) {
     assert(arg->is_buffer());
     assert(arg->dimensions);
-    dest << "    halide_buffer_t buffer_" << name << ";\n";
-    dest << "    halide_dimension_t dimensions_" << name << "[" << (int)arg->dimensions << "];\n";
     dest << "    if (_convert_py_buffer_to_halide(";
     dest << /*pyobj*/ "py_" << name << ", ";
     dest << /*dimensions*/ (int)arg->dimensions << ", ";
     dest << /*flags*/ (arg->is_output() ? "PyBUF_WRITABLE" : "0") << ", ";
+    dest << /*type_code*/ type_code_name(arg->type) << ", ";
+    dest << /*type_bits*/ arg->type.bits() << ", ";
+    dest << /*view*/ "&view_" << name << ", ";
     dest << /*dim*/ "dimensions_" << name << ", ";
     dest << /*out*/ "&buffer_" << name << ", ";
     dest << /*name*/ "\"" << name << "\"";
     dest << ") < 0) {\n";
-    dest << "        return NULL;\n";
+    release_buffers(acquired, "        ");
+    dest << "        return -1;\n";
     dest << "    }\n";
 }
 
+void PythonExtensionGen::release_buffers(const std::vector<string> &names, const string &indent) {
+    for (const string &name : names) {
+        dest << indent << "PyBuffer_Release(&view_" << name << ");\n";
+    }
+}
+
 PythonExtensionGen::PythonExtensionGen(std::ostream &dest, const std::string &header_name, Target target)
     : dest(dest), header_name(header_name), target(target) {
 }
@@ -145,94 +180,228 @@ void PythonExtensionGen::compile(const Module &module) {
 extern "C" {
 #endif
 
+/* Converts a Python object supporting the buffer protocol (e.g. a numpy
+ * array) into a halide_buffer_t that aliases its memory. The type and
+ * dimensionality the pipeline expects are known when the extension is
+ * generated, so all we do here is check the buffer against them. On
+ * success, `view` holds a reference to the exporter that must be dropped
+ * with PyBuffer_Release() once the pipeline has returned. */
 static __attribute__((unused)) int _convert_py_buffer_to_halide(
         PyObject* pyobj, int dimensions, int flags,
+        halide_type_code_t type_code, int type_bits,
+        Py_buffer* view,
         halide_dimension_t* dim,  // array of size `dimensions`
         halide_buffer_t* out, const char* name) {
-    Py_buffer buf;
-    int ret = PyObject_GetBuffer(
-      pyobj, &buf, PyBUF_FORMAT | PyBUF_STRIDED_RO | PyBUF_ANY_CONTIGUOUS | flags);
+    Py_buffer* buf = view;
+    int ret = PyObject_GetBuffer(pyobj, buf, PyBUF_FORMAT | PyBUF_STRIDES | flags);
     if (ret < 0) {
       return ret;
     }
-    if (dimensions && buf.ndim != dimensions) {
+    if (dimensions && buf->ndim != dimensions) {
       PyErr_Format(PyExc_ValueError, "Invalid argument %s: Expected %d dimensions, got %d",
-                   name, dimensions, buf.ndim);
+                   name, dimensions, buf->ndim);
+      PyBuffer_Release(buf);
       return -1;
     }
-    /* We'll get a buffer that's either:
-     * C_CONTIGUOUS (last dimension varies the fastest, i.e., has stride=1) or
-     * F_CONTIGUOUS (first dimension varies the fastest, i.e., has stride=1).
-     * The latter is preferred, since it's already in the format that Halide
-     * needs. It can can be achieved in numpy by passing order='F' during array
-     * creation. However, if we do get a C_CONTIGUOUS buffer, flip the dimensions
-     * (transpose) so we can process it without having to reallocate.
-     */
+    /* Convert struct type code. See
+     * https://docs.python.org/3/library/struct.html#module-struct */
+    const char* p = buf->format ? buf->format : "B";
+    while (*p && strchr("@<>!=", *p)) {
+        p++;  // ignore little/bit endian (and alignment)
+    }
+    halide_type_code_t code;
+    int bits = (int)buf->itemsize * 8;
+    if (*p == '?') {
+        // Halide stores bools one per byte, as numpy does.
+        code = halide_type_uint;
+        bits = 1;
+    } else if (*p == 'f' || *p == 'd') {
+        // 'f' and 'd' are float and double, respectively.
+        code = halide_type_float;
+    } else if (*p >= 'a' && *p <= 'z') {
+        // lowercase is signed int.
+        code = halide_type_int;
+    } else {
+        // uppercase is unsigned int.
+        code = halide_type_uint;
+    }
+    const char* type_codes = "bB?hHiIlLqQnNfd";  // integers and floats
+    if (!*p || !strchr(type_codes, *p) || p[1] != '\0' ||
+        code != type_code || bits != type_bits ||
+        (bits == 1 && buf->itemsize != 1)) {
+        // We don't handle 's' and 'p' (char[]) and 'P' (void*)
+        if (type_bits == 1) {
+            PyErr_Format(PyExc_ValueError,
+                         "Invalid data type for %s: %s with itemsize %d, expected bool",
+                         name, buf->format ? buf->format : "B", (int)buf->itemsize);
+        } else {
+            PyErr_Format(PyExc_ValueError,
+                         "Invalid data type for %s: %s with itemsize %d, expected %s%d",
+                         name, buf->format ? buf->format : "B", (int)buf->itemsize,
+                         type_code == halide_type_float ? "float" :
+                         type_code == halide_type_int ? "int" : "uint", type_bits);
+        }
+        PyBuffer_Release(buf);
+        return -1;
+    }
+    /* Halide's dimension 0 is the one that varies fastest, as it is in a
+     * Fortran-ordered (order='F') numpy array, so those are used as-is.
+     * Anything else is assumed to be indexed like a C-ordered array (the
+     * numpy default), and its dimensions are flipped (transposed) so we
+     * can process it without having to reallocate. Non-contiguous buffers
+     * (e.g. strided or reversed numpy views) are passed through the same
+     * way, ordered by whichever end has the smaller stride. */
     int i, j, j_step;
-    if (PyBuffer_IsContiguous(&buf, 'F')) {
+    int fortran_order;
+    if (PyBuffer_IsContiguous(buf, 'F')) {
+      fortran_order = 1;
+    } else if (PyBuffer_IsContiguous(buf, 'C')) {
+      fortran_order = 0;
+    } else {
+      Py_ssize_t first = buf->strides[0], last = buf->strides[buf->ndim - 1];
+      fortran_order = (first < 0 ? -first : first) <= (last < 0 ? -last : last);
+    }
+    if (fortran_order) {
       j = 0;
       j_step = 1;
-    } else if (PyBuffer_IsContiguous(&buf, 'C')) {
-      j = buf.ndim - 1;
-      j_step = -1;
     } else {
-      /* Python checks all dimensions and strides, so this typically indicates
-       * a bug in the array's buffer protocol. */
-      PyErr_Format(PyExc_ValueError, "Invalid buffer: neither C nor Fortran contiguous");
-      return -1;
+      j = buf->ndim - 1;
+      j_step = -1;
     }
-    for (i = 0; i < buf.ndim; ++i, j += j_step) {
+    for (i = 0; i < buf->ndim; ++i, j += j_step) {
+        Py_ssize_t stride = buf->strides[j] / buf->itemsize;  // strides is in bytes
+        if (buf->strides[j] % buf->itemsize != 0 ||
+            stride < INT_MIN || stride > INT_MAX || buf->shape[j] > INT_MAX) {
+            PyErr_Format(PyExc_ValueError,
+                         "Invalid buffer %s: dimension %d has shape %zd and stride %zd, "
+                         "which can't be represented as a halide_buffer_t",
+                         name, j, buf->shape[j], buf->strides[j]);
+            PyBuffer_Release(buf);
+            return -1;
+        }
         dim[i].min = 0;
-        dim[i].stride = (int)(buf.strides[j] / buf.itemsize); // strides is in bytes
-        dim[i].extent = (int)buf.shape[j];
+        dim[i].stride = (int)stride;
+        dim[i].extent = (int)buf->shape[j];
         dim[i].flags = 0;
-        if (buf.suboffsets && buf.suboffsets[i] >= 0) {
+        if (buf->suboffsets && buf->suboffsets[j] >= 0) {
             // Halide doesn't support arrays of pointers. But we should never see this
-            // anyway, since we specified PyBUF_STRIDED.
+            // anyway, since we didn't ask for PyBUF_INDIRECT.
             PyErr_Format(PyExc_ValueError, "Invalid buffer: suboffsets not supported");
+            PyBuffer_Release(buf);
             return -1;
         }
     }
-    if (dim[buf.ndim - 1].extent * dim[buf.ndim - 1].stride * buf.itemsize != buf.len) {
-        PyErr_Format(PyExc_ValueError, "Invalid buffer: length %ld, but computed length %ld",
-                     buf.len, buf.shape[0] * buf.strides[0]);
+    memset(out, 0, sizeof(*out));
+    out->type.code = type_code;
+    out->type.bits = type_bits;
+    out->type.lanes = 1;
+    out->dimensions = buf->ndim;
+    out->dim = dim;
+    out->host = (uint8_t*)buf->buf;
+    return 0;
+}
+
+/* Scalar conversions for the positional fast path, with the same
+ * semantics as the corresponding PyArg_ParseTuple format units. */
+static __attribute__((unused)) int _convert_py_int(PyObject* pyobj, int* out) {
+    long long value = PyLong_AsLongLong(pyobj);
+    if (value == -1 && PyErr_Occurred()) {
         return -1;
     }
-    memset(out, 0, sizeof(*out));
-    if (!buf.format) {
-        out->type.code = halide_type_uint;
-        out->type.bits = 8;
-    } else {
-        /* Convert struct type code. See
-         * https://docs.python.org/2/library/struct.html#module-struct */
-        char* p = buf.format;
-        while (strchr("@<>!=", *p)) {
-            p++;  // ignore little/bit endian (and alignment)
-        }
-        if (*p == 'f' || *p == 'd') {
-            // 'f' and 'd' are float and double, respectively.
-            out->type.code = halide_type_float;
-        } else if (*p >= 'a' && *p <= 'z') {
-            // lowercase is signed int.
-            out->type.code = halide_type_int;
+    if (value < INT_MIN || value > INT_MAX) {
+        PyErr_SetString(PyExc_OverflowError, "signed integer is out of range for int");
+        return -1;
+    }
+    *out = (int)value;
+    return 0;
+}
+
+static __attribute__((unused)) int _convert_py_bool(PyObject* pyobj, bool* out) {
+    long long value = PyLong_AsLongLong(pyobj);
+    if (value == -1 && PyErr_Occurred()) {
+        return -1;
+    }
+    if (value < 0 || value > UCHAR_MAX) {
+        PyErr_SetString(PyExc_OverflowError, "unsigned byte integer is out of range");
+        return -1;
+    }
+    *out = value != 0;
+    return 0;
+}
+
+static __attribute__((unused)) int _convert_py_long_long(PyObject* pyobj, long long* out) {
+    *out = PyLong_AsLongLong(pyobj);
+    return (*out == -1 && PyErr_Occurred()) ? -1 : 0;
+}
+
+static __attribute__((unused)) int _convert_py_unsigned_int(PyObject* pyobj, unsigned int* out) {
+#if PY_MAJOR_VERSION >= 3
+    unsigned long value = PyLong_AsUnsignedLongMask(pyobj);
+#else
+    unsigned long value = PyInt_AsUnsignedLongMask(pyobj);
+#endif
+    *out = (unsigned int)value;
+    return (value == (unsigned long)-1 && PyErr_Occurred()) ? -1 : 0;
+}
+
+static __attribute__((unused)) int _convert_py_unsigned_long_long(PyObject* pyobj, unsigned long long* out) {
+#if PY_MAJOR_VERSION >= 3
+    *out = PyLong_AsUnsignedLongLongMask(pyobj);
+#else
+    *out = PyInt_AsUnsignedLongLongMask(pyobj);
+#endif
+    return (*out == (unsigned long long)-1 && PyErr_Occurred()) ? -1 : 0;
+}
+
+static __attribute__((unused)) int _convert_py_float(PyObject* pyobj, float* out) {
+    double value = PyFloat_AsDouble(pyobj);
+    *out = (float)value;
+    return (value == -1.0 && PyErr_Occurred()) ? -1 : 0;
+}
+
+static __attribute__((unused)) int _convert_py_double(PyObject* pyobj, double* out) {
+    *out = PyFloat_AsDouble(pyobj);
+    return (*out == -1.0 && PyErr_Occurred()) ? -1 : 0;
+}
+
+static __attribute__((unused)) int _convert_py_object(PyObject* pyobj, PyObject** out) {
+    *out = pyobj;
+    return 0;
+}
+
+/* Runs `call` once for each element of `calls`, which must be a sequence
+ * of argument tuples (or of keyword argument dicts). This amortizes the
+ * cost of the Python method call itself over the whole batch. */
+static __attribute__((unused)) PyObject* _call_batch(
+        PyObject* calls, int (*call)(PyObject* args, PyObject* kwargs)) {
+    static PyObject* empty_args = NULL;
+    if (!empty_args && !(empty_args = PyTuple_New(0))) {
+        return NULL;
+    }
+    PyObject* seq = PySequence_Fast(calls, "Expected a sequence of argument tuples");
+    if (!seq) {
+        return NULL;
+    }
+    Py_ssize_t n = PySequence_Fast_GET_SIZE(seq);
+    PyObject** items = PySequence_Fast_ITEMS(seq);
+    for (Py_ssize_t i = 0; i < n; i++) {
+        int ret;
+        if (PyTuple_Check(items[i])) {
+            ret = call(items[i], NULL);
+        } else if (PyDict_Check(items[i])) {
+            ret = call(empty_args, items[i]);
         } else {
-            // uppercase is unsigned int.
-            out->type.code = halide_type_uint;
+            PyErr_Format(PyExc_TypeError, "Call %zd: expected a tuple or dict of arguments", i);
+            ret = -1;
         }
-        const char* type_codes = "bB?hHiIlLqQfd";  // integers and floats
-        if (strchr(type_codes, *p)) {
-            out->type.bits = buf.itemsize * 8;
-        } else {
-            // We don't handle 's' and 'p' (char[]) and 'P' (void*)
-            PyErr_Format(PyExc_ValueError, "Invalid data type for %s: %s", name, buf.format);
-            return -1;
+        if (ret < 0) {
+            Py_DECREF(seq);
+            return NULL;
         }
     }
-    out->type.lanes = 1;
-    out->dimensions = buf.ndim;
-    out->dim = dim;
-    out->host = (uint8_t*)buf.buf;
-    return 0;
+    Py_DECREF(seq);
+    Py_INCREF(Py_True);
+    return Py_True;
 }
 
 )INLINE_CODE";
@@ -252,6 +421,8 @@ static __attribute__((unused)) int _convert_py_buffer_to_halide(
             const string basename = remove_namespaces(f.name);
             dest << "    {\"" << basename << "\", (PyCFunction)_f_" << basename
                  << ", METH_VARARGS|METH_KEYWORDS, NULL},\n";
+            dest << "    {\"" << basename << "_batch\", (PyCFunction)_f_" << basename
+                 << "_batch, METH_O, NULL},\n";
         }
     }
     dest << "    {0, 0, 0, NULL},  // sentinel\n";
@@ -290,7 +461,8 @@ void PythonExtensionGen::compile(const LoweredFunc &f) {
     const string basename = remove_namespaces(f.name);
     std::vector<string> arg_names(args.size());
     dest << "// " << f.name << "\n";
-    dest << "static PyObject* _f_" << basename << "(PyObject* module, PyObject* args, PyObject* kwargs) {\n";
+    dest << "static int _call_" << basename << "(PyObject* args, PyObject* kwargs) {\n";
+    bool convertible = true;
     for (size_t i = 0; i < args.size(); i++) {
         arg_names[i] = sanitize_name(args[i].name);
         if (!can_convert(&args[i])) {
@@ -300,11 +472,31 @@ void PythonExtensionGen::compile(const LoweredFunc &f) {
             // TODO: Add support for handles and vectors.
             dest << "    PyErr_Format(PyExc_NotImplementedError, "
                  << "\"Can't convert argument " << args[i].name << " from Python\");\n";
-            dest << "    return NULL;\n";
-            dest << "}";
-            return;
+            dest << "    return -1;\n";
+            convertible = false;
+            break;
         }
     }
+    if (convertible) {
+        compile_call(f, arg_names);
+    }
+    dest << "}\n\n";
+
+    dest << "static PyObject* _f_" << basename << "(PyObject* module, PyObject* args, PyObject* kwargs) {\n";
+    dest << "    if (_call_" << basename << "(args, kwargs) < 0) {\n";
+    dest << "        return NULL;\n";
+    dest << "    }\n";
+    dest << "    Py_INCREF(Py_True);\n";
+    dest << "    return Py_True;\n";
+    dest << "}\n\n";
+
+    dest << "static PyObject* _f_" << basename << "_batch(PyObject* module, PyObject* calls) {\n";
+    dest << "    return _call_batch(calls, _call_" << basename << ");\n";
+    dest << "}\n";
+}
+
+void PythonExtensionGen::compile_call(const LoweredFunc &f, const std::vector<string> &arg_names) {
+    const std::vector<LoweredArgument> &args = f.args;
     dest << "    static const char* kwlist[] = {";
     for (size_t i = 0; i < args.size(); i++) {
         dest << "\"" << arg_names[i] << "\", ";
@@ -313,7 +505,18 @@ void PythonExtensionGen::compile(const LoweredFunc &f) {
     for (size_t i = 0; i < args.size(); i++) {
         dest << "    " << print_type(&args[i]).second << " py_" << arg_names[i] << ";\n";
     }
-    dest << "    if (!PyArg_ParseTupleAndKeywords(args, kwargs, \"";
+    // Most calls pass every argument positionally, which we can unpack
+    // directly instead of going through the (much slower) generic
+    // argument parser.
+    dest << "    if (PyTuple_GET_SIZE(args) == " << args.size()
+         << " && (!kwargs || PyDict_Size(kwargs) == 0)) {\n";
+    for (size_t i = 0; i < args.size(); i++) {
+        dest << "        if (" << scalar_converter(&args[i])
+             << "(PyTuple_GET_ITEM(args, " << i << "), &py_" << arg_names[i] << ") < 0) {\n";
+        dest << "            return -1;\n";
+        dest << "        }\n";
+    }
+    dest << "    } else if (!PyArg_ParseTupleAndKeywords(args, kwargs, \"";
     for (size_t i = 0; i < args.size(); i++) {
         dest << print_type(&args[i]).first;
     }
@@ -323,11 +526,17 @@ void PythonExtensionGen::compile(const LoweredFunc &f) {
         dest << "&py_" << arg_names[i];
     }
     dest << ")) {\n";
-    dest << "        return NULL;\n";
+    dest << "        return -1;\n";
     dest << "    }\n";
+    std::vector<string> buffers;
     for (size_t i = 0; i < args.size(); i++) {
         if (args[i].is_buffer()) {
-            convert_buffer(arg_names[i], &args[i]);
+            const string &name = arg_names[i];
+            dest << "    Py_buffer view_" << name << ";\n";
+            dest << "    halide_dimension_t dimensions_" << name << "[" << (int)args[i].dimensions << "];\n";
+            dest << "    halide_buffer_t buffer_" << name << ";\n";
+            convert_buffer(name, &args[i], buffers);
+            buffers.push_back(name);
         } else {
             // Python already converted this.
         }
@@ -343,20 +552,17 @@ void PythonExtensionGen::compile(const LoweredFunc &f) {
             dest << "py_" << arg_names[i];
         }
     }
-    dest << ");";
-    dest << R"INLINE_CODE(
-    if (result != 0) {
+    dest << ");\n";
+    release_buffers(buffers, "    ");
+    dest << R"INLINE_CODE(    if (result != 0) {
         /* In the optimal case, we'd be generating an exception declared
          * in python_bindings/src, but since we're self-contained,
          * we don't have access to that API. */
         PyErr_Format(PyExc_ValueError, "Halide error %d", result);
-        return NULL;
+        return -1;
     }
-    Py_INCREF(Py_True);
-    return Py_True;
+    return 0;
 )INLINE_CODE";
-    dest << "}\n";
 }
-
 }
 }
@@ -2,6 +2,7 @@
 #define HALIDE_PYTHON_EXTENSION_GEN_H_
 
 #include <string>
+#include <vector>
 #include "Module.h"
 #include "Target.h"
 
@@ -19,7 +20,9 @@ public:
     void compile(const Module &module);
     void compile(const LoweredFunc &f);
 private:
-    void convert_buffer(std::string name, const LoweredArgument* arg);
+    void compile_call(const LoweredFunc &f, const std::vector<std::string> &arg_names);
+    void convert_buffer(std::string name, const LoweredArgument* arg, const std::vector<std::string> &acquired);
+    void release_buffers(const std::vector<std::string> &names, const std::string &indent);
     std::ostream &dest;
     std::string header_name;
     Target target;
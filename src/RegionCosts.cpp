@@ -322,6 +322,29 @@ map<string, Expr> compute_expr_detailed_byte_loads(Expr expr) {
     return loads;
 }
 
+// Return the size in bytes of 'region', given the size of each element.
+// If 'cache_line_size' is known, the innermost dimension is rounded up
+// to a whole number of cache lines, since that is the granularity at
+// which it is actually brought into the cache.
+Expr region_bytes(const Box &region, const Expr &size_per_ele, const Expr &cache_line_size) {
+    Expr size = box_size(region);
+    if (!size.defined()) {
+        return Expr();
+    }
+    if (!cache_line_size.defined() || is_zero(cache_line_size) ||
+        region.empty() || is_zero(size)) {
+        return simplify(size * size_per_ele);
+    }
+
+    Expr line = cast<int64_t>(cache_line_size);
+    Expr inner = cast<int64_t>(get_extent(region[0])) * size_per_ele;
+    Expr outer = make_one(Int(64));
+    for (size_t i = 1; i < region.size(); i++) {
+        outer *= cast<int64_t>(get_extent(region[i]));
+    }
+    return simplify(((inner + line - 1) / line) * line * outer);
+}
+
 } // anonymous namespace
 
 RegionCosts::RegionCosts(const map<string, Function> &_env,
@@ -608,15 +631,12 @@ vector<Cost> RegionCosts::get_func_cost(const Function &f, const set<string> &in
     return func_costs;
 }
 
-Expr RegionCosts::region_size(string func, const Box &region) {
+Expr RegionCosts::region_size(string func, const Box &region,
+                              const Expr &cache_line_size) {
     const Function &f = get_element(env, func);
-    Expr size = box_size(region);
-    if (!size.defined()) {
-        return Expr();
-    }
     Expr size_per_ele = get_func_value_size(f);
     internal_assert(size_per_ele.defined());
-    return simplify(size * size_per_ele);
+    return region_bytes(region, size_per_ele, cache_line_size);
 }
 
 Expr RegionCosts::region_footprint(const map<string, Box> &regions,
@@ -681,14 +701,11 @@ Expr RegionCosts::region_footprint(const map<string, Box> &regions,
     return simplify(working_set_size);
 }
 
-Expr RegionCosts::input_region_size(string input, const Box &region) {
-    Expr size = box_size(region);
-    if (!size.defined()) {
-        return Expr();
-    }
+Expr RegionCosts::input_region_size(string input, const Box &region,
+                                    const Expr &cache_line_size) {
     Expr size_per_ele = make_const(Int(64), get_element(inputs, input).bytes());
     internal_assert(size_per_ele.defined());
-    return simplify(size * size_per_ele);
+    return region_bytes(region, size_per_ele, cache_line_size);
 }
 
 Expr RegionCosts::input_region_size(const map<string, Box> &input_regions) {
@@ -114,8 +114,11 @@ struct RegionCosts {
         detailed_load_costs(const std::map<std::string, Box> &regions,
                             const std::set<std::string> &inlines = std::set<std::string>());
 
-    /** Return the size of the region of 'func' in bytes. */
-    Expr region_size(std::string func, const Box &region);
+    /** Return the size of the region of 'func' in bytes. If 'cache_line_size'
+     * is defined and non-zero, the innermost dimension of the region is
+     * rounded up to a whole number of cache lines. */
+    Expr region_size(std::string func, const Box &region,
+                     const Expr &cache_line_size = Expr());
 
     /** Return the size of the peak amount of memory allocated in bytes. This takes
      * the realization (topological) order of the function regions and the early
@@ -123,8 +126,10 @@ struct RegionCosts {
     Expr region_footprint(const std::map<std::string, Box> &regions,
                           const std::set<std::string> &inlined = std::set<std::string>());
 
-    /** Return the size of the input region in bytes. */
-    Expr input_region_size(std::string input, const Box &region);
+    /** Return the size of the input region in bytes. 'cache_line_size' is
+     * treated as in region_size. */
+    Expr input_region_size(std::string input, const Box &region,
+                           const Expr &cache_line_size = Expr());
 
     /** Return the total size of the many input regions in bytes. */
     Expr input_region_size(const std::map<std::string, Box> &input_regions);
@@ -214,6 +214,7 @@ struct FuncScheduleContents {
     std::map<std::string, Internal::FunctionPtr> wrappers;
     MemoryType memory_type;
     bool memoized, async;
+    Expr ring_buffer;
 
     FuncScheduleContents() :
         store_level(LoopLevel::inlined()), compute_level(LoopLevel::inlined()),
@@ -249,6 +250,9 @@ struct FuncScheduleContents {
                 b.remainder = mutator->mutate(b.remainder);
             }
         }
+        if (ring_buffer.defined()) {
+            ring_buffer = mutator->mutate(ring_buffer);
+        }
     }
 };
 
@@ -329,6 +333,7 @@ FuncSchedule FuncSchedule::deep_copy(
     copy.contents->memory_type = contents->memory_type;
     copy.contents->memoized = contents->memoized;
     copy.contents->async = contents->async;
+    copy.contents->ring_buffer = contents->ring_buffer;
 
     // Deep-copy wrapper functions.
     for (const auto &iter : contents->wrappers) {
@@ -364,6 +369,14 @@ bool FuncSchedule::async() const {
     return contents->async;
 }
 
+Expr &FuncSchedule::ring_buffer() {
+    return contents->ring_buffer;
+}
+
+Expr FuncSchedule::ring_buffer() const {
+    return contents->ring_buffer;
+}
+
 std::vector<StorageDim> &FuncSchedule::storage_dims() {
     return contents->storage_dims;
 }
@@ -454,6 +467,9 @@ void FuncSchedule::accept(IRVisitor *visitor) const {
             b.remainder.accept(visitor);
         }
     }
+    if (ring_buffer().defined()) {
+        ring_buffer().accept(visitor);
+    }
 }
 
 void FuncSchedule::mutate(IRMutator2 *mutator) {
@@ -397,6 +397,15 @@ public:
     bool &async();
     bool async() const;
 
+    /** The number of copies of this Function's storage that an async
+     * producer cycles through, so that it can run ahead of its
+     * consumers. Undefined if the storage is not ring-buffered. See
+     * \ref Func::ring_buffer */
+    // @{
+    Expr &ring_buffer();
+    Expr ring_buffer() const;
+    // @}
+
     /** The list and order of dimensions used to store this
      * function. The first dimension in the vector corresponds to the
      * innermost dimension for storage (i.e. which dimension is
@@ -1929,6 +1929,20 @@ bool validate_schedule(Function f, const Stmt &s, const Target &target, bool is_
         user_error << err.str();
     }
 
+    if (f.schedule().ring_buffer().defined()) {
+        if (!f.schedule().async()) {
+            user_error << "Func \"" << f.name() << "\" is ring-buffered, so must also be scheduled async().\n";
+        }
+        if (store_at == compute_at) {
+            user_error << "Func \"" << f.name() << "\" is ring-buffered, so must be stored outside the loop"
+                       << " it is computed at:\n"
+                       << "  " << schedule_to_source(f, store_at, compute_at) << "\n";
+        }
+        if (f.dimensions() == 0) {
+            user_error << "Func \"" << f.name() << "\" is zero-dimensional, so cannot be ring-buffered.\n";
+        }
+    }
+
     return true;
 }
 
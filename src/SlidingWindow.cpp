@@ -383,6 +383,12 @@ class SlidingWindow : public IRMutator2 {
             return IRMutator2::visit(op);
         }
 
+        // If it's ring-buffered, each iteration writes to a different
+        // copy of the storage, so there's nothing to slide over.
+        if (sched.ring_buffer().defined()) {
+            return IRMutator2::visit(op);
+        }
+
         Stmt new_body = op->body;
 
         debug(3) << "Doing sliding window analysis on realization of " << op->name << "\n";
@@ -395,6 +395,117 @@ public:
     }
 };
 
+// Give a function's storage a ring of copies, one of which is used by
+// each iteration of the loop it is computed at. The copies are stacked
+// along one dimension of the realization. The producer and the
+// consumer each count the iterations they have done to know which copy
+// to use, and a semaphore stops the producer from getting more than
+// the depth of the ring ahead of the consumer.
+class InjectRingBuffer : public IRMutator2 {
+    const Function &func;
+    int dim;
+    Expr stride, depth, sema_var;
+    string head, tail;
+    // The offset of the current copy in the stacked dimension. Only
+    // defined inside produce and consume nodes for the function.
+    Expr slot_offset;
+
+    using IRMutator2::visit;
+
+    Stmt visit(const ProducerConsumer *op) override {
+        if (op->name != func.name()) {
+            return IRMutator2::visit(op);
+        }
+
+        const string &counter = op->is_producer ? head : tail;
+        Expr count = Load::make(Int(32), counter, 0, Buffer<>(), Parameter(), const_true());
+        string slot_name = counter + ".slot" + unique_name('_');
+        Expr slot = Variable::make(Int(32), slot_name);
+
+        Stmt body;
+        {
+            ScopedValue<Expr> old_offset(slot_offset, slot * stride);
+            body = mutate(op->body);
+        }
+
+        Stmt stmt = ProducerConsumer::make(op->name, op->is_producer, body);
+        Stmt advance = Store::make(counter, count + 1, 0, Parameter(), const_true());
+        if (op->is_producer) {
+            // Wait for a free copy, fill it, and move on to the next one.
+            stmt = Acquire::make(sema_var, 1, Block::make(stmt, advance));
+        } else {
+            // Hand the copy back to the producer once we're done with it.
+            Expr release = Call::make(Int(32), "halide_semaphore_release", {sema_var, 1}, Call::Extern);
+            stmt = Block::make({stmt, advance, Evaluate::make(release)});
+        }
+        return LetStmt::make(slot_name, count % depth, stmt);
+    }
+
+    Expr visit(const Call *op) override {
+        Expr expr = IRMutator2::visit(op);
+        op = expr.as<Call>();
+        internal_assert(op);
+        if (op->name == func.name() && op->call_type == Call::Halide) {
+            internal_assert(slot_offset.defined())
+                << "Access to ring-buffered Func " << func.name() << " outside of its produce or consume nodes\n";
+            vector<Expr> args = op->args;
+            internal_assert(dim < (int)args.size());
+            args[dim] += slot_offset;
+            expr = Call::make(op->type, op->name, args, op->call_type,
+                              op->func, op->value_index, op->image, op->param);
+        } else if (op->name == Call::buffer_crop) {
+            Expr source = op->args[2];
+            const Variable *buf_var = source.as<Variable>();
+            if (buf_var &&
+                starts_with(buf_var->name, func.name() + ".") &&
+                ends_with(buf_var->name, ".buffer")) {
+                // A crop of the whole allocation for an extern
+                // stage. Take the crop from the current copy, and
+                // then restore the logical min coordinate, as for a
+                // folded buffer.
+                internal_assert(slot_offset.defined());
+                internal_assert(op->args.size() >= 5);
+                const Call *mins_call = op->args[3].as<Call>();
+                const Call *extents_call = op->args[4].as<Call>();
+                internal_assert(mins_call && extents_call);
+                vector<Expr> mins = mins_call->args;
+                const vector<Expr> &extents = extents_call->args;
+                internal_assert(dim < (int)mins.size() && dim < (int)extents.size());
+                Expr old_min = mins[dim];
+                Expr old_extent = extents[dim];
+
+                mins[dim] = old_min + slot_offset;
+                vector<Expr> new_args = op->args;
+                new_args[3] = Call::make(type_of<int *>(), Call::make_struct, mins, Call::Intrinsic);
+                expr = Call::make(op->type, op->name, new_args, op->call_type);
+                expr = Call::make(op->type, Call::buffer_set_bounds,
+                                  {expr, dim, old_min, old_extent}, Call::Extern);
+            }
+        }
+        return expr;
+    }
+
+    Stmt visit(const Provide *op) override {
+        Stmt stmt = IRMutator2::visit(op);
+        op = stmt.as<Provide>();
+        internal_assert(op);
+        if (op->name == func.name()) {
+            internal_assert(slot_offset.defined())
+                << "Provide to ring-buffered Func " << func.name() << " outside of its produce node\n";
+            vector<Expr> args = op->args;
+            args[dim] += slot_offset;
+            stmt = Provide::make(op->name, op->values, args);
+        }
+        return stmt;
+    }
+
+public:
+    InjectRingBuffer(const Function &func, int dim, Expr stride, Expr depth,
+                     Expr sema_var, const string &head, const string &tail)
+        : func(func), dim(dim), stride(stride), depth(depth),
+          sema_var(sema_var), head(head), tail(tail) {}
+};
+
 struct Semaphore {
     string name;
     Expr var;
@@ -823,6 +934,10 @@ class StorageFolding : public IRMutator2 {
         auto func_it = env.find(op->name);
         Function func = func_it != env.end() ? func_it->second : Function();
 
+        if (func_it != env.end() && func.schedule().ring_buffer().defined()) {
+            return make_ring_buffer(op, body, func);
+        }
+
         // Don't attempt automatic storage folding if there is
         // more than one produce node for this func.
         bool explicit_only = count_producers(body, op->name) != 1;
@@ -881,6 +996,56 @@ class StorageFolding : public IRMutator2 {
         }
     }
 
+    // Ring-buffered functions get a copy of their storage per
+    // iteration in flight instead of being folded.
+    Stmt make_ring_buffer(const Realize *op, Stmt body, const Function &func) {
+        // Stack the copies along the outermost storage dimension.
+        const string &outer = func.schedule().storage_dims().back().var;
+        const vector<string> &args = func.args();
+        int dim = (int)(std::find(args.begin(), args.end(), outer) - args.begin());
+        internal_assert(dim < (int)args.size());
+
+        string sema_name = func.name() + ".folding_semaphore.ring" + unique_name('_');
+        Expr sema_var = Variable::make(type_of<halide_semaphore_t *>(), sema_name);
+        string head = sema_name + ".head", tail = sema_name + ".tail";
+        string stride_name = func.name() + ".ring_stride" + unique_name('_');
+        Expr stride = Variable::make(Int(32), stride_name);
+        Expr depth = func.schedule().ring_buffer();
+
+        debug(3) << "Ring-buffering " << func.name() << " with depth " << depth
+                 << " along dimension " << dim << "\n";
+
+        body = InjectRingBuffer(func, dim, stride, depth, sema_var, head, tail).mutate(body);
+
+        Region bounds = op->bounds;
+        bounds[dim] = Range(bounds[dim].min, stride * depth);
+        Stmt stmt = Realize::make(op->name, op->types, op->memory_type, bounds, op->condition, body);
+
+        // The producer may initially fill every copy.
+        Expr sema_space = Call::make(type_of<halide_semaphore_t *>(), "halide_make_semaphore",
+                                     {depth}, Call::Extern);
+        stmt = LetStmt::make(sema_name, sema_space, stmt);
+        for (const string &counter : {tail, head}) {
+            stmt = Block::make(Store::make(counter, 0, 0, Parameter(), const_true()), stmt);
+            stmt = Allocate::make(counter, Int(32), MemoryType::Stack, {}, const_true(), stmt);
+        }
+        stmt = LetStmt::make(stride_name, op->bounds[dim].extent, stmt);
+
+        // Func::ring_buffer checks constant depths. A depth of zero
+        // would make a semaphore the producer can never acquire.
+        if (!is_const(depth)) {
+            Expr condition = depth >= 1;
+            std::ostringstream condition_str;
+            condition_str << condition;
+            Expr error = Call::make(Int(32), "halide_error_requirement_failed",
+                                    {condition_str.str(),
+                                     "The ring_buffer depth of Func " + func.name() + " must be at least one"},
+                                    Call::Extern);
+            stmt = Block::make(AssertStmt::make(condition, error), stmt);
+        }
+        return stmt;
+    }
+
 public:
     StorageFolding(const map<string, Function> &env) : env(env) {}
 };
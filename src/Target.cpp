@@ -305,6 +305,7 @@ const std::map<std::string, Target::Feature> feature_name_map = {
     {"asan", Target::ASAN},
     {"check_unsafe_promises", Target::CheckUnsafePromises},
     {"hexagon_dma", Target::HexagonDma},
+    {"cancellable", Target::Cancellable},
     // NOTE: When adding features to this map, be sure to update
     // PyEnums.cpp and halide.cmake as well.
 };
@@ -12,6 +12,7 @@
 #include <atomic>
 #include <algorithm>
 #include <limits>
+#include <cstdlib>
 #include <stdint.h>
 #include <string.h>
 
@@ -66,6 +67,22 @@ struct AllocationHeader {
     AllocationHeader(void (*deallocate_fn)(void *)) : deallocate_fn(deallocate_fn), ref_count(1) {}
 };
 
+/** An allocation header for host memory that was allocated by some
+ * other means (e.g. a memory-mapped file) and handed to a Buffer with
+ * Buffer::adopt_host. The header lives in its own small heap
+ * allocation, and dropping the last reference calls release_fn. */
+struct ExternalAllocationHeader {
+    AllocationHeader header;
+    void (*release_fn)(void *);
+    void *release_context;
+
+    static void deallocate(void *ptr) {
+        ExternalAllocationHeader *ext = (ExternalAllocationHeader *)ptr;
+        ext->release_fn(ext->release_context);
+        free(ext);
+    }
+};
+
 /** This indicates how to deallocate the device for a Halide::Runtime::Buffer. */
 enum struct BufferDeviceOwnership : int {
     Allocated,     ///> halide_device_free will be called when device ref count goes to zero
@@ -83,6 +100,13 @@ struct DeviceRefCount {
     BufferDeviceOwnership ownership{BufferDeviceOwnership::Allocated};
 };
 
+/** The storage for the loop executor used by the parallel Buffer
+ * methods. See Buffer::set_parallel_for. */
+inline halide_do_par_for_t &buffer_parallel_for_storage() {
+    static halide_do_par_for_t fn = nullptr;
+    return fn;
+}
+
 /** A templated Buffer class that wraps halide_buffer_t and adds
  * functionality. When using Halide from C++, this is the preferred
  * way to create input and output buffers. The overhead of using this
@@ -785,6 +809,20 @@ public:
         assert(size == (size_t)type().bytes() && "Error: Overflow computing total size of buffer.");
     }
 
+    /** Take ownership of the host memory this Buffer currently points
+     * to, which was allocated externally. When the last Buffer sharing
+     * it is destroyed or deallocated, release_fn(release_context) is
+     * called. The Buffer must not already own its host memory. */
+    void adopt_host(void (*release_fn)(void *), void *release_context) {
+        assert(!owns_host_memory() && "Buffer already owns its host memory");
+        assert(release_fn);
+        ExternalAllocationHeader *ext = (ExternalAllocationHeader *)malloc(sizeof(ExternalAllocationHeader));
+        new (&ext->header) AllocationHeader(ExternalAllocationHeader::deallocate);
+        ext->release_fn = release_fn;
+        ext->release_context = release_context;
+        alloc = &ext->header;
+    }
+
     /** Allocate memory for this Buffer. Drops the reference to any
      * owned memory. */
     void allocate(void *(*allocate_fn)(size_t) = nullptr,
@@ -1169,6 +1207,9 @@ public:
      * sprite onto a framebuffer, you'll want to translate the sprite
      * to the correct location first like so: \code
      * framebuffer.copy_from(sprite.translated({x, y})); \endcode
+     *
+     * Large copies are split across the executor set with
+     * set_parallel_for, if there is one.
     */
     template<typename T2, int D2>
     void copy_from(const Buffer<T2, D2> &other) {
@@ -1200,22 +1241,22 @@ public:
             using MemType = uint8_t;
             auto &typed_dst = (Buffer<MemType, D> &)dst;
             auto &typed_src = (Buffer<const MemType, D> &)src;
-            typed_dst.for_each_value([&](MemType &dst, MemType src) {dst = src;}, typed_src);
+            typed_dst.for_each_value_parallel([&](MemType &dst, MemType src) {dst = src;}, typed_src);
         } else if (type().bytes() == 2) {
             using MemType = uint16_t;
             auto &typed_dst = (Buffer<MemType, D> &)dst;
             auto &typed_src = (Buffer<const MemType, D> &)src;
-            typed_dst.for_each_value([&](MemType &dst, MemType src) {dst = src;}, typed_src);
+            typed_dst.for_each_value_parallel([&](MemType &dst, MemType src) {dst = src;}, typed_src);
         } else if (type().bytes() == 4) {
             using MemType = uint32_t;
             auto &typed_dst = (Buffer<MemType, D> &)dst;
             auto &typed_src = (Buffer<const MemType, D> &)src;
-            typed_dst.for_each_value([&](MemType &dst, MemType src) {dst = src;}, typed_src);
+            typed_dst.for_each_value_parallel([&](MemType &dst, MemType src) {dst = src;}, typed_src);
         } else if (type().bytes() == 8) {
             using MemType = uint64_t;
             auto &typed_dst = (Buffer<MemType, D> &)dst;
             auto &typed_src = (Buffer<const MemType, D> &)src;
-            typed_dst.for_each_value([&](MemType &dst, MemType src) {dst = src;}, typed_src);
+            typed_dst.for_each_value_parallel([&](MemType &dst, MemType src) {dst = src;}, typed_src);
         } else {
             assert(false && "type().bytes() must be 1, 2, 4, or 8");
         }
@@ -1863,12 +1904,30 @@ public:
         return all_equal;
     }
 
+    /** Set every value in the buffer to val. Large buffers are filled
+     * in parallel using the executor set with set_parallel_for, if
+     * there is one. */
     Buffer<T, D> &fill(not_void_T val) {
         set_host_dirty();
-        for_each_value([=](T &v) {v = val;});
+        for_each_value_parallel([=](T &v) {v = val;});
         return *this;
     }
 
+    /** Set the loop executor used by fill, copy_from,
+     * for_each_value_parallel, and for_each_element_parallel to split
+     * large buffers into chunks that run concurrently. It has the
+     * signature of halide_do_par_for, so code linked against a Halide
+     * runtime can pass halide_do_par_for to use Halide's own thread
+     * pool. If it is null, which is the default, everything runs on
+     * the calling thread. The executor is shared by all Buffer types,
+     * and should be set before any other threads use Buffers. Returns
+     * the previous executor. */
+    static halide_do_par_for_t set_parallel_for(halide_do_par_for_t fn) {
+        halide_do_par_for_t old = buffer_parallel_for_storage();
+        buffer_parallel_for_storage() = fn;
+        return old;
+    }
+
 private:
     /** Helper functions for for_each_value. */
     // @{
@@ -1889,15 +1948,6 @@ private:
 
     static void advance_ptrs(const int *) {}
 
-    // Same as the above, but just increments the pointers.
-    template<typename Ptr, typename ...Ptrs>
-    static void increment_ptrs(Ptr *ptr, Ptrs... ptrs) {
-        (*ptr)++;
-        increment_ptrs(ptrs...);
-    }
-
-    static void increment_ptrs() {}
-
     // Given a bunch of pointers to buffers of different types, read
     // out their strides in the d'th dimension, and assert that their
     // sizes match in that dimension.
@@ -1917,16 +1967,18 @@ private:
     static void for_each_value_helper(Fn &&f, const for_each_value_task_dim<sizeof...(Ptrs)> *t, Ptrs... ptrs) {
         if (d == -1) {
             f((*ptrs)...);
+        } else if (d == 0 && innermost_strides_are_one) {
+            // A counted loop over addresses that are statically known
+            // to be one apart in memory is the easiest form for
+            // compilers to auto-vectorize.
+            const int extent = t[0].extent;
+            for (int i = 0; i < extent; i++) {
+                f(ptrs[i]...);
+            }
         } else {
             for (int i = t[d].extent; i != 0; i--) {
                 for_each_value_helper<(d >= 0 ? d - 1 : -1), innermost_strides_are_one>(f, t, ptrs...);
-                if (d == 0 && innermost_strides_are_one) {
-                    // It helps with auto-vectorization to statically
-                    // know the addresses are one apart in memory.
-                    increment_ptrs((&ptrs)...);
-                } else {
-                    advance_ptrs(t[d].stride, (&ptrs)...);
-                }
+                advance_ptrs(t[d].stride, (&ptrs)...);
             }
         }
     }
@@ -1997,11 +2049,74 @@ private:
             }
         }
 
+        // Only the first d dimensions are left after flattening.
         if (innermost_strides_are_one) {
-            for_each_value_helper<true>(f, dimensions() - 1, t, begin(), (other_buffers.begin())...);
+            for_each_value_helper<true>(f, d - 1, t, begin(), (other_buffers.begin())...);
         } else {
-            for_each_value_helper<false>(f, dimensions() - 1, t, begin(), (other_buffers.begin())...);
+            for_each_value_helper<false>(f, d - 1, t, begin(), (other_buffers.begin())...);
+        }
+    }
+
+    template<typename Fn, typename ...Args>
+    void for_each_value_parallel_impl(Fn &&f, Args&&... other_buffers) const {
+        // Split the dimension with the largest stride, so that each
+        // task covers a contiguous range of memory.
+        int split_dim = -1;
+        for (int i = 0; i < dimensions(); i++) {
+            if (dim(i).extent() > 1 &&
+                (split_dim < 0 || std::abs(dim(i).stride()) > std::abs(dim(split_dim).stride()))) {
+                split_dim = i;
+            }
         }
+        int slices_per_task = 0;
+        if (split_dim < 0 || !should_split(split_dim, &slices_per_task)) {
+            for_each_value_impl(f, std::forward<Args>(other_buffers)...);
+            return;
+        }
+        run_tasks(split_dim, slices_per_task, [&](int min, int extent) {
+            cropped(split_dim, min, extent).for_each_value_impl(f, other_buffers.cropped(split_dim, min, extent)...);
+        });
+    }
+    // @}
+
+    /** Helper functions for the parallel Buffer methods. */
+    // @{
+
+    // Whether work over this buffer is worth splitting along dimension
+    // d, and if so how many slices of that dimension each task
+    // should do.
+    bool should_split(int d, int *slices_per_task) const {
+        // Each task should do at least this many values to be worth
+        // the cost of handing it to another thread.
+        const size_t min_values_per_task = 1 << 16;
+        if (buffer_parallel_for_storage() == nullptr ||
+            number_of_elements() < 2 * min_values_per_task) {
+            return false;
+        }
+        size_t values_per_slice = number_of_elements() / dim(d).extent();
+        *slices_per_task = (int)((min_values_per_task + values_per_slice - 1) / values_per_slice);
+        return *slices_per_task < dim(d).extent();
+    }
+
+    template<typename Body>
+    static int parallel_task(void *user_context, int task, uint8_t *closure) {
+        (*(const Body *)closure)(task);
+        return 0;
+    }
+
+    // Call body(min, extent) for consecutive ranges of slices_per_task
+    // slices that cover dimension d, using the parallel executor.
+    template<typename Body>
+    void run_tasks(int d, int slices_per_task, const Body &body) const {
+        const int min = dim(d).min(), extent = dim(d).extent();
+        const int tasks = (extent + slices_per_task - 1) / slices_per_task;
+        auto task = [&](int i) {
+            int task_min = min + i * slices_per_task;
+            body(task_min, std::min(slices_per_task, min + extent - task_min));
+        };
+        int result = buffer_parallel_for_storage()(nullptr, parallel_task<decltype(task)>, 0, tasks, (uint8_t *)&task);
+        (void)result;
+        assert(result == 0);
     }
     // @}
 
@@ -2036,6 +2151,25 @@ public:
     }
     // @}
 
+    /** Like for_each_value, but large buffers are split into chunks
+     * that are run concurrently by the executor set with
+     * set_parallel_for, if there is one. The function may be called
+     * from several threads at once, and the values are visited in no
+     * particular order. */
+    // @{
+    template<typename Fn, typename ...Args>
+    const Buffer<T, D> &for_each_value_parallel(Fn &&f, Args&&... other_buffers) const {
+        for_each_value_parallel_impl(f, std::forward<Args>(other_buffers)...);
+        return *this;
+    }
+
+    template<typename Fn, typename ...Args>
+    Buffer<T, D> &for_each_value_parallel(Fn &&f, Args&&... other_buffers) {
+        for_each_value_parallel_impl(f, std::forward<Args>(other_buffers)...);
+        return *this;
+    }
+    // @}
+
 private:
 
     // Helper functions for for_each_element
@@ -2170,6 +2304,23 @@ private:
         for_each_element(0, dimensions(), t, std::forward<Fn>(f));
     }
 
+    template<typename Fn>
+    void for_each_element_parallel_impl(Fn &&f) const {
+        // Split the outermost dimension with more than one element.
+        int split_dim = dimensions() - 1;
+        while (split_dim >= 0 && dim(split_dim).extent() == 1) {
+            split_dim--;
+        }
+        int slices_per_task = 0;
+        if (split_dim < 0 || !should_split(split_dim, &slices_per_task)) {
+            for_each_element_impl(f);
+            return;
+        }
+        run_tasks(split_dim, slices_per_task, [&](int min, int extent) {
+            cropped(split_dim, min, extent).for_each_element_impl(f);
+        });
+    }
+
 public:
     /** Call a function at each site in a buffer. This is likely to be
      * much slower than using Halide code to populate a buffer, but is
@@ -2243,6 +2394,26 @@ public:
     }
     // @}
 
+    /** Like for_each_element, but large buffers are split into chunks
+     * along their outermost dimension, which are run concurrently by
+     * the executor set with set_parallel_for, if there is one. The
+     * callable may be called from several threads at once, and must
+     * take either a coordinate for every dimension of the buffer, or
+     * a const int *. */
+    // @{
+    template<typename Fn>
+    const Buffer<T, D> &for_each_element_parallel(Fn &&f) const {
+        for_each_element_parallel_impl(f);
+        return *this;
+    }
+
+    template<typename Fn>
+    Buffer<T, D> &for_each_element_parallel(Fn &&f) {
+        for_each_element_parallel_impl(f);
+        return *this;
+    }
+    // @}
+
 private:
     template<typename Fn>
     struct FillHelper {
@@ -241,6 +241,27 @@ extern int halide_do_loop_task(void *user_context, halide_loop_task_t f, int min
                                uint8_t *closure, void *task_parent);
 //@}
 
+/** Run a loop task over the range [min, min + size) in parallel. This
+ * is what compiled pipelines call for parallel loops that don't need
+ * the full generality of halide_do_parallel_tasks. Unlike
+ * halide_do_par_for, the task is handed a contiguous slice of the
+ * range at a time, and the default implementation picks the size of
+ * each slice according to how much of the loop is left to do, so that
+ * loops with many cheap iterations don't pay the scheduling overhead
+ * once per iteration. If do_par_for or do_task have been replaced via
+ * halide_set_custom_do_par_for or halide_set_custom_do_task but this
+ * has not, the replacements are used instead, calling the task on one
+ * iteration at a time. The same goes if halide_do_par_for itself has
+ * been replaced by defining it. To find that out, the default
+ * implementation calls halide_do_par_for once with a size of zero.
+ * Returns the old handler. */
+//@{
+typedef int (*halide_do_loop_par_for_t)(void *, halide_loop_task_t, int, int, uint8_t *);
+extern halide_do_loop_par_for_t halide_set_custom_do_loop_par_for(halide_do_loop_par_for_t do_loop_par_for);
+extern int halide_do_loop_par_for(void *user_context, halide_loop_task_t f,
+                                  int min, int size, uint8_t *closure);
+//@}
+
 /** Provide an entire custom tasking runtime via function
  * pointers. Note that do_task and semaphore_try_acquire are only ever
  * called by halide_default_do_par_for and
@@ -275,6 +296,8 @@ extern int halide_default_do_task(void *user_context, halide_task_t f, int idx,
 extern int halide_default_do_loop_task(void *user_context, halide_loop_task_t f,
                                        int min, int extent,
                                        uint8_t *closure, void *task_parent);
+extern int halide_default_do_loop_par_for(void *user_context, halide_loop_task_t f,
+                                          int min, int size, uint8_t *closure);
 extern int halide_default_semaphore_init(struct halide_semaphore_t *, int n);
 extern int halide_default_semaphore_release(struct halide_semaphore_t *, int n);
 extern bool halide_default_semaphore_try_acquire(struct halide_semaphore_t *, int n);
@@ -308,6 +331,123 @@ extern void halide_join_thread(struct halide_thread *);
  */
 extern int halide_set_num_threads(int n);
 
+/** How the threads in Halide's thread pool (and threads waiting on
+ * parallel work they launched) behave when they run out of things to
+ * do. Waking a thread sleeping on a condition variable can take tens
+ * of microseconds, which dominates the runtime of small pipelines
+ * called back-to-back, so idle threads may first spin for a while
+ * watching for new work before going to sleep.
+ *
+ * halide_thread_pool_idle_adaptive : spin briefly before sleeping,
+ * and spin for less time when recent spins have come up empty. This
+ * is the default.
+ *
+ * halide_thread_pool_idle_latency : always spin for a long time before
+ * sleeping. Lowest latency for pipelines called in quick succession,
+ * at the cost of burning CPU time between calls.
+ *
+ * halide_thread_pool_idle_power : go straight to sleep. */
+typedef enum halide_thread_pool_idle_policy_t {
+    halide_thread_pool_idle_adaptive = 0,
+    halide_thread_pool_idle_latency = 1,
+    halide_thread_pool_idle_power = 2,
+} halide_thread_pool_idle_policy_t;
+
+/** Set the idle policy used by Halide's thread pool. Returns the old
+ * policy. Like halide_set_num_threads, this only affects the default
+ * implementation of halide_do_par_for(). */
+extern halide_thread_pool_idle_policy_t halide_set_thread_pool_idle_policy(halide_thread_pool_idle_policy_t policy);
+
+/** An opaque struct representing a named thread pool. */
+struct halide_thread_pool;
+
+/** Named thread pools let pipelines that run concurrently be isolated
+ * from each other. Each has its own worker threads and work queue,
+ * separate from the default thread pool. A pipeline runs on a named
+ * pool if the user_context it is called with has been bound to that
+ * pool with halide_bind_thread_pool. Parallel work from pipelines
+ * called with any other user_context goes to the default pool. This
+ * is only guaranteed when using the default implementations of
+ * halide_do_par_for() and halide_do_parallel_tasks().
+ *
+ * halide_create_thread_pool makes a pool with the given name and
+ * number of threads (0 means a reasonable system default, as for
+ * halide_set_num_threads). The threads are created lazily. Returns
+ * NULL if a pool with that name already exists.
+ *
+ * halide_find_thread_pool returns the pool with the given name, or
+ * NULL if there isn't one.
+ *
+ * halide_destroy_thread_pool unbinds any user_contexts bound to the
+ * pool, and releases its threads. No pipelines may be running on it.
+ *
+ * halide_thread_pool_set_cpu_affinity restricts the pool's worker
+ * threads to the CPUs whose bits are set in the mask (bit i of word
+ * i/64 is CPU i), and halide_thread_pool_set_priority sets their
+ * priority, as a nice value (lower is higher priority, 0 is normal).
+ * The thread calling into the pipeline also works on its parallel
+ * loops, and is left alone. These are best-effort: they are currently
+ * only supported on Linux, Android and Windows, and raising a
+ * priority may require privileges. Return zero on success.
+ *
+ * halide_bind_thread_pool binds a user_context to a pool, or unbinds
+ * it if the pool is NULL. Don't rebind a user_context while a pipeline
+ * is running with it. At most 512 user_contexts may be bound at once.
+ * Returns zero on success.
+ *
+ * halide_shutdown_thread_pool releases the threads of the named pools
+ * as well as the default one. They are recreated if needed.
+ */
+// @{
+extern struct halide_thread_pool *halide_create_thread_pool(const char *name, int num_threads);
+extern struct halide_thread_pool *halide_find_thread_pool(const char *name);
+extern void halide_destroy_thread_pool(struct halide_thread_pool *pool);
+extern int halide_thread_pool_set_cpu_affinity(struct halide_thread_pool *pool,
+                                               const uint64_t *cpu_mask, int num_words);
+extern int halide_thread_pool_set_priority(struct halide_thread_pool *pool, int priority);
+extern int halide_bind_thread_pool(void *user_context, struct halide_thread_pool *pool);
+// @}
+
+/** Cooperatively cancel pipelines that are running with a given
+ * user_context. Pipelines compiled with Target::Cancellable call
+ * halide_cancelled at the start of each task of a parallel loop, and
+ * at the start of each iteration of their outermost loops, and the
+ * thread pool calls it before starting each task. Once it returns
+ * nonzero the pipeline stops and returns that value, without calling
+ * halide_error.
+ *
+ * halide_cancel cancels the pipelines running (or later run) with
+ * the user_context.
+ *
+ * halide_set_deadline cancels them once timeout_ns nanoseconds have
+ * passed from now, as measured by halide_current_time_ns.
+ *
+ * halide_clear_cancellation forgets about any cancellation or deadline
+ * for the user_context, so that it can be reused for new work. Call it
+ * once the cancelled pipelines have returned.
+ *
+ * halide_cancelled returns halide_error_code_cancelled if the
+ * user_context has been cancelled or its deadline has passed, and zero
+ * otherwise. When no user_context has a cancellation or deadline, it
+ * is a single atomic load. The default implementation finds the
+ * user_context in a table without taking a lock, and only reads the
+ * clock if that user_context has a deadline. If the user_context
+ * points to something of your own, on platforms that support weak
+ * linking you can define this function yourself to poll a flag in it
+ * instead, and the other three functions are then unused.
+ *
+ * halide_cancel and halide_set_deadline return zero on success. At
+ * most 512 user_contexts can have a cancellation or deadline at once.
+ * Deadlines that have passed are forgotten when room is needed for
+ * more, even if they haven't been cleared.
+ */
+// @{
+extern int halide_cancel(void *user_context);
+extern int halide_set_deadline(void *user_context, int64_t timeout_ns);
+extern void halide_clear_cancellation(void *user_context);
+extern int halide_cancelled(void *user_context);
+// @}
+
 /** Halide calls these functions to allocate and free memory. To
  * replace in AOT code, use the halide_set_custom_malloc and
  * halide_set_custom_free, or (on platforms that support weak
@@ -336,6 +476,37 @@ extern halide_malloc_t halide_set_custom_malloc(halide_malloc_t user_malloc);
 extern halide_free_t halide_set_custom_free(halide_free_t user_free);
 //@}
 
+/** Counters describing the malloc pool. */
+struct halide_malloc_pool_stats_t {
+    /** The number of allocations made through the pool, and how many
+     * of them reused a cached block. */
+    uint64_t allocations, hits;
+
+    /** The number and total size of the freed blocks currently held
+     * by the pool. */
+    uint64_t blocks_cached, bytes_cached;
+};
+
+/** The default allocator on platforms other than Hexagon can keep
+ * freed blocks for reuse, instead of returning them to the system
+ * right away. This is useful for pipelines that run many times with
+ * the same intermediate allocation sizes. Requests are rounded up to
+ * one of four size classes per power of two, and freed blocks are
+ * kept in free lists for their size class, sharded across threads.
+ * halide_enable_malloc_pool turns it on, and sets a cap on the number
+ * of bytes kept in the pool. halide_malloc_pool_trim releases cached
+ * blocks (largest first) until at most the given number of bytes
+ * remain, and can be called when an app goes idle.
+ * halide_disable_malloc_pool turns it off and releases everything it
+ * was holding. Allocations made while the pool was enabled may be
+ * freed at any time. */
+//@{
+extern int halide_enable_malloc_pool(void *user_context, size_t max_cached_bytes);
+extern void halide_disable_malloc_pool(void *user_context);
+extern void halide_malloc_pool_trim(void *user_context, size_t max_cached_bytes);
+extern void halide_malloc_pool_get_stats(void *user_context, struct halide_malloc_pool_stats_t *stats);
+//@}
+
 /** Halide calls these functions to interact with the underlying
  * system runtime functions. To replace in AOT code on platforms that
  * support weak linking, define these functions yourself, or use
@@ -370,6 +541,21 @@ extern int32_t halide_debug_to_file(void *user_context, const char *filename,
                                     int32_t type_code,
                                     struct halide_buffer_t *buf);
 
+/** Set whether halide_debug_to_file writes files on a background
+ * thread. When on, the buffer is copied into memory and the pipeline
+ * continues while a background thread writes it out (compressing it
+ * first, for filenames ending in ".lz4"). The initial setting comes
+ * from the environment variable HL_DEBUG_TO_FILE_ASYNC, and is off if
+ * that isn't set. Returns the previous setting. */
+extern int halide_set_debug_to_file_async(int async);
+
+/** Wait for all asynchronous debug_to_file writes to finish. Returns
+ * halide_error_code_debug_to_file_failed if any of them failed since
+ * the last call, and zero otherwise. Outstanding writes are also
+ * finished when the program exits, except on Windows, where this must
+ * be called before exiting. */
+extern int halide_debug_to_file_wait(void *user_context);
+
 /** Types in the halide type system. They can be ints, unsigned ints,
  * or floats (of various bit-widths), or a handle (which is always 64-bits).
  * Note that the int/uint/float values do not imply a specific bit width
@@ -551,6 +737,46 @@ typedef int32_t (*halide_trace_t)(void *user_context, const struct halide_trace_
 extern halide_trace_t halide_set_custom_trace(halide_trace_t trace);
 // @}
 
+/** Identifies a halide_trace_packet_ext_t. The low eight bits hold
+ * the version of the extension. */
+enum {halide_trace_packet_ext_magic = 0x48545800,
+      halide_trace_packet_ext_version = 1};
+
+/** An optional extension to a packet in a binary trace, recording when
+ * and where the event happened. If present, it comes after the
+ * trace_tag, at the next multiple of four bytes from the start of the
+ * packet, and is included in the packet size, so readers that don't
+ * know about it skip it. halide_default_trace writes it if the
+ * environment variable HL_TRACE_TIMING is set to a non-zero value. All
+ * fields are 32-bit. */
+struct halide_trace_packet_ext_t {
+    /** halide_trace_packet_ext_magic, or'd with the version. */
+    uint32_t magic;
+
+    /** A small integer identifying the thread that emitted the
+     * event. Threads are numbered in the order in which they first
+     * emit an event. */
+    int32_t thread_id;
+
+    /** The time of the event in nanoseconds since the trace clock
+     * started, as measured by halide_current_time_ns, which uses a
+     * monotonic clock where the platform provides one. It is split in
+     * two halves so that the extension only needs four-byte
+     * alignment. */
+    uint32_t time_ns_low, time_ns_high;
+
+    #ifdef __cplusplus
+    HALIDE_ALWAYS_INLINE uint64_t time_ns() const {
+        return ((uint64_t)time_ns_high << 32) | time_ns_low;
+    }
+
+    HALIDE_ALWAYS_INLINE void set_time_ns(uint64_t t) {
+        time_ns_low = (uint32_t)t;
+        time_ns_high = (uint32_t)(t >> 32);
+    }
+    #endif
+};
+
 /** The header of a packet in a binary trace. All fields are 32-bit. */
 struct halide_trace_packet_t {
     /** The total size of this packet in bytes. Always a multiple of
@@ -627,6 +853,31 @@ struct halide_trace_packet_t {
         }
         return f;
     }
+
+    /** Get the offset in bytes from the start of the packet at which
+     * the extension goes, assuming this packet is laid out in memory
+     * as it was written. */
+    HALIDE_ALWAYS_INLINE uint32_t ext_offset() const {
+        const char *t = trace_tag();
+        while (*t++) {
+            // nothing
+        }
+        return (uint32_t)((t - (const char *)this + 3) & ~3);
+    }
+
+    /** Get the extension, or null if this packet doesn't have one. */
+    HALIDE_ALWAYS_INLINE const halide_trace_packet_ext_t *ext() const {
+        uint32_t offset = ext_offset();
+        if (offset + sizeof(halide_trace_packet_ext_t) > size) {
+            return 0;
+        }
+        const halide_trace_packet_ext_t *e =
+            (const halide_trace_packet_ext_t *)((const char *)this + offset);
+        if ((e->magic & ~0xffu) != (uint32_t)halide_trace_packet_ext_magic) {
+            return 0;
+        }
+        return e;
+    }
     #endif
 };
 
@@ -1121,6 +1372,10 @@ enum halide_error_code_t {
      * by zero was evaluated. */
     halide_error_code_integer_division_by_zero = -44,
 
+    /** The pipeline was cancelled with halide_cancel, or ran past a
+     * deadline set with halide_set_deadline. */
+    halide_error_code_cancelled = -45,
+
 };
 
 /** Halide calls the functions below on various error conditions. The
@@ -1276,7 +1531,8 @@ typedef enum halide_target_feature_t {
     halide_target_feature_d3d12compute = 54, ///< Enable Direct3D 12 Compute runtime.
     halide_target_feature_check_unsafe_promises = 55, ///< Insert assertions for promises.
     halide_target_feature_hexagon_dma = 56, ///< Enable Hexagon DMA buffers.
-    halide_target_feature_end = 57 ///< A sentinel. Every target is considered to have this feature, and setting this feature does nothing.
+    halide_target_feature_cancellable = 57, ///< Poll halide_cancelled at the start of parallel tasks and outer loop iterations.
+    halide_target_feature_end = 58 ///< A sentinel. Every target is considered to have this feature, and setting this feature does nothing.
 } halide_target_feature_t;
 
 /** This function is called internally by Halide in some situations to determine
@@ -0,0 +1,223 @@
+#include "HalideRuntime.h"
+#include "scoped_mutex_lock.h"
+
+namespace Halide { namespace Runtime { namespace Internal {
+
+// The cancellation state of each user_context that has any lives in a
+// fixed-size, open-addressed hash table, so that it can be polled
+// without taking a lock. Only the holder of the mutex writes to it,
+// and it brackets each change with increments of a sequence number, so
+// that pollers can tell whether they raced with a change (and only
+// then take the mutex). NULL marks an empty slot, so the NULL
+// user_context has a token of its own. The table is kept at most half
+// full.
+#define MAX_CANCELLATION_TOKENS 512
+#define CANCELLATION_TOKEN_SLOT_BITS 10
+#define CANCELLATION_TOKEN_SLOTS (1 << CANCELLATION_TOKEN_SLOT_BITS)
+
+// The cancel_time of a user_context that has been cancelled outright,
+// which has always passed.
+#define CANCELLED_NOW (-0x7fffffffffffffffLL - 1)
+
+struct cancellation_token {
+    void *user_context;
+    // When its pipelines are cancelled, in the time base of
+    // halide_current_time_ns.
+    int64_t cancel_time;
+};
+
+// The count can be checked without the mutex, so that polling is
+// cheap when nothing has been cancelled and there are no deadlines.
+WEAK halide_mutex cancellation_mutex = { { 0 } };
+WEAK cancellation_token cancellation_tokens[CANCELLATION_TOKEN_SLOTS];
+WEAK cancellation_token null_user_context_token = { NULL, 0 };
+WEAK bool null_user_context_has_token = false;
+WEAK uintptr_t cancellation_tokens_sequence = 0;
+WEAK int num_cancellation_tokens = 0;
+
+WEAK int cancellation_token_home_slot(void *user_context) {
+    uint64_t bits = (uint64_t)(uintptr_t)user_context;
+    uint32_t h = (uint32_t)bits ^ (uint32_t)(bits >> 32);
+    h *= 0x9e3779b1;
+    return (int)(h >> (32 - CANCELLATION_TOKEN_SLOT_BITS));
+}
+
+WEAK int next_cancellation_token_slot(int slot) {
+    return (slot + 1) & (CANCELLATION_TOKEN_SLOTS - 1);
+}
+
+// Returns the slot holding the token of a non-NULL user_context, or
+// the empty slot that ends its probe sequence.
+WEAK int find_cancellation_token_slot(void *user_context) {
+    int slot = cancellation_token_home_slot(user_context);
+    for (int i = 0; i < CANCELLATION_TOKEN_SLOTS; i++) {
+        void *key = __atomic_load_n(&cancellation_tokens[slot].user_context, __ATOMIC_RELAXED);
+        if (key == user_context || key == NULL) {
+            break;
+        }
+        slot = next_cancellation_token_slot(slot);
+    }
+    return slot;
+}
+
+// Finds the token of a user_context. Safe to call without the mutex,
+// but then the result must be validated with the sequence number.
+WEAK cancellation_token *find_cancellation_token(void *user_context) {
+    if (user_context == NULL) {
+        return __atomic_load_n(&null_user_context_has_token, __ATOMIC_RELAXED) ? &null_user_context_token : NULL;
+    }
+    cancellation_token *t = &cancellation_tokens[find_cancellation_token_slot(user_context)];
+    return __atomic_load_n(&t->user_context, __ATOMIC_RELAXED) == user_context ? t : NULL;
+}
+
+// The remaining functions must be called with the mutex held.
+
+WEAK void begin_cancellation_change() {
+    __atomic_fetch_add(&cancellation_tokens_sequence, 1, __ATOMIC_ACQ_REL);
+    // Make the sequence number change visible before any of the table's.
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+WEAK void end_cancellation_change(int delta) {
+    __atomic_fetch_add(&cancellation_tokens_sequence, 1, __ATOMIC_ACQ_REL);
+    __atomic_store_n(&num_cancellation_tokens, num_cancellation_tokens + delta, __ATOMIC_RELEASE);
+}
+
+WEAK void remove_cancellation_token(void *user_context) {
+    if (user_context == NULL) {
+        if (null_user_context_has_token) {
+            begin_cancellation_change();
+            __atomic_store_n(&null_user_context_has_token, false, __ATOMIC_RELAXED);
+            end_cancellation_change(-1);
+        }
+        return;
+    }
+
+    int hole = find_cancellation_token_slot(user_context);
+    if (cancellation_tokens[hole].user_context == NULL) {
+        return;
+    }
+    // Shift back any later entries of the probe sequence that could
+    // no longer be reached once it's removed.
+    begin_cancellation_change();
+    for (int next = next_cancellation_token_slot(hole);
+         cancellation_tokens[next].user_context != NULL;
+         next = next_cancellation_token_slot(next)) {
+        int home = cancellation_token_home_slot(cancellation_tokens[next].user_context);
+        int dist_to_hole = (hole - home) & (CANCELLATION_TOKEN_SLOTS - 1);
+        int dist_to_next = (next - home) & (CANCELLATION_TOKEN_SLOTS - 1);
+        if (dist_to_hole < dist_to_next) {
+            cancellation_tokens[hole].cancel_time = cancellation_tokens[next].cancel_time;
+            __atomic_store_n(&cancellation_tokens[hole].user_context,
+                             cancellation_tokens[next].user_context, __ATOMIC_RELAXED);
+            hole = next;
+        }
+    }
+    __atomic_store_n(&cancellation_tokens[hole].user_context, (void *)NULL, __ATOMIC_RELAXED);
+    end_cancellation_change(-1);
+}
+
+// Forgets the deadlines that have passed, to make room for more
+// tokens. A user_context cancelled outright stays cancelled.
+WEAK void reclaim_expired_cancellation_tokens(void *user_context) {
+    halide_start_clock(user_context);
+    int64_t now = halide_current_time_ns(user_context);
+    for (int slot = 0; slot < CANCELLATION_TOKEN_SLOTS;) {
+        cancellation_token &t = cancellation_tokens[slot];
+        if (t.user_context != NULL && t.cancel_time != CANCELLED_NOW && t.cancel_time <= now) {
+            // Removing it may shift a later token into this slot, so
+            // check it again.
+            remove_cancellation_token(t.user_context);
+        } else {
+            slot++;
+        }
+    }
+}
+
+// Sets the cancel_time of a user_context, unless it has already been
+// cancelled outright.
+WEAK int set_cancel_time(void *user_context, int64_t cancel_time) {
+    if (user_context == NULL) {
+        bool had_token = null_user_context_has_token;
+        if (!had_token || null_user_context_token.cancel_time != CANCELLED_NOW) {
+            begin_cancellation_change();
+            null_user_context_token.cancel_time = cancel_time;
+            __atomic_store_n(&null_user_context_has_token, true, __ATOMIC_RELAXED);
+            end_cancellation_change(had_token ? 0 : 1);
+        }
+        return 0;
+    }
+
+    int slot = find_cancellation_token_slot(user_context);
+    cancellation_token *t = &cancellation_tokens[slot];
+    bool had_token = t->user_context != NULL;
+    if (!had_token && num_cancellation_tokens >= MAX_CANCELLATION_TOKENS) {
+        reclaim_expired_cancellation_tokens(user_context);
+        if (num_cancellation_tokens >= MAX_CANCELLATION_TOKENS) {
+            return halide_error_code_out_of_memory;
+        }
+        slot = find_cancellation_token_slot(user_context);
+        t = &cancellation_tokens[slot];
+    }
+    if (had_token && t->cancel_time == CANCELLED_NOW) {
+        return 0;
+    }
+    begin_cancellation_change();
+    t->cancel_time = cancel_time;
+    __atomic_store_n(&t->user_context, user_context, __ATOMIC_RELAXED);
+    end_cancellation_change(had_token ? 0 : 1);
+    return 0;
+}
+
+}}}  // namespace Halide::Runtime::Internal
+
+using namespace Halide::Runtime::Internal;
+
+extern "C" {
+
+WEAK int halide_cancel(void *user_context) {
+    ScopedMutexLock lock(&cancellation_mutex);
+    return set_cancel_time(user_context, CANCELLED_NOW);
+}
+
+WEAK int halide_set_deadline(void *user_context, int64_t timeout_ns) {
+    halide_start_clock(user_context);
+    int64_t deadline = halide_current_time_ns(user_context) + timeout_ns;
+    ScopedMutexLock lock(&cancellation_mutex);
+    return set_cancel_time(user_context, deadline);
+}
+
+WEAK void halide_clear_cancellation(void *user_context) {
+    ScopedMutexLock lock(&cancellation_mutex);
+    remove_cancellation_token(user_context);
+}
+
+WEAK int halide_cancelled(void *user_context) {
+    if (__atomic_load_n(&num_cancellation_tokens, __ATOMIC_RELAXED) == 0) {
+        return 0;
+    }
+    // The cancel_time may be torn if it's being changed concurrently,
+    // but then so is the sequence number.
+    uintptr_t before = __atomic_load_n(&cancellation_tokens_sequence, __ATOMIC_ACQUIRE);
+    cancellation_token *t = find_cancellation_token(user_context);
+    int64_t cancel_time = t ? t->cancel_time : 0;
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    uintptr_t after = __atomic_load_n(&cancellation_tokens_sequence, __ATOMIC_RELAXED);
+    if ((before & 1) || before != after) {
+        // The tokens changed while we were looking. Wait for the
+        // change to finish, and look again.
+        ScopedMutexLock lock(&cancellation_mutex);
+        t = find_cancellation_token(user_context);
+        cancel_time = t ? t->cancel_time : 0;
+    }
+    if (!t) {
+        return 0;
+    }
+    // Only read the clock if the user_context has a deadline.
+    if (cancel_time == CANCELLED_NOW || halide_current_time_ns(user_context) >= cancel_time) {
+        return halide_error_code_cancelled;
+    }
+    return 0;
+}
+
+}
@@ -44,6 +44,38 @@ struct device_copy {
 };
 
 
+// Copy n elements of a small fixed size, with arbitrary byte strides
+// between them. The fixed-size memcpy compiles to a single load and
+// store, rather than a call to memcpy per element.
+template<int size>
+inline __attribute__((always_inline)) void copy_strided_elements(uint64_t src, uint64_t dst, uint64_t n,
+                                                             uint64_t src_stride, uint64_t dst_stride) {
+    if (src_stride == size && dst_stride == size) {
+        memcpy((void *)dst, (const void *)src, n * size);
+        return;
+    }
+    // Unroll by four so that the loads can issue together.
+    uint64_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        uint8_t tmp[4][size];
+        memcpy(tmp[0], (const void *)(src), size);
+        memcpy(tmp[1], (const void *)(src + src_stride), size);
+        memcpy(tmp[2], (const void *)(src + 2 * src_stride), size);
+        memcpy(tmp[3], (const void *)(src + 3 * src_stride), size);
+        memcpy((void *)(dst), tmp[0], size);
+        memcpy((void *)(dst + dst_stride), tmp[1], size);
+        memcpy((void *)(dst + 2 * dst_stride), tmp[2], size);
+        memcpy((void *)(dst + 3 * dst_stride), tmp[3], size);
+        src += 4 * src_stride;
+        dst += 4 * dst_stride;
+    }
+    for (; i < n; i++) {
+        memcpy((void *)dst, (const void *)src, size);
+        src += src_stride;
+        dst += dst_stride;
+    }
+}
+
 WEAK void copy_memory_helper(const device_copy &copy, int d, int64_t src_off, int64_t dst_off) {
     // Skip size-1 dimensions
     while (d >= 0 && copy.extent[d] == 1) d--;
@@ -52,6 +84,26 @@ WEAK void copy_memory_helper(const device_copy &copy, int d, int64_t src_off, in
         const void *from = (void *)(copy.src + src_off);
         void *to = (void *)(copy.dst + dst_off);
         memcpy(to, from, copy.chunk_size);
+    } else if (d == 0 && copy.chunk_size <= 8 &&
+               (copy.chunk_size & (copy.chunk_size - 1)) == 0) {
+        // The innermost loop copies individual small elements (e.g. when
+        // interleaving planar data). Do it without a memcpy call per
+        // element.
+        uint64_t src = copy.src + src_off, dst = copy.dst + dst_off;
+        switch (copy.chunk_size) {
+        case 1:
+            copy_strided_elements<1>(src, dst, copy.extent[0], copy.src_stride_bytes[0], copy.dst_stride_bytes[0]);
+            break;
+        case 2:
+            copy_strided_elements<2>(src, dst, copy.extent[0], copy.src_stride_bytes[0], copy.dst_stride_bytes[0]);
+            break;
+        case 4:
+            copy_strided_elements<4>(src, dst, copy.extent[0], copy.src_stride_bytes[0], copy.dst_stride_bytes[0]);
+            break;
+        default:
+            copy_strided_elements<8>(src, dst, copy.extent[0], copy.src_stride_bytes[0], copy.dst_stride_bytes[0]);
+            break;
+        }
     } else {
         for (uint64_t i = 0; i < copy.extent[d]; i++) {
             copy_memory_helper(copy, d - 1, src_off, dst_off);
@@ -70,6 +122,79 @@ WEAK void copy_memory(const device_copy &copy, void *user_context) {
     }
 }
 
+// Copies smaller than this are done on the calling thread by
+// copy_memory_multithreaded, and larger ones are split into tasks of at
+// least this size.
+#define MIN_PARALLEL_COPY_BYTES (256 * 1024)
+
+struct copy_memory_task_closure {
+    const device_copy *copy;
+    // The dimension being split across tasks, and how many slices of
+    // it each task does. If the copy is a single contiguous chunk, dim
+    // is -1 and it's the bytes of the chunk that are split.
+    int dim;
+    uint64_t slices_per_task;
+};
+
+WEAK int copy_memory_task(void *user_context, int task, uint8_t *closure) {
+    const copy_memory_task_closure *c = (const copy_memory_task_closure *)closure;
+    const device_copy &copy = *(c->copy);
+    uint64_t begin = task * c->slices_per_task;
+    uint64_t extent = c->dim < 0 ? copy.chunk_size : copy.extent[c->dim];
+    uint64_t end = begin + c->slices_per_task;
+    if (end > extent) {
+        end = extent;
+    }
+    if (c->dim < 0) {
+        memcpy((void *)(copy.dst + begin), (const void *)(copy.src + copy.src_begin + begin), end - begin);
+    } else {
+        // Copy this task's slices as a smaller copy of its own.
+        device_copy slices = copy;
+        slices.extent[c->dim] = end - begin;
+        copy_memory_helper(slices, c->dim,
+                           copy.src_begin + begin * copy.src_stride_bytes[c->dim],
+                           begin * copy.dst_stride_bytes[c->dim]);
+    }
+    return 0;
+}
+
+// Like copy_memory, but for copies between two host allocations, which
+// are split across Halide's thread pool if they are large enough. Must
+// not be called with device_copy_mutex held, as halide_do_par_for may
+// be overridden by something that needs it. Returns the result of
+// halide_do_par_for.
+WEAK int copy_memory_multithreaded(const device_copy &copy, void *user_context) {
+    if (copy.src == copy.dst) {
+        debug(user_context) << "copy_memory_multithreaded: no copy needed as pointers are the same.\n";
+        return 0;
+    }
+
+    // Split the outermost dimension that has more than one slice, or
+    // the chunk itself if there isn't one.
+    int dim = MAX_COPY_DIMS - 1;
+    while (dim >= 0 && copy.extent[dim] == 1) dim--;
+    uint64_t slice_bytes = dim < 0 ? 1 : copy.chunk_size;
+    for (int i = 0; i < dim; i++) {
+        slice_bytes *= copy.extent[i];
+    }
+    uint64_t extent = dim < 0 ? copy.chunk_size : copy.extent[dim];
+    uint64_t total_bytes = slice_bytes * extent;
+
+    if (total_bytes < 2 * MIN_PARALLEL_COPY_BYTES) {
+        copy_memory_helper(copy, MAX_COPY_DIMS-1, copy.src_begin, 0);
+        return 0;
+    }
+
+    copy_memory_task_closure closure;
+    closure.copy = &copy;
+    closure.dim = dim;
+    closure.slices_per_task = (MIN_PARALLEL_COPY_BYTES + slice_bytes - 1) / slice_bytes;
+    int tasks = (int)((extent + closure.slices_per_task - 1) / closure.slices_per_task);
+    debug(user_context) << "copy_memory_multithreaded: " << total_bytes << " bytes in "
+                        << tasks << " tasks\n";
+    return halide_do_par_for(user_context, copy_memory_task, 0, tasks, (uint8_t *)&closure);
+}
+
 // Fills the entire dst buffer, which must be contained within src
 WEAK device_copy make_buffer_copy(const halide_buffer_t *src, bool src_host,
                                   const halide_buffer_t *dst, bool dst_host) {
@@ -155,6 +280,26 @@ WEAK device_copy make_buffer_copy(const halide_buffer_t *src, bool src_host,
         c.src_stride_bytes[MAX_COPY_DIMS-1] = 0;
         c.dst_stride_bytes[MAX_COPY_DIMS-1] = 0;
     }
+
+    // Also merge pairs of adjacent outer dimensions that are laid out
+    // contiguously with respect to each other in both the src and the
+    // dst (e.g. the rows of a crop of a buffer that is only cropped in
+    // y), so that there are fewer, longer loops.
+    for (int i = MAX_COPY_DIMS - 2; i >= 0; i--) {
+        if (c.extent[i + 1] != 1 &&
+            c.src_stride_bytes[i + 1] == c.src_stride_bytes[i] * c.extent[i] &&
+            c.dst_stride_bytes[i + 1] == c.dst_stride_bytes[i] * c.extent[i]) {
+            c.extent[i] *= c.extent[i + 1];
+            for (int j = i + 2; j < MAX_COPY_DIMS; j++) {
+                c.extent[j-1] = c.extent[j];
+                c.src_stride_bytes[j-1] = c.src_stride_bytes[j];
+                c.dst_stride_bytes[j-1] = c.dst_stride_bytes[j];
+            }
+            c.extent[MAX_COPY_DIMS-1] = 1;
+            c.src_stride_bytes[MAX_COPY_DIMS-1] = 0;
+            c.dst_stride_bytes[MAX_COPY_DIMS-1] = 0;
+        }
+    }
     return c;
 }
 
@@ -459,9 +459,12 @@ WEAK int halide_default_buffer_copy(void *user_context, struct halide_buffer_t *
     return halide_error_code_device_buffer_copy_failed;
 }
 
+// A copy between two host allocations isn't done here, but returned in
+// host_copy for the caller to do once it has released device_copy_mutex.
 WEAK int halide_buffer_copy_already_locked(void *user_context, struct halide_buffer_t *src,
                                     const struct halide_device_interface_t *dst_device_interface,
-                                    struct halide_buffer_t *dst) {
+                                    struct halide_buffer_t *dst,
+                                    device_copy *host_copy, bool *host_copy_needed) {
     debug(user_context) << "halide_buffer_copy_already_locked called.\n";
     int err = 0;
 
@@ -530,8 +533,8 @@ WEAK int halide_buffer_copy_already_locked(void *user_context, struct halide_buf
         }
 
         if (to_host && from_host_valid) {
-            device_copy c = make_buffer_copy(src, true, dst, true);
-            copy_memory(c, user_context);
+            *host_copy = make_buffer_copy(src, true, dst, true);
+            *host_copy_needed = true;
             err = 0;
         } else if (to_host) {
             debug(user_context) << "halide_buffer_copy_already_locked: to host case.\n";
@@ -541,7 +544,8 @@ WEAK int halide_buffer_copy_already_locked(void *user_context, struct halide_buf
             if (err == halide_error_code_incompatible_device_interface) {
                 err = copy_to_host_already_locked(user_context, src);
                 if (!err) {
-                    err = halide_buffer_copy_already_locked(user_context, src, NULL, dst);
+                    err = halide_buffer_copy_already_locked(user_context, src, NULL, dst,
+                                                            host_copy, host_copy_needed);
                 }
             }
         } else {
@@ -591,22 +595,34 @@ WEAK int halide_buffer_copy(void *user_context, struct halide_buffer_t *src,
                         << " interface " << dst_device_interface << "\n"
                         << " dst " << *dst << "\n";
 
-    ScopedMutexLock lock(&device_copy_mutex);
+    device_copy host_copy;
+    bool host_copy_needed = false;
+    int err;
+    {
+        ScopedMutexLock lock(&device_copy_mutex);
 
-    if (dst_device_interface) {
-        dst_device_interface->impl->use_module();
-    }
-    if (src->device_interface) {
-        src->device_interface->impl->use_module();
-    }
+        if (dst_device_interface) {
+            dst_device_interface->impl->use_module();
+        }
+        if (src->device_interface) {
+            src->device_interface->impl->use_module();
+        }
 
-    int err = halide_buffer_copy_already_locked(user_context, src, dst_device_interface, dst);
+        err = halide_buffer_copy_already_locked(user_context, src, dst_device_interface, dst,
+                                                &host_copy, &host_copy_needed);
 
-    if (dst_device_interface) {
-        dst_device_interface->impl->release_module();
+        if (dst_device_interface) {
+            dst_device_interface->impl->release_module();
+        }
+        if (src->device_interface) {
+            src->device_interface->impl->release_module();
+        }
     }
-    if (src->device_interface) {
-        src->device_interface->impl->release_module();
+
+    // Host to host copies may be split across the thread pool, so
+    // they're done without holding the mutex.
+    if (err == 0 && host_copy_needed) {
+        err = copy_memory_multithreaded(host_copy, user_context);
     }
 
     return err;
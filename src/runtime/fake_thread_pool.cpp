@@ -18,12 +18,57 @@ WEAK int halide_default_do_par_for(void *user_context, halide_task_t f,
     return 0;
 }
 
+WEAK int halide_default_do_loop_par_for(void *user_context, halide_loop_task_t f,
+                                        int min, int size, uint8_t *closure) {
+    if (size <= 0) {
+        return 0;
+    }
+    return f(user_context, min, size, closure, NULL);
+}
+
 }
 
 namespace Halide { namespace Runtime { namespace Internal {
 
 WEAK halide_do_task_t custom_do_task = halide_default_do_task;
 WEAK halide_do_par_for_t custom_do_par_for = halide_default_do_par_for;
+WEAK halide_do_loop_par_for_t custom_do_loop_par_for = halide_default_do_loop_par_for;
+
+struct loop_par_for_closure {
+    halide_loop_task_t fn;
+    uint8_t *closure;
+};
+
+WEAK int loop_par_for_iteration(void *user_context, int idx, uint8_t *closure) {
+    loop_par_for_closure *c = (loop_par_for_closure *)closure;
+    return c->fn(user_context, idx, 1, c->closure, NULL);
+}
+
+// 0 if not known yet, 1 if halide_do_par_for is the one below, 2 if the
+// user has defined their own, which parallel loops should still go
+// through.
+WEAK int do_par_for_replaced_state = 0;
+
+WEAK int do_par_for_probe_task(void *user_context, int idx, uint8_t *closure) {
+    return 0;
+}
+
+WEAK bool do_par_for_replaced(void *user_context) {
+    if (do_par_for_replaced_state == 0) {
+        halide_do_par_for(user_context, do_par_for_probe_task, 0, 0, NULL);
+        if (do_par_for_replaced_state == 0) {
+            do_par_for_replaced_state = 2;
+        }
+    }
+    return do_par_for_replaced_state == 2;
+}
+
+// Targets without an OS have no yield module to identify threads, and
+// this thread pool runs everything on the calling thread, so traces
+// attribute everything to one thread.
+WEAK uint64_t halide_thread_self() {
+    return 0;
+}
 
 }}} // namespace Halide::Runtime::Internal
 
@@ -51,6 +96,41 @@ WEAK int halide_set_num_threads(int n) {
     return 1;
 }
 
+WEAK halide_thread_pool_idle_policy_t halide_set_thread_pool_idle_policy(halide_thread_pool_idle_policy_t policy) {
+    return halide_thread_pool_idle_adaptive;
+}
+
+// There's only ever one thread, so named thread pools are all the
+// same thing.
+struct halide_thread_pool {
+    int unused;
+};
+
+WEAK halide_thread_pool fake_named_thread_pool;
+
+WEAK halide_thread_pool *halide_create_thread_pool(const char *name, int num_threads) {
+    return &fake_named_thread_pool;
+}
+
+WEAK halide_thread_pool *halide_find_thread_pool(const char *name) {
+    return NULL;
+}
+
+WEAK void halide_destroy_thread_pool(halide_thread_pool *pool) {
+}
+
+WEAK int halide_thread_pool_set_cpu_affinity(halide_thread_pool *pool, const uint64_t *cpu_mask, int num_words) {
+    return 0;
+}
+
+WEAK int halide_thread_pool_set_priority(halide_thread_pool *pool, int priority) {
+    return 0;
+}
+
+WEAK int halide_bind_thread_pool(void *user_context, halide_thread_pool *pool) {
+    return 0;
+}
+
 WEAK halide_do_task_t halide_set_custom_do_task(halide_do_task_t f) {
     halide_do_task_t result = custom_do_task;
     custom_do_task = f;
@@ -63,6 +143,12 @@ WEAK halide_do_par_for_t halide_set_custom_do_par_for(halide_do_par_for_t f) {
     return result;
 }
 
+WEAK halide_do_loop_par_for_t halide_set_custom_do_loop_par_for(halide_do_loop_par_for_t f) {
+    halide_do_loop_par_for_t result = custom_do_loop_par_for;
+    custom_do_loop_par_for = f;
+    return result;
+}
+
 WEAK int halide_do_task(void *user_context, halide_task_t f, int idx,
                         uint8_t *closure) {
     return (*custom_do_task)(user_context, f, idx, closure);
@@ -70,7 +156,24 @@ WEAK int halide_do_task(void *user_context, halide_task_t f, int idx,
 
 WEAK int halide_do_par_for(void *user_context, halide_task_t f,
                            int min, int size, uint8_t *closure) {
-  return (*custom_do_par_for)(user_context, f, min, size, closure);
+    if (f == do_par_for_probe_task) {
+        do_par_for_replaced_state = 1;
+        return 0;
+    }
+    return (*custom_do_par_for)(user_context, f, min, size, closure);
+}
+
+WEAK int halide_do_loop_par_for(void *user_context, halide_loop_task_t f,
+                                int min, int size, uint8_t *closure) {
+    if (custom_do_loop_par_for == halide_default_do_loop_par_for &&
+        (custom_do_par_for != halide_default_do_par_for ||
+         custom_do_task != halide_default_do_task ||
+         do_par_for_replaced(user_context))) {
+        loop_par_for_closure c = {f, closure};
+        return halide_do_par_for(user_context, loop_par_for_iteration,
+                                 min, size, (uint8_t *)&c);
+    }
+    return (*custom_do_loop_par_for)(user_context, f, min, size, closure);
 }
 
 }  // extern "C"
@@ -55,7 +55,7 @@ extern int syscall(int num, ...);
 WEAK int halide_start_clock(void *user_context) {
     // Guard against multiple calls
     if (!halide_reference_clock_inited) {
-        syscall(SYS_CLOCK_GETTIME, CLOCK_REALTIME, &halide_reference_clock);
+        syscall(SYS_CLOCK_GETTIME, CLOCK_MONOTONIC, &halide_reference_clock);
         halide_reference_clock_inited = true;
     }
     return 0;
@@ -65,7 +65,7 @@ WEAK int64_t halide_current_time_ns(void *user_context) {
     timespec now;
     // To avoid requiring people to link -lrt, we just make the syscall directly.
 
-    syscall(SYS_CLOCK_GETTIME, CLOCK_REALTIME, &now);
+    syscall(SYS_CLOCK_GETTIME, CLOCK_MONOTONIC, &now);
     int64_t d = int64_t(now.tv_sec - halide_reference_clock.tv_sec)*1000000000;
     int64_t nd = (now.tv_nsec - halide_reference_clock.tv_nsec);
     return d + nd;
@@ -0,0 +1,27 @@
+#include "HalideRuntime.h"
+#include "runtime_internal.h"
+
+extern "C" {
+
+extern int sched_setaffinity(int pid, size_t cpusetsize, const void *mask);
+extern int setpriority(int which, int who, int prio);
+
+}
+
+namespace Halide { namespace Runtime { namespace Internal {
+
+WEAK void set_current_thread_cpu_affinity(const uint64_t *mask, int num_words) {
+    if (num_words > 0) {
+        // A pid of zero means the calling thread.
+        sched_setaffinity(0, num_words * sizeof(uint64_t), mask);
+    }
+}
+
+WEAK void set_current_thread_priority(int priority) {
+    // On Linux (and Android) the nice value is per-thread, so a who of
+    // zero means the calling thread.
+    const int prio_process = 0;
+    setpriority(prio_process, 0, priority);
+}
+
+}}} // namespace Halide::Runtime::Internal
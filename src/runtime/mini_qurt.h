@@ -185,6 +185,14 @@ extern int qurt_thread_create (qurt_thread_t *thread_id, qurt_thread_attr_t *att
  */
 extern int qurt_thread_join(unsigned int tid, int *status);
 
+/**
+   Gets the identifier of the current thread.
+
+   @return
+   Thread identifier of the caller.
+ */
+extern qurt_thread_t qurt_thread_get_id(void);
+
 /** QuRT mutex type.
 
    Both non-recursive mutex lock/unlock and recursive
@@ -0,0 +1,15 @@
+#include "HalideRuntime.h"
+#include "runtime_internal.h"
+
+namespace Halide { namespace Runtime { namespace Internal {
+
+// There's no way to bind a thread to particular CPUs, and setpriority
+// would change the priority of the whole process, so named thread
+// pools can't change either.
+WEAK void set_current_thread_cpu_affinity(const uint64_t *mask, int num_words) {
+}
+
+WEAK void set_current_thread_priority(int priority) {
+}
+
+}}} // namespace Halide::Runtime::Internal
@@ -1,6 +1,7 @@
 #include "runtime_internal.h"
 
 extern "C" int swtch_pri(int);
+extern "C" uintptr_t pthread_self();
 
 namespace Halide { namespace Runtime { namespace Internal {
 
@@ -8,4 +9,8 @@ WEAK void halide_thread_yield() {
     swtch_pri(0);
 }
 
+WEAK uint64_t halide_thread_self() {
+    return (uint64_t)pthread_self();
+}
+
 }}}
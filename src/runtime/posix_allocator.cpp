@@ -2,30 +2,205 @@
 #include "runtime_internal.h"
 
 #include "printer.h"
+#include "scoped_mutex_lock.h"
 
 extern "C" {
 
 extern void *malloc(size_t);
 extern void free(void *);
 
-WEAK void *halide_default_malloc(void *user_context, size_t x) {
-    // Allocate enough space for aligning the pointer we return.
+}
+
+namespace Halide { namespace Runtime { namespace Internal {
+
+// The malloc pool keeps freed blocks in free lists, one per size
+// class, to hand out again. There are four size classes per power of
+// two, so rounding a request up to its class wastes at most a
+// quarter. Class zero is everything up to the smallest power of two,
+// and larger allocations than the largest class aren't pooled.
+#define MALLOC_POOL_MIN_CLASS_BITS 6
+#define MALLOC_POOL_MAX_CLASS_BITS 30
+#define MALLOC_POOL_NUM_CLASSES (1 + ((MALLOC_POOL_MAX_CLASS_BITS - MALLOC_POOL_MIN_CLASS_BITS) << 2))
+
+// The free lists are split into shards, each with its own lock. A
+// thread prefers the shard picked by the address of its stack, so
+// threads mostly work out of different shards.
+#define MALLOC_POOL_NUM_SHARDS 16
+
+struct malloc_pool_shard {
+    halide_mutex mutex;
+    // A free block holds the next one in its list in its first word.
+    void *free_lists[MALLOC_POOL_NUM_CLASSES];
+};
+
+WEAK malloc_pool_shard malloc_pool_shards[MALLOC_POOL_NUM_SHARDS];
+
+// These are read and written atomically, without any of the locks.
+WEAK bool malloc_pool_enabled = false;
+WEAK size_t malloc_pool_max_cached_bytes = 0;
+WEAK size_t malloc_pool_bytes_cached = 0;
+WEAK size_t malloc_pool_blocks_cached = 0;
+WEAK uint64_t malloc_pool_allocations = 0;
+WEAK uint64_t malloc_pool_hits = 0;
+
+// Returns the size class for an allocation of x bytes, or -1 if it's
+// too large to pool.
+WEAK int malloc_pool_size_class(size_t x) {
+    if (x <= ((size_t)1 << MALLOC_POOL_MIN_CLASS_BITS)) {
+        return 0;
+    }
+    // x is in (2^b, 2^(b+1)]
+    int b = 63 - __builtin_clzll((uint64_t)(x - 1));
+    if (b >= MALLOC_POOL_MAX_CLASS_BITS) {
+        return -1;
+    }
+    size_t step = (size_t)1 << (b - 2);
+    int sub_class = (int)((x - 1 - ((size_t)1 << b)) / step);
+    return 1 + ((b - MALLOC_POOL_MIN_CLASS_BITS) << 2) + sub_class;
+}
+
+WEAK size_t malloc_pool_class_size(int size_class) {
+    if (size_class == 0) {
+        return (size_t)1 << MALLOC_POOL_MIN_CLASS_BITS;
+    }
+    int b = ((size_class - 1) >> 2) + MALLOC_POOL_MIN_CLASS_BITS;
+    int sub_class = (size_class - 1) & 3;
+    return ((size_t)1 << b) + (sub_class + 1) * ((size_t)1 << (b - 2));
+}
+
+WEAK int malloc_pool_preferred_shard() {
+    // Thread stacks are megabytes apart, so the high bits of an
+    // address on the stack mostly tell threads apart.
+    int local;
+    uintptr_t addr = (uintptr_t)&local;
+    return (int)((addr >> 20) ^ (addr >> 24)) & (MALLOC_POOL_NUM_SHARDS - 1);
+}
+
+// Allocate an aligned block. Just before the pointer returned are two
+// words: the pointer that malloc returned, and then the size class
+// plus one if this block belongs to the pool, or zero otherwise.
+WEAK void *tagged_aligned_malloc(size_t x, uintptr_t tag) {
+    // Allocate enough space for aligning the pointer we return. malloc
+    // returns pointers aligned to at least two words, so there's always
+    // room for both of ours.
     const size_t alignment = halide_malloc_alignment();
     void *orig = malloc(x + alignment);
     if (orig == NULL) {
         // Will result in a failed assertion and a call to halide_error
         return NULL;
     }
-    // We want to store the original pointer prior to the pointer we return.
-    void *ptr = (void *)(((size_t)orig + alignment + sizeof(void*) - 1) & ~(alignment - 1));
+    void *ptr = (void *)(((size_t)orig + alignment + 2 * sizeof(void*) - 1) & ~(alignment - 1));
     ((void **)ptr)[-1] = orig;
+    ((uintptr_t *)ptr)[-2] = tag;
     return ptr;
 }
 
+// Release cached blocks, largest first, until no more than
+// max_cached_bytes remain in the pool.
+WEAK void malloc_pool_trim(size_t max_cached_bytes) {
+    for (int c = MALLOC_POOL_NUM_CLASSES - 1; c >= 0; c--) {
+        size_t class_size = malloc_pool_class_size(c);
+        for (int s = 0; s < MALLOC_POOL_NUM_SHARDS; s++) {
+            malloc_pool_shard &shard = malloc_pool_shards[s];
+            ScopedMutexLock lock(&shard.mutex);
+            while (shard.free_lists[c] &&
+                   __atomic_load_n(&malloc_pool_bytes_cached, __ATOMIC_RELAXED) > max_cached_bytes) {
+                void *ptr = shard.free_lists[c];
+                __atomic_store_n(&shard.free_lists[c], *(void **)ptr, __ATOMIC_RELAXED);
+                __atomic_sub_fetch(&malloc_pool_bytes_cached, class_size, __ATOMIC_RELAXED);
+                __atomic_sub_fetch(&malloc_pool_blocks_cached, 1, __ATOMIC_RELAXED);
+                free(((void **)ptr)[-1]);
+            }
+        }
+    }
+}
+
+}}} // namespace Halide::Runtime::Internal
+
+using namespace Halide::Runtime::Internal;
+
+extern "C" {
+
+WEAK void *halide_default_malloc(void *user_context, size_t x) {
+    if (!__atomic_load_n(&malloc_pool_enabled, __ATOMIC_RELAXED)) {
+        return tagged_aligned_malloc(x, 0);
+    }
+    int size_class = malloc_pool_size_class(x);
+    if (size_class < 0) {
+        return tagged_aligned_malloc(x, 0);
+    }
+    size_t class_size = malloc_pool_class_size(size_class);
+    __atomic_add_fetch(&malloc_pool_allocations, 1, __ATOMIC_RELAXED);
+
+    // Look in this thread's shard first, and then the others.
+    int first = malloc_pool_preferred_shard();
+    for (int i = 0; i < MALLOC_POOL_NUM_SHARDS; i++) {
+        malloc_pool_shard &shard = malloc_pool_shards[(first + i) & (MALLOC_POOL_NUM_SHARDS - 1)];
+        if (__atomic_load_n(&shard.free_lists[size_class], __ATOMIC_RELAXED) == NULL) {
+            continue;
+        }
+        void *ptr;
+        {
+            ScopedMutexLock lock(&shard.mutex);
+            ptr = shard.free_lists[size_class];
+            if (ptr) {
+                __atomic_store_n(&shard.free_lists[size_class], *(void **)ptr, __ATOMIC_RELAXED);
+            }
+        }
+        if (ptr) {
+            __atomic_sub_fetch(&malloc_pool_bytes_cached, class_size, __ATOMIC_RELAXED);
+            __atomic_sub_fetch(&malloc_pool_blocks_cached, 1, __ATOMIC_RELAXED);
+            __atomic_add_fetch(&malloc_pool_hits, 1, __ATOMIC_RELAXED);
+            return ptr;
+        }
+    }
+    return tagged_aligned_malloc(class_size, size_class + 1);
+}
+
 WEAK void halide_default_free(void *user_context, void *ptr) {
+    uintptr_t tag = ((uintptr_t *)ptr)[-2];
+    if (tag && __atomic_load_n(&malloc_pool_enabled, __ATOMIC_RELAXED)) {
+        int size_class = (int)(tag - 1);
+        size_t class_size = malloc_pool_class_size(size_class);
+        size_t max_cached_bytes = __atomic_load_n(&malloc_pool_max_cached_bytes, __ATOMIC_RELAXED);
+        if (__atomic_add_fetch(&malloc_pool_bytes_cached, class_size, __ATOMIC_RELAXED) <= max_cached_bytes) {
+            malloc_pool_shard &shard = malloc_pool_shards[malloc_pool_preferred_shard()];
+            ScopedMutexLock lock(&shard.mutex);
+            *(void **)ptr = shard.free_lists[size_class];
+            __atomic_store_n(&shard.free_lists[size_class], ptr, __ATOMIC_RELAXED);
+            __atomic_add_fetch(&malloc_pool_blocks_cached, 1, __ATOMIC_RELAXED);
+            return;
+        }
+        // The pool is full.
+        __atomic_sub_fetch(&malloc_pool_bytes_cached, class_size, __ATOMIC_RELAXED);
+    }
     free(((void**)ptr)[-1]);
 }
 
+WEAK int halide_enable_malloc_pool(void *user_context, size_t max_cached_bytes) {
+    __atomic_store_n(&malloc_pool_max_cached_bytes, max_cached_bytes, __ATOMIC_RELAXED);
+    __atomic_store_n(&malloc_pool_enabled, true, __ATOMIC_RELAXED);
+    // If the cap went down, get under it.
+    malloc_pool_trim(max_cached_bytes);
+    return 0;
+}
+
+WEAK void halide_disable_malloc_pool(void *user_context) {
+    __atomic_store_n(&malloc_pool_enabled, false, __ATOMIC_RELAXED);
+    malloc_pool_trim(0);
+}
+
+WEAK void halide_malloc_pool_trim(void *user_context, size_t max_cached_bytes) {
+    malloc_pool_trim(max_cached_bytes);
+}
+
+WEAK void halide_malloc_pool_get_stats(void *user_context, struct halide_malloc_pool_stats_t *stats) {
+    stats->allocations = __atomic_load_n(&malloc_pool_allocations, __ATOMIC_RELAXED);
+    stats->hits = __atomic_load_n(&malloc_pool_hits, __ATOMIC_RELAXED);
+    stats->blocks_cached = __atomic_load_n(&malloc_pool_blocks_cached, __ATOMIC_RELAXED);
+    stats->bytes_cached = __atomic_load_n(&malloc_pool_bytes_cached, __ATOMIC_RELAXED);
+}
+
 }
 
 namespace Halide { namespace Runtime { namespace Internal {
@@ -133,6 +133,16 @@ struct thread_parker {
 
 }}}} // namespace Halide::Runtime::Internal::Synchronization
 
+namespace Halide { namespace Runtime { namespace Internal {
+
+// Whether the thread pool should stop starting tasks of a job. See
+// halide_cancelled.
+WEAK bool job_cancelled(void *user_context) {
+    return halide_cancelled(user_context) != 0;
+}
+
+}}} // namespace Halide::Runtime::Internal
+
 #include "synchronization_common.h"
 
 #include "thread_pool_common.h"
@@ -111,6 +111,24 @@ struct thread_parker {
 
 }}}} // namespace Halide::Runtime::Internal::Synchronization
 
+namespace Halide { namespace Runtime { namespace Internal {
+
+// Named thread pools can't change the affinity or priority of their
+// threads on QuRT.
+WEAK void set_current_thread_cpu_affinity(const uint64_t *mask, int num_words) {
+}
+
+WEAK void set_current_thread_priority(int priority) {
+}
+
+// Cancellation isn't supported on QuRT, which has no clock for
+// deadlines.
+WEAK bool job_cancelled(void *user_context) {
+    return false;
+}
+
+}}} // namespace Halide::Runtime::Internal
+
 #include "synchronization_common.h"
 
 #include "thread_pool_common.h"
@@ -1,4 +1,5 @@
 #include "runtime_internal.h"
+#include "mini_qurt.h"
 
 // TODO: what should we use here???
 
@@ -7,4 +8,8 @@ namespace Halide { namespace Runtime { namespace Internal {
 WEAK void halide_thread_yield() {
 }
 
+WEAK uint64_t halide_thread_self() {
+    return (uint64_t)qurt_thread_get_id();
+}
+
 }}}
@@ -17,9 +17,13 @@
 // cat src/runtime/runtime_internal.h src/runtime/HalideRuntime*.h | grep "^[^ ][^(]*halide_[^ ]*(" | grep -v '#define' | sed "s/[^(]*halide/halide/" | sed "s/(.*//" | sed "s/^h/    \(void *)\&h/" | sed "s/$/,/" | sort | uniq
 
 extern "C" __attribute__((used)) void *halide_runtime_api_functions[] = {
+    (void *)&halide_bind_thread_pool,
     (void *)&halide_buffer_copy,
     (void *)&halide_buffer_to_string,
     (void *)&halide_can_use_target_features,
+    (void *)&halide_cancel,
+    (void *)&halide_cancelled,
+    (void *)&halide_clear_cancellation,
     (void *)&halide_cond_broadcast,
     (void *)&halide_cond_signal,
     (void *)&halide_cond_wait,
@@ -28,6 +32,7 @@ extern "C" __attribute__((used)) void *halide_runtime_api_functions[] = {
     (void *)&halide_copy_to_host,
     (void *)&halide_copy_to_host_legacy,
     (void *)&halide_create_temp_file,
+    (void *)&halide_create_thread_pool,
     (void *)&halide_cuda_detach_device_ptr,
     (void *)&halide_cuda_device_interface,
     (void *)&halide_cuda_get_device_ptr,
@@ -36,7 +41,9 @@ extern "C" __attribute__((used)) void *halide_runtime_api_functions[] = {
     (void *)&halide_cuda_wrap_device_ptr,
     (void *)&halide_current_time_ns,
     (void *)&halide_debug_to_file,
+    (void *)&halide_debug_to_file_wait,
     (void *)&halide_default_can_use_target_features,
+    (void *)&halide_destroy_thread_pool,
     (void *)&halide_device_and_host_free,
     (void *)&halide_device_and_host_free_as_destructor,
     (void *)&halide_device_and_host_malloc,
@@ -49,13 +56,16 @@ extern "C" __attribute__((used)) void *halide_runtime_api_functions[] = {
     (void *)&halide_device_release,
     (void *)&halide_device_sync,
     (void *)&halide_device_sync_legacy,
+    (void *)&halide_disable_malloc_pool,
     (void *)&halide_do_par_for,
     (void *)&halide_do_parallel_tasks,
     (void *)&halide_do_task,
     (void *)&halide_do_loop_task,
+    (void *)&halide_do_loop_par_for,
     (void *)&halide_double_to_string,
     (void *)&halide_downgrade_buffer_t,
     (void *)&halide_downgrade_buffer_t_device_fields,
+    (void *)&halide_enable_malloc_pool,
     (void *)&halide_error,
     (void *)&halide_error_access_out_of_bounds,
     (void *)&halide_error_bad_dimensions,
@@ -85,6 +95,7 @@ extern "C" __attribute__((used)) void *halide_runtime_api_functions[] = {
     (void *)&halide_error_requirement_failed,
     (void *)&halide_error_specialize_fail,
     (void *)&halide_error_unaligned_host_ptr,
+    (void *)&halide_find_thread_pool,
     (void *)&halide_float16_bits_to_double,
     (void *)&halide_float16_bits_to_float,
     (void *)&halide_free,
@@ -110,6 +121,8 @@ extern "C" __attribute__((used)) void *halide_runtime_api_functions[] = {
     (void *)&halide_join_thread,
     (void *)&halide_load_library,
     (void *)&halide_malloc,
+    (void *)&halide_malloc_pool_get_stats,
+    (void *)&halide_malloc_pool_trim,
     (void *)&halide_matlab_call_pipeline,
     (void *)&halide_memoization_cache_cleanup,
     (void *)&halide_memoization_cache_lookup,
@@ -174,6 +187,7 @@ extern "C" __attribute__((used)) void *halide_runtime_api_functions[] = {
     (void *)&halide_set_custom_can_use_target_features,
     (void *)&halide_set_custom_do_par_for,
     (void *)&halide_set_custom_do_loop_task,
+    (void *)&halide_set_custom_do_loop_par_for,
     (void *)&halide_set_custom_do_task,
     (void *)&halide_set_custom_free,
     (void *)&halide_set_custom_get_library_symbol,
@@ -182,9 +196,12 @@ extern "C" __attribute__((used)) void *halide_runtime_api_functions[] = {
     (void *)&halide_set_custom_malloc,
     (void *)&halide_set_custom_print,
     (void *)&halide_set_custom_trace,
+    (void *)&halide_set_deadline,
+    (void *)&halide_set_debug_to_file_async,
     (void *)&halide_set_error_handler,
     (void *)&halide_set_gpu_device,
     (void *)&halide_set_num_threads,
+    (void *)&halide_set_thread_pool_idle_policy,
     (void *)&halide_set_trace_file,
     (void *)&halide_shutdown_thread_pool,
     (void *)&halide_shutdown_trace,
@@ -192,6 +209,8 @@ extern "C" __attribute__((used)) void *halide_runtime_api_functions[] = {
     (void *)&halide_spawn_thread,
     (void *)&halide_start_clock,
     (void *)&halide_string_to_string,
+    (void *)&halide_thread_pool_set_cpu_affinity,
+    (void *)&halide_thread_pool_set_priority,
     (void *)&halide_trace,
     (void *)&halide_trace_helper,
     (void *)&halide_uint64_to_string,
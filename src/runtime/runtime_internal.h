@@ -203,6 +203,16 @@ extern WEAK __attribute__((always_inline)) int halide_malloc_alignment();
 
 void halide_thread_yield();
 
+// An opaque identifier for the calling thread, unique among the running
+// threads of the process.
+uint64_t halide_thread_self();
+
+// Set the CPU affinity mask and the priority of the calling thread, for
+// named thread pools. These are best-effort: on platforms with no way to
+// do it for a single thread, they do nothing.
+void set_current_thread_cpu_affinity(const uint64_t *mask, int num_words);
+void set_current_thread_priority(int priority);
+
 }}}
 
 using namespace Halide::Runtime::Internal;
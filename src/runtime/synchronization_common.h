@@ -140,6 +140,10 @@ __attribute__((always_inline)) void atomic_thread_fence_acquire() {
      __sync_synchronize();
 }
 
+__attribute__((always_inline)) void atomic_thread_fence_release() {
+     __sync_synchronize();
+}
+
 #else
 
 __attribute__((always_inline))  uintptr_t atomic_and_fetch_release(uintptr_t *addr, uintptr_t val) {
@@ -203,6 +207,10 @@ __attribute__((always_inline)) void atomic_thread_fence_acquire() {
     __atomic_thread_fence(__ATOMIC_ACQUIRE);
 }
 
+__attribute__((always_inline)) void atomic_thread_fence_release() {
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
 #endif
 
 }
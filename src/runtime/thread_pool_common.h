@@ -64,6 +64,18 @@ struct work {
 
 #define MAX_THREADS 256
 
+// The number of times an idle thread polls for new work before going
+// to sleep, under the latency and adaptive idle policies. Under the
+// adaptive policy, each spin that times out without any new work
+// showing up halves the number of polls for the next one, down to a
+// minimum of IDLE_SPIN_POLLS >> MAX_IDLE_SPIN_BACKOFF.
+#define IDLE_SPIN_POLLS_LATENCY (1 << 16)
+#define IDLE_SPIN_POLLS 256
+#define MAX_IDLE_SPIN_BACKOFF 4
+
+// The largest CPU affinity mask a thread pool can have, in 64-bit words.
+#define MAX_CPU_MASK_WORDS 16
+
 WEAK int clamp_num_threads(int threads) {
     if (threads > MAX_THREADS) {
         threads = MAX_THREADS;
@@ -88,7 +100,10 @@ WEAK int default_desired_num_threads() {
     return desired_num_threads;
 }
 
-// The work queue and thread pool is weak, so one big work queue is shared by all halide functions
+// The work queue and thread pool is weak, so one big work queue is
+// shared by all halide functions, except for those bound to a named
+// thread pool (see halide_create_thread_pool), each of which has its
+// own work queue.
 struct work_queue_t {
     // all fields are protected by this mutex.
     halide_mutex mutex;
@@ -96,6 +111,31 @@ struct work_queue_t {
     // The desired number threads doing work (HL_NUM_THREADS).
     int desired_threads_working;
 
+    // What idle threads do while waiting for work. A
+    // halide_thread_pool_idle_policy_t.
+    int idle_policy;
+
+    // The name of a named thread pool, and the next one in the list
+    // of them. NULL for the default pool. Protected by the thread pool
+    // registry mutex rather than this one.
+    char *name;
+    work_queue_t *next_pool;
+
+    // The CPU affinity mask and priority of the worker threads. An
+    // empty mask means any CPU. The settings generation is incremented
+    // whenever these change, so that workers know to reapply them.
+    uint64_t cpu_mask[MAX_CPU_MASK_WORDS];
+    int cpu_mask_words;
+    int priority;
+    int thread_settings_generation;
+
+    // Incremented whenever one of the condition variables below is
+    // broadcast. Idle threads that are spinning rather than sleeping
+    // watch this without holding the mutex. Only changes in it matter,
+    // and things may be broadcast before the queue is initialized, so
+    // it isn't reset.
+    int wakeup_count;
+
     // All fields after this must be zero in the initial state. See assert_zeroed
     // Field serves both to mark the offset in struct and as layout padding.
     int zero_marker;
@@ -123,6 +163,10 @@ struct work_queue_t {
     // waking-up thread may not have decremented this yet.
     int workers_sleeping, owners_sleeping;
 
+    // How many times the adaptive spin has timed out in a row, capped
+    // at MAX_IDLE_SPIN_BACKOFF.
+    int idle_spin_backoff;
+
     // Keep track of threads so they can be joined at shutdown
     halide_thread *threads[MAX_THREADS];
 
@@ -140,9 +184,16 @@ struct work_queue_t {
         return !shutdown;
     }
 
+    // Wake up all the threads sleeping or spinning on one of the
+    // condition variables. Must be called while locked.
+    void broadcast(halide_cond *cond) {
+        Synchronization::atomic_fetch_add_acquire_release(&wakeup_count, 1);
+        halide_cond_broadcast(cond);
+    }
+
     // Used to check initial state is correct.
     void assert_zeroed() const {
-        // Assert that all fields except the mutex and desired hreads count are zeroed.
+        // Assert that all fields except the settings before zero_marker are zeroed.
         const char *bytes = ((const char *)&this->zero_marker);
         const char *limit = ((const char *)this) + sizeof(work_queue_t);
         while (bytes < limit && *bytes == 0) {
@@ -154,14 +205,155 @@ struct work_queue_t {
     // Return the work queue to initial state. Must be called while locked
     // and queue will remain locked.
     void reset() {
-        // Ensure all fields except the mutex and desired hreads count are zeroed.
+        // Ensure all fields except the settings before zero_marker are zeroed.
         char *bytes = ((char *)&this->zero_marker);
         char *limit = ((char *)this) + sizeof(work_queue_t);
         memset(bytes, 0, limit - bytes);
     }
 };
 
-WEAK work_queue_t work_queue = {};
+WEAK work_queue_t default_work_queue = {};
+
+// The user_contexts bound to named thread pools live in a fixed-size,
+// open-addressed hash table, so that every parallel loop can find its
+// pool without taking a lock. Only the holder of the registry mutex
+// writes to it, and it brackets each change with increments of a
+// sequence number, so that readers can tell whether they raced with a
+// change (and only then take the mutex). NULL marks an empty slot, so
+// the NULL user_context is bound separately. The table is kept at
+// most half full.
+#define MAX_THREAD_POOL_BINDINGS 512
+#define THREAD_POOL_BINDING_SLOT_BITS 10
+#define THREAD_POOL_BINDING_SLOTS (1 << THREAD_POOL_BINDING_SLOT_BITS)
+
+struct thread_pool_binding {
+    void *user_context;
+    work_queue_t *work_queue;
+};
+
+// The named thread pools and the bindings are protected by the
+// registry mutex. The binding count can be checked without it, so
+// that looking up the pool for a user_context is free when nothing
+// has been bound.
+WEAK halide_mutex thread_pool_registry_mutex = { { 0 } };
+WEAK work_queue_t *named_work_queues = NULL;
+WEAK thread_pool_binding thread_pool_bindings[THREAD_POOL_BINDING_SLOTS];
+WEAK uintptr_t thread_pool_bindings_sequence = 0;
+WEAK work_queue_t *null_user_context_work_queue = NULL;
+WEAK int num_thread_pool_bindings = 0;
+
+WEAK int thread_pool_binding_home_slot(void *user_context) {
+    uint64_t bits = (uint64_t)(uintptr_t)user_context;
+    uint32_t h = (uint32_t)bits ^ (uint32_t)(bits >> 32);
+    h *= 0x9e3779b1;
+    return (int)(h >> (32 - THREAD_POOL_BINDING_SLOT_BITS));
+}
+
+WEAK int next_thread_pool_binding_slot(int slot) {
+    return (slot + 1) & (THREAD_POOL_BINDING_SLOTS - 1);
+}
+
+// Returns the slot a non-NULL user_context is bound in, or the empty
+// slot that ends its probe sequence. Safe to call without the mutex,
+// but then the result must be validated with the sequence number.
+WEAK int find_thread_pool_binding(void *user_context) {
+    int slot = thread_pool_binding_home_slot(user_context);
+    for (int i = 0; i < THREAD_POOL_BINDING_SLOTS; i++) {
+        void *key;
+        Synchronization::atomic_load_relaxed(&thread_pool_bindings[slot].user_context, &key);
+        if (key == user_context || key == NULL) {
+            break;
+        }
+        slot = next_thread_pool_binding_slot(slot);
+    }
+    return slot;
+}
+
+WEAK work_queue_t *find_bound_work_queue(void *user_context) {
+    thread_pool_binding &b = thread_pool_bindings[find_thread_pool_binding(user_context)];
+    void *key;
+    work_queue_t *q;
+    Synchronization::atomic_load_relaxed(&b.user_context, &key);
+    Synchronization::atomic_load_relaxed(&b.work_queue, &q);
+    return key == user_context ? q : NULL;
+}
+
+WEAK work_queue_t &work_queue_for(void *user_context) {
+    int num_bindings;
+    Synchronization::atomic_load_relaxed(&num_thread_pool_bindings, &num_bindings);
+    if (num_bindings == 0) {
+        return default_work_queue;
+    }
+    work_queue_t *result;
+    if (user_context == NULL) {
+        Synchronization::atomic_load_acquire(&null_user_context_work_queue, &result);
+    } else {
+        uintptr_t before, after;
+        Synchronization::atomic_load_acquire(&thread_pool_bindings_sequence, &before);
+        result = find_bound_work_queue(user_context);
+        Synchronization::atomic_thread_fence_acquire();
+        Synchronization::atomic_load_relaxed(&thread_pool_bindings_sequence, &after);
+        if ((before & 1) || before != after) {
+            // The bindings changed while we were looking. Wait for
+            // the change to finish, and look again.
+            halide_mutex_lock(&thread_pool_registry_mutex);
+            result = find_bound_work_queue(user_context);
+            halide_mutex_unlock(&thread_pool_registry_mutex);
+        }
+    }
+    return result ? *result : default_work_queue;
+}
+
+// Changes the binding of a user_context. Must be called with the
+// registry mutex held. Returns false if there's no room for it.
+WEAK bool set_thread_pool_binding(void *user_context, work_queue_t *q) {
+    if (user_context == NULL) {
+        int delta = (q != NULL) - (null_user_context_work_queue != NULL);
+        Synchronization::atomic_store_release(&null_user_context_work_queue, &q);
+        Synchronization::atomic_fetch_add_acquire_release(&num_thread_pool_bindings, delta);
+        return true;
+    }
+
+    int slot = find_thread_pool_binding(user_context);
+    thread_pool_binding *b = &thread_pool_bindings[slot];
+    bool bound = b->user_context != NULL;
+    if (q != NULL && !bound && num_thread_pool_bindings >= MAX_THREAD_POOL_BINDINGS) {
+        return false;
+    }
+
+    Synchronization::atomic_fetch_add_acquire_release(&thread_pool_bindings_sequence, (uintptr_t)1);
+    // Make the sequence number change visible before any of the table's.
+    Synchronization::atomic_thread_fence_release();
+    if (q != NULL) {
+        Synchronization::atomic_store_release(&b->work_queue, &q);
+        Synchronization::atomic_store_release(&b->user_context, &user_context);
+    } else if (bound) {
+        // Remove it, and shift back any later entries of the probe
+        // sequence that could then no longer be reached.
+        int hole = slot;
+        for (int next = next_thread_pool_binding_slot(hole);
+             thread_pool_bindings[next].user_context != NULL;
+             next = next_thread_pool_binding_slot(next)) {
+            int home = thread_pool_binding_home_slot(thread_pool_bindings[next].user_context);
+            int dist_to_hole = (hole - home) & (THREAD_POOL_BINDING_SLOTS - 1);
+            int dist_to_next = (next - home) & (THREAD_POOL_BINDING_SLOTS - 1);
+            if (dist_to_hole < dist_to_next) {
+                Synchronization::atomic_store_release(&thread_pool_bindings[hole].work_queue,
+                                                      &thread_pool_bindings[next].work_queue);
+                Synchronization::atomic_store_release(&thread_pool_bindings[hole].user_context,
+                                                      &thread_pool_bindings[next].user_context);
+                hole = next;
+            }
+        }
+        void *empty = NULL;
+        Synchronization::atomic_store_release(&thread_pool_bindings[hole].user_context, &empty);
+    }
+    Synchronization::atomic_fetch_add_acquire_release(&thread_pool_bindings_sequence, (uintptr_t)1);
+
+    int delta = (q != NULL) - bound;
+    Synchronization::atomic_fetch_add_acquire_release(&num_thread_pool_bindings, delta);
+    return true;
+}
 
 #if EXTENDED_DEBUG
 WEAK void print_job(work *job, const char *indent, const char *prefix = NULL) {
@@ -176,7 +368,7 @@ WEAK void print_job(work *job, const char *indent, const char *prefix = NULL) {
     }
 }
 
-WEAK void dump_job_state() {
+WEAK void dump_job_state(work_queue_t &work_queue) {
     log_message("Dumping job state, jobs in queue:");
     work *job = work_queue.jobs;
     while (job != NULL) {
@@ -187,13 +379,65 @@ WEAK void dump_job_state() {
 }
 #else
 #define print_job(job, indent, prefix)
-#define dump_job_state()
+#define dump_job_state(work_queue)
 #endif
 
 WEAK void worker_thread(void *);
 
-WEAK void worker_thread_already_locked(work *owned_job) {
+// Called by a thread that found nothing to do, before going to sleep
+// on one of the condition variables. Depending on the idle policy,
+// releases the lock and polls for a while for one of them to be
+// broadcast. Returns true if that happened, in which case the caller
+// should look for work again instead of sleeping. Must be called while
+// locked, and returns locked.
+WEAK bool spin_for_work_already_locked(work_queue_t &work_queue) {
+    int polls;
+    if (work_queue.idle_policy == halide_thread_pool_idle_power) {
+        return false;
+    } else if (work_queue.idle_policy == halide_thread_pool_idle_latency) {
+        polls = IDLE_SPIN_POLLS_LATENCY;
+    } else {
+        polls = IDLE_SPIN_POLLS >> work_queue.idle_spin_backoff;
+    }
+
+    int seen = work_queue.wakeup_count;
+    int current = seen;
+    halide_mutex_unlock(&work_queue.mutex);
+    Synchronization::spin_control spinner;
+    for (int i = 0; i < polls && current == seen; i++) {
+        if (!spinner.should_spin()) {
+            // We've been spinning for a while. Let other threads
+            // have the core between polls.
+            halide_thread_yield();
+        }
+        Synchronization::atomic_load_relaxed(&work_queue.wakeup_count, &current);
+    }
+    halide_mutex_lock(&work_queue.mutex);
+
+    // Everything that broadcasts holds the lock, so if nothing has
+    // been broadcast by now it's safe to go to sleep.
+    bool woken = work_queue.wakeup_count != seen;
+    if (woken) {
+        work_queue.idle_spin_backoff = 0;
+    } else if (work_queue.idle_spin_backoff < MAX_IDLE_SPIN_BACKOFF) {
+        work_queue.idle_spin_backoff++;
+    }
+    log_message("Spun for work " << (woken ? "successfully" : "unsuccessfully") << " with backoff " << work_queue.idle_spin_backoff);
+    return woken;
+}
+
+WEAK void worker_thread_already_locked(work_queue_t &work_queue, work *owned_job) {
+    int thread_settings_generation = 0;
     while (owned_job ? owned_job->running() : !work_queue.shutdown) {
+        if (!owned_job && thread_settings_generation != work_queue.thread_settings_generation) {
+            // The pool's affinity or priority has changed since this
+            // worker last looked. Owners are left alone - they belong
+            // to the caller.
+            thread_settings_generation = work_queue.thread_settings_generation;
+            set_current_thread_cpu_affinity(work_queue.cpu_mask, work_queue.cpu_mask_words);
+            set_current_thread_priority(work_queue.priority);
+        }
+
         work *job = work_queue.jobs;
         work **prev_ptr = &work_queue.jobs;
 
@@ -213,12 +457,12 @@ WEAK void worker_thread_already_locked(work *owned_job) {
                 // The wakeup can likely be only done under certain conditions, but it is only happening
                 // in when an error has already occured and it seems more important to ensure reliable
                 // termination than to optimize this path.
-                halide_cond_broadcast(&work_queue.wake_owners);
+                work_queue.broadcast(&work_queue.wake_owners);
                 continue;
             }
         }
 
-        dump_job_state();
+        dump_job_state(work_queue);
 
         // Find a job to run, prefering things near the top of the stack.
         while (job) {
@@ -252,7 +496,10 @@ WEAK void worker_thread_already_locked(work *owned_job) {
             if (!can_use_this_thread_stack) {
                 log_message("Cannot run job " << job->task.name << " on this thread.");
             }              
-            bool can_add_worker = (!job->task.serial || (job->active_workers == 0));
+            // Once a job has failed (e.g. because it was cancelled)
+            // there's no point starting any more of its tasks.
+            bool can_add_worker = (job->exit_status == 0 &&
+                                   (!job->task.serial || (job->active_workers == 0)));
             if (!can_add_worker) {
                 log_message("Cannot add worker to job " << job->task.name);
             }              
@@ -273,17 +520,20 @@ WEAK void worker_thread_already_locked(work *owned_job) {
             if (owned_job) {
                 work_queue.owners_sleeping++;
                 owned_job->owner_is_sleeping = true;
-                halide_cond_wait(&work_queue.wake_owners, &work_queue.mutex);
+                if (!spin_for_work_already_locked(work_queue)) {
+                    halide_cond_wait(&work_queue.wake_owners, &work_queue.mutex);
+                }
                 owned_job->owner_is_sleeping = false;
                 work_queue.owners_sleeping--;
             } else {
                 work_queue.workers_sleeping++;
                 if (work_queue.a_team_size > work_queue.target_a_team_size) {
-                    // Transition to B team
+                    // Transition to B team. There are more workers
+                    // awake than are wanted, so don't spin.
                     work_queue.a_team_size--;
                     halide_cond_wait(&work_queue.wake_b_team, &work_queue.mutex);
                     work_queue.a_team_size++;
-                } else {
+                } else if (!spin_for_work_already_locked(work_queue)) {
                     halide_cond_wait(&work_queue.wake_a_team, &work_queue.mutex);
                 }
                 work_queue.workers_sleeping--;
@@ -324,6 +574,11 @@ WEAK void worker_thread_already_locked(work *owned_job) {
                 }
                 if (iters == 0) break;
 
+                if (job_cancelled(job->user_context)) {
+                    result = halide_error_code_cancelled;
+                    break;
+                }
+
                 // Do them
                 result = halide_do_loop_task(job->user_context, job->task.fn,
                                              job->task.min + total_iters, iters,
@@ -344,10 +599,25 @@ WEAK void worker_thread_already_locked(work *owned_job) {
                 work_queue.jobs = job;
             }
         } else {
-            // Claim a task from it.
+            // Claim some tasks from it. Loop tasks that don't block
+            // or acquire semaphores are claimed a slice at a time,
+            // sized so that each thread gets a share of half of what
+            // remains. The slices shrink as the loop nears completion,
+            // so loops with many cheap iterations take the lock a
+            // handful of times per thread, while the last few slices
+            // are still small enough to balance the load.
+            int chunk = 1;
+            if (!job->task_fn &&
+                job->task.min_threads == 0 &&
+                job->task.num_semaphores == 0) {
+                chunk = job->task.extent / (2 * (work_queue.threads_created + 1));
+                if (chunk < 1) {
+                    chunk = 1;
+                }
+            }
             work myjob = *job;
-            job->task.min++;
-            job->task.extent--;
+            job->task.min += chunk;
+            job->task.extent -= chunk;
 
             // If there were no more tasks pending for this job, remove it
             // from the stack.
@@ -357,12 +627,14 @@ WEAK void worker_thread_already_locked(work *owned_job) {
 
             // Release the lock and do the task.
             halide_mutex_unlock(&work_queue.mutex);
-            if (myjob.task_fn) {
+            if (job_cancelled(myjob.user_context)) {
+                result = halide_error_code_cancelled;
+            } else if (myjob.task_fn) {
                 result = halide_do_task(myjob.user_context, myjob.task_fn,
                                         myjob.task.min, myjob.task.closure);
             } else {
                 result = halide_do_loop_task(myjob.user_context, myjob.task.fn,
-                                             myjob.task.min, 1,
+                                             myjob.task.min, chunk,
                                              myjob.task.closure, job);
             }
             halide_mutex_lock(&work_queue.mutex);
@@ -404,18 +676,19 @@ WEAK void worker_thread_already_locked(work *owned_job) {
         if (wake_owners ||
             (job->active_workers == 0 && (job->task.extent == 0 || job->exit_status != 0) && job->owner_is_sleeping)) {
             // The job is done or some owned job failed via sibling linkage. Wake up the owner.
-            halide_cond_broadcast(&work_queue.wake_owners);
+            work_queue.broadcast(&work_queue.wake_owners);
         }
     }
 }
 
 WEAK void worker_thread(void *arg) {
+    work_queue_t &work_queue = *(work_queue_t *)arg;
     halide_mutex_lock(&work_queue.mutex);
-    worker_thread_already_locked((work *)arg);
+    worker_thread_already_locked(work_queue, NULL);
     halide_mutex_unlock(&work_queue.mutex);
 }
 
-WEAK void enqueue_work_already_locked(int num_jobs, work *jobs, work *task_parent) {
+WEAK void enqueue_work_already_locked(work_queue_t &work_queue, int num_jobs, work *jobs, work *task_parent) {
     if (!work_queue.initialized) {
         work_queue.assert_zeroed();
 
@@ -486,7 +759,7 @@ WEAK void enqueue_work_already_locked(int num_jobs, work *jobs, work *task_paren
             // increased, or if there aren't enough threads to complete this new task.
             work_queue.a_team_size++;
             work_queue.threads[work_queue.threads_created++] =
-                halide_spawn_thread(worker_thread, NULL);
+                halide_spawn_thread(worker_thread, &work_queue);
         }
         log_message("enqueue_work_already_locked top level job " << jobs[0].task.name << " with min_threads " << min_threads << " work_queue.threads_created " << work_queue.threads_created << " work_queue.threads_reserved " << work_queue.threads_reserved);
         if (job_has_acquires || job_may_block) {
@@ -525,11 +798,11 @@ WEAK void enqueue_work_already_locked(int num_jobs, work *jobs, work *task_paren
         work_queue.target_a_team_size = workers_to_wake;
     }
 
-    halide_cond_broadcast(&work_queue.wake_a_team);
+    work_queue.broadcast(&work_queue.wake_a_team);
     if (work_queue.target_a_team_size > work_queue.a_team_size) {
-        halide_cond_broadcast(&work_queue.wake_b_team);
+        work_queue.broadcast(&work_queue.wake_b_team);
         if (stealable_jobs) {
-            halide_cond_broadcast(&work_queue.wake_owners);
+            work_queue.broadcast(&work_queue.wake_owners);
         }
     }
 
@@ -546,10 +819,80 @@ WEAK void enqueue_work_already_locked(int num_jobs, work *jobs, work *task_paren
 WEAK halide_do_task_t custom_do_task = halide_default_do_task;
 WEAK halide_do_loop_task_t custom_do_loop_task = halide_default_do_loop_task;
 WEAK halide_do_par_for_t custom_do_par_for = halide_default_do_par_for;
+WEAK halide_do_loop_par_for_t custom_do_loop_par_for = halide_default_do_loop_par_for;
 WEAK halide_do_parallel_tasks_t custom_do_parallel_tasks = halide_default_do_parallel_tasks;
 WEAK halide_semaphore_init_t custom_semaphore_init = halide_default_semaphore_init;
 WEAK halide_semaphore_try_acquire_t custom_semaphore_try_acquire = halide_default_semaphore_try_acquire;
 WEAK halide_semaphore_release_t custom_semaphore_release = halide_default_semaphore_release;
+
+// Make the threads of a work queue leave, and return it to its initial
+// state. It starts up again the next time work is enqueued.
+WEAK void shutdown_work_queue(work_queue_t &work_queue) {
+    if (work_queue.initialized) {
+        // Wake everyone up and tell them the party's over and it's time
+        // to go home
+        halide_mutex_lock(&work_queue.mutex);
+
+        work_queue.shutdown = true;
+        work_queue.broadcast(&work_queue.wake_owners);
+        work_queue.broadcast(&work_queue.wake_a_team);
+        work_queue.broadcast(&work_queue.wake_b_team);
+        halide_mutex_unlock(&work_queue.mutex);
+
+        // Wait until they leave
+        for (int i = 0; i < work_queue.threads_created; i++) {
+            halide_join_thread(work_queue.threads[i]);
+        }
+
+        // Tidy up
+        work_queue.reset();
+    }
+}
+
+// Runs a loop task one iteration at a time via a do_par_for that only
+// knows about halide_task_t.
+struct loop_par_for_closure {
+    halide_loop_task_t fn;
+    uint8_t *closure;
+};
+
+WEAK int loop_par_for_iteration(void *user_context, int idx, uint8_t *closure) {
+    loop_par_for_closure *c = (loop_par_for_closure *)closure;
+    return c->fn(user_context, idx, 1, c->closure, NULL);
+}
+
+// Whether the halide_do_par_for linked in is the one below, or one the
+// user has defined in its place, which parallel loops should still go
+// through. Found out by calling it once with a task that ours
+// recognizes: 0 if not known yet, 1 if it's ours, 2 if it's been
+// replaced.
+WEAK int do_par_for_replaced_state = 0;
+
+WEAK int do_par_for_probe_task(void *user_context, int idx, uint8_t *closure) {
+    return 0;
+}
+
+WEAK bool do_par_for_replaced(void *user_context) {
+    int state;
+    Synchronization::atomic_load_relaxed(&do_par_for_replaced_state, &state);
+    if (state == 0) {
+        halide_do_par_for(user_context, do_par_for_probe_task, 0, 0, NULL);
+        Synchronization::atomic_load_relaxed(&do_par_for_replaced_state, &state);
+        if (state == 0) {
+            state = 2;
+            Synchronization::atomic_store_release(&do_par_for_replaced_state, &state);
+        }
+    }
+    return state == 2;
+}
+
+// A semaphore release may have made a job runnable in any of the work queues.
+WEAK void wake_for_semaphore(work_queue_t &work_queue) {
+    halide_mutex_lock(&work_queue.mutex);
+    work_queue.broadcast(&work_queue.wake_a_team);
+    work_queue.broadcast(&work_queue.wake_owners);
+    halide_mutex_unlock(&work_queue.mutex);
+}
  
 }}}  // namespace Halide::Runtime::Internal
 
@@ -600,13 +943,33 @@ WEAK int halide_default_do_par_for(void *user_context, halide_task_t f,
     job.siblings = &job; // guarantees no other job points to the same siblings.
     job.sibling_count = 0;
     job.parent_job = NULL;
+    work_queue_t &work_queue = work_queue_for(user_context);
     halide_mutex_lock(&work_queue.mutex);
-    enqueue_work_already_locked(1, &job, NULL);
-    worker_thread_already_locked(&job);
+    enqueue_work_already_locked(work_queue, 1, &job, NULL);
+    worker_thread_already_locked(work_queue, &job);
     halide_mutex_unlock(&work_queue.mutex);
     return job.exit_status;
 }
 
+WEAK int halide_default_do_loop_par_for(void *user_context, halide_loop_task_t f,
+                                        int min, int size, uint8_t *closure) {
+    if (size <= 0) {
+        return 0;
+    }
+
+    halide_parallel_task_t task;
+    task.fn = f;
+    task.closure = closure;
+    task.name = NULL;
+    task.semaphores = NULL;
+    task.num_semaphores = 0;
+    task.min = min;
+    task.extent = size;
+    task.min_threads = 0;
+    task.serial = false;
+    return halide_do_parallel_tasks(user_context, 1, &task, NULL);
+}
+
 WEAK int halide_default_do_parallel_tasks(void *user_context, int num_tasks,
                                           struct halide_parallel_task_t *tasks,
                                           void *task_parent) {
@@ -632,13 +995,14 @@ WEAK int halide_default_do_parallel_tasks(void *user_context, int num_tasks,
         return 0;
     }
 
+    work_queue_t &work_queue = work_queue_for(user_context);
     halide_mutex_lock(&work_queue.mutex);
-    enqueue_work_already_locked(num_tasks, jobs, (work *)task_parent);
+    enqueue_work_already_locked(work_queue, num_tasks, jobs, (work *)task_parent);
     int exit_status = 0;
     for (int i = 0; i < num_tasks; i++) {
         // It doesn't matter what order we join the tasks in, because
         // we'll happily assist with siblings too.
-        worker_thread_already_locked(jobs + i);
+        worker_thread_already_locked(work_queue, jobs + i);
         if (jobs[i].exit_status != 0) {
             exit_status = jobs[i].exit_status;
         }
@@ -654,36 +1018,165 @@ WEAK int halide_set_num_threads(int n) {
     // Don't make this an atomic swap - we don't want to be changing
     // the desired number of threads while another thread is in the
     // middle of a sequence of non-atomic operations.
-    halide_mutex_lock(&work_queue.mutex);
+    halide_mutex_lock(&default_work_queue.mutex);
     if (n == 0) {
         n = default_desired_num_threads();
     }
-    int old = work_queue.desired_threads_working;
-    work_queue.desired_threads_working = clamp_num_threads(n);
-    halide_mutex_unlock(&work_queue.mutex);
+    int old = default_work_queue.desired_threads_working;
+    default_work_queue.desired_threads_working = clamp_num_threads(n);
+    halide_mutex_unlock(&default_work_queue.mutex);
+    return old;
+}
+
+WEAK halide_thread_pool_idle_policy_t halide_set_thread_pool_idle_policy(halide_thread_pool_idle_policy_t policy) {
+    halide_mutex_lock(&default_work_queue.mutex);
+    halide_thread_pool_idle_policy_t old = (halide_thread_pool_idle_policy_t)default_work_queue.idle_policy;
+    default_work_queue.idle_policy = policy;
+    default_work_queue.idle_spin_backoff = 0;
+    halide_mutex_unlock(&default_work_queue.mutex);
     return old;
 }
 
 WEAK void halide_shutdown_thread_pool() {
-    if (work_queue.initialized) {
-        // Wake everyone up and tell them the party's over and it's time
-        // to go home
-        halide_mutex_lock(&work_queue.mutex);
+    shutdown_work_queue(default_work_queue);
+
+    // The named pools stay registered, but their threads go away
+    // too. New pools are only ever added at the head of the list, and
+    // none may be destroyed concurrently with this, so the list can
+    // be walked without the registry mutex while the threads are
+    // joined.
+    halide_mutex_lock(&thread_pool_registry_mutex);
+    work_queue_t *pools = named_work_queues;
+    halide_mutex_unlock(&thread_pool_registry_mutex);
+    for (work_queue_t *q = pools; q; q = q->next_pool) {
+        shutdown_work_queue(*q);
+    }
+}
 
-        work_queue.shutdown = true;
-        halide_cond_broadcast(&work_queue.wake_owners);
-        halide_cond_broadcast(&work_queue.wake_a_team);
-        halide_cond_broadcast(&work_queue.wake_b_team);
-        halide_mutex_unlock(&work_queue.mutex);
+WEAK halide_thread_pool *halide_create_thread_pool(const char *name, int num_threads) {
+    if (name == NULL || num_threads < 0) {
+        halide_error(NULL, "halide_create_thread_pool: needs a name, and num_threads must be >= 0.");
+        return NULL;
+    }
 
-        // Wait until they leave
-        for (int i = 0; i < work_queue.threads_created; i++) {
-            halide_join_thread(work_queue.threads[i]);
+    halide_mutex_lock(&thread_pool_registry_mutex);
+    for (work_queue_t *q = named_work_queues; q; q = q->next_pool) {
+        if (strcmp(q->name, name) == 0) {
+            halide_mutex_unlock(&thread_pool_registry_mutex);
+            halide_error(NULL, "halide_create_thread_pool: a thread pool with that name already exists.");
+            return NULL;
         }
+    }
 
-        // Tidy up
-        work_queue.reset();
+    work_queue_t *q = (work_queue_t *)malloc(sizeof(work_queue_t));
+    size_t name_len = strlen(name) + 1;
+    char *name_copy = (char *)malloc(name_len);
+    if (q == NULL || name_copy == NULL) {
+        free(q);
+        free(name_copy);
+        halide_mutex_unlock(&thread_pool_registry_mutex);
+        return NULL;
+    }
+    memset(q, 0, sizeof(work_queue_t));
+    memcpy(name_copy, name, name_len);
+    q->name = name_copy;
+    q->desired_threads_working = clamp_num_threads(num_threads == 0 ? default_desired_num_threads() : num_threads);
+    q->idle_policy = default_work_queue.idle_policy;
+    q->next_pool = named_work_queues;
+    named_work_queues = q;
+    halide_mutex_unlock(&thread_pool_registry_mutex);
+    return (halide_thread_pool *)q;
+}
+
+WEAK halide_thread_pool *halide_find_thread_pool(const char *name) {
+    work_queue_t *result = NULL;
+    halide_mutex_lock(&thread_pool_registry_mutex);
+    for (work_queue_t *q = named_work_queues; q; q = q->next_pool) {
+        if (strcmp(q->name, name) == 0) {
+            result = q;
+            break;
+        }
     }
+    halide_mutex_unlock(&thread_pool_registry_mutex);
+    return (halide_thread_pool *)result;
+}
+
+WEAK void halide_destroy_thread_pool(halide_thread_pool *pool) {
+    work_queue_t *q = (work_queue_t *)pool;
+    if (q == NULL) {
+        return;
+    }
+
+    halide_mutex_lock(&thread_pool_registry_mutex);
+    // Unbind every user_context bound to it. Unbinding can shift a
+    // later entry back into the current slot, so check it again.
+    for (int slot = 0; slot < THREAD_POOL_BINDING_SLOTS;) {
+        thread_pool_binding &b = thread_pool_bindings[slot];
+        if (b.user_context != NULL && b.work_queue == q) {
+            set_thread_pool_binding(b.user_context, NULL);
+        } else {
+            slot++;
+        }
+    }
+    if (null_user_context_work_queue == q) {
+        set_thread_pool_binding(NULL, NULL);
+    }
+    // And remove it from the list of pools.
+    for (work_queue_t **p = &named_work_queues; *p; p = &(*p)->next_pool) {
+        if (*p == q) {
+            *p = q->next_pool;
+            break;
+        }
+    }
+    halide_mutex_unlock(&thread_pool_registry_mutex);
+
+    shutdown_work_queue(*q);
+    free(q->name);
+    free(q);
+}
+
+WEAK int halide_thread_pool_set_cpu_affinity(halide_thread_pool *pool, const uint64_t *cpu_mask, int num_words) {
+    work_queue_t *q = (work_queue_t *)pool;
+    if (q == NULL || num_words < 0 || num_words > MAX_CPU_MASK_WORDS) {
+        halide_error(NULL, "halide_thread_pool_set_cpu_affinity: mask must have at most 16 words.");
+        return halide_error_code_generic_error;
+    }
+    halide_mutex_lock(&q->mutex);
+    for (int i = 0; i < num_words; i++) {
+        q->cpu_mask[i] = cpu_mask[i];
+    }
+    q->cpu_mask_words = num_words;
+    q->thread_settings_generation++;
+    // Wake up the workers so they move.
+    q->broadcast(&q->wake_a_team);
+    q->broadcast(&q->wake_b_team);
+    halide_mutex_unlock(&q->mutex);
+    return 0;
+}
+
+WEAK int halide_thread_pool_set_priority(halide_thread_pool *pool, int priority) {
+    work_queue_t *q = (work_queue_t *)pool;
+    if (q == NULL) {
+        return halide_error_code_generic_error;
+    }
+    halide_mutex_lock(&q->mutex);
+    q->priority = priority;
+    q->thread_settings_generation++;
+    q->broadcast(&q->wake_a_team);
+    q->broadcast(&q->wake_b_team);
+    halide_mutex_unlock(&q->mutex);
+    return 0;
+}
+
+WEAK int halide_bind_thread_pool(void *user_context, halide_thread_pool *pool) {
+    halide_mutex_lock(&thread_pool_registry_mutex);
+    bool ok = set_thread_pool_binding(user_context, (work_queue_t *)pool);
+    halide_mutex_unlock(&thread_pool_registry_mutex);
+    if (!ok) {
+        halide_error(user_context, "halide_bind_thread_pool: too many user_contexts are bound to thread pools.");
+        return halide_error_code_generic_error;
+    }
+    return 0;
 }
 
 struct halide_semaphore_impl_t {
@@ -702,10 +1195,12 @@ WEAK int halide_default_semaphore_release(halide_semaphore_t *s, int n) {
     // TODO(abadams|zvookin): Is this correct if an acquire can be for say count of 2 and the releases are 1 each?
     if (old_val == 0 && n != 0) { // Don't wake if nothing released.
         // We may have just made a job runnable
-        halide_mutex_lock(&work_queue.mutex);
-        halide_cond_broadcast(&work_queue.wake_a_team);
-        halide_cond_broadcast(&work_queue.wake_owners);
-        halide_mutex_unlock(&work_queue.mutex);
+        wake_for_semaphore(default_work_queue);
+        halide_mutex_lock(&thread_pool_registry_mutex);
+        for (work_queue_t *q = named_work_queues; q; q = q->next_pool) {
+            wake_for_semaphore(*q);
+        }
+        halide_mutex_unlock(&thread_pool_registry_mutex);
     }
     return old_val + n;
 }
@@ -744,6 +1239,12 @@ WEAK halide_do_par_for_t halide_set_custom_do_par_for(halide_do_par_for_t f) {
     return result;
 }
 
+WEAK halide_do_loop_par_for_t halide_set_custom_do_loop_par_for(halide_do_loop_par_for_t f) {
+    halide_do_loop_par_for_t result = custom_do_loop_par_for;
+    custom_do_loop_par_for = f;
+    return result;
+}
+
 WEAK void halide_set_custom_parallel_runtime(
     halide_do_par_for_t do_par_for,
     halide_do_task_t do_task,
@@ -769,9 +1270,31 @@ WEAK int halide_do_task(void *user_context, halide_task_t f, int idx,
 
 WEAK int halide_do_par_for(void *user_context, halide_task_t f,
                            int min, int size, uint8_t *closure) {
+    if (f == do_par_for_probe_task) {
+        // do_par_for_replaced wants to know if this is in use.
+        int state = 1;
+        Synchronization::atomic_store_release(&do_par_for_replaced_state, &state);
+        return 0;
+    }
     return (*custom_do_par_for)(user_context, f, min, size, closure);
 }
 
+WEAK int halide_do_loop_par_for(void *user_context, halide_loop_task_t f,
+                                int min, int size, uint8_t *closure) {
+    if (custom_do_loop_par_for == halide_default_do_loop_par_for &&
+        (custom_do_par_for != halide_default_do_par_for ||
+         custom_do_task != halide_default_do_task ||
+         do_par_for_replaced(user_context))) {
+        // Someone has replaced do_par_for or do_task but not this,
+        // so respect their wishes at the cost of one call per
+        // iteration.
+        loop_par_for_closure c = {f, closure};
+        return halide_do_par_for(user_context, loop_par_for_iteration,
+                                 min, size, (uint8_t *)&c);
+    }
+    return (*custom_do_loop_par_for)(user_context, f, min, size, closure);
+}
+
 WEAK int halide_do_loop_task(void *user_context, halide_loop_task_t f,
                              int min, int size, uint8_t *closure, void *task_parent){
   return custom_do_loop_task(user_context, f, min, size, closure, task_parent);
@@ -135,11 +135,68 @@ public:
     TraceBuffer() : cursor(0), overage(0) {}
 };
 
+// Maps the identifiers returned by halide_thread_self to small
+// integers, in the order in which threads first emit an event. Must
+// be zero-initialized.
+class TraceThreadIds {
+    const static int max_threads = 256;
+    uint64_t threads[max_threads];
+    volatile int count;
+    volatile int lock;
+
+public:
+    __attribute__((always_inline)) int32_t get(uint64_t self) {
+        // Threads are only ever appended, so we can search the
+        // entries published so far without the lock.
+        int n = count;
+        for (int i = 0; i < n; i++) {
+            if (threads[i] == self) {
+                return i;
+            }
+        }
+        ScopedSpinLock l(&lock);
+        for (int i = n; i < count; i++) {
+            if (threads[i] == self) {
+                return i;
+            }
+        }
+        if (count == max_threads) {
+            // Too many threads to tell apart.
+            return max_threads;
+        }
+        threads[count] = self;
+        __sync_synchronize();
+        return count++;
+    }
+};
+
 WEAK TraceBuffer *halide_trace_buffer = NULL;
+WEAK TraceThreadIds *halide_trace_thread_ids = NULL;
 WEAK int halide_trace_file = -1; // -1 indicates uninitialized
 WEAK int halide_trace_file_lock = 0;
 WEAK bool halide_trace_file_initialized = false;
 WEAK void *halide_trace_file_internally_opened = NULL;
+WEAK int halide_trace_timing = -1; // -1 indicates uninitialized
+
+// Whether to record when and on which thread each event happened,
+// which is enabled by setting HL_TRACE_TIMING to a non-zero value.
+WEAK bool halide_trace_timing_enabled(void *user_context) {
+    if (halide_trace_timing < 0) {
+        ScopedSpinLock lock(&halide_trace_file_lock);
+        if (halide_trace_timing < 0) {
+            const char *timing = getenv("HL_TRACE_TIMING");
+            bool enabled = timing && atoi(timing) != 0;
+            if (enabled) {
+                halide_trace_thread_ids = (TraceThreadIds *)malloc(sizeof(TraceThreadIds));
+                memset(halide_trace_thread_ids, 0, sizeof(TraceThreadIds));
+                halide_start_clock(user_context);
+            }
+            __sync_synchronize();
+            halide_trace_timing = enabled ? 1 : 0;
+        }
+    }
+    return halide_trace_timing > 0;
+}
 
 }}}
 
@@ -160,7 +217,9 @@ WEAK int32_t halide_default_trace(void *user_context, const halide_trace_event_t
         uint32_t name_bytes = strlen(e->func) + 1;
         uint32_t trace_tag_bytes = e->trace_tag ? (strlen(e->trace_tag) + 1) : 1;
         uint32_t total_size_without_padding = header_bytes + value_bytes + coords_bytes + name_bytes + trace_tag_bytes;
-        uint32_t total_size = (total_size_without_padding + 3) & ~3;
+        bool timing = halide_trace_timing_enabled(user_context);
+        uint32_t ext_offset = (total_size_without_padding + 3) & ~3;
+        uint32_t total_size = ext_offset + (timing ? (uint32_t)sizeof(halide_trace_packet_ext_t) : 0);
 
         // Claim some space to write to in the trace buffer
         halide_trace_packet_t *packet = halide_trace_buffer->acquire_packet(user_context, fd, total_size);
@@ -186,6 +245,14 @@ WEAK int32_t halide_default_trace(void *user_context, const halide_trace_event_t
         memcpy((void *)packet->func(), e->func, name_bytes);
         memcpy((void *)packet->trace_tag(), e->trace_tag ? e->trace_tag : "", trace_tag_bytes);
 
+        // Record when and on which thread the event happened.
+        if (timing) {
+            halide_trace_packet_ext_t *ext = (halide_trace_packet_ext_t *)((uint8_t *)packet + ext_offset);
+            ext->magic = halide_trace_packet_ext_magic | halide_trace_packet_ext_version;
+            ext->thread_id = halide_trace_thread_ids->get(halide_thread_self());
+            ext->set_time_ns(halide_current_time_ns(user_context));
+        }
+
         // Release it
         halide_trace_buffer->release_packet(packet);
 
@@ -350,6 +417,11 @@ WEAK int32_t halide_trace(void *user_context, const halide_trace_event_t *e) {
 }
 
 WEAK int halide_shutdown_trace() {
+    if (halide_trace_thread_ids) {
+        free(halide_trace_thread_ids);
+        halide_trace_thread_ids = NULL;
+    }
+    halide_trace_timing = -1;
     if (halide_trace_file_internally_opened) {
         int ret = fclose(halide_trace_file_internally_opened);
         halide_trace_file = 0;
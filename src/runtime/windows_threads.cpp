@@ -28,6 +28,9 @@ extern WIN32API void DeleteCriticalSection(CriticalSection *);
 extern WIN32API void EnterCriticalSection(CriticalSection *);
 extern WIN32API void LeaveCriticalSection(CriticalSection *);
 extern WIN32API int32_t WaitForSingleObject(Thread, int32_t timeout);
+extern WIN32API Thread GetCurrentThread();
+extern WIN32API uintptr_t SetThreadAffinityMask(Thread, uintptr_t mask);
+extern WIN32API int32_t SetThreadPriority(Thread, int32_t priority);
 
 } // extern "C"
 
@@ -126,6 +129,33 @@ struct thread_parker {
 
 }}}} // namespace Halide::Runtime::Internal::Synchronization
 
+namespace Halide { namespace Runtime { namespace Internal {
+
+// Used by named thread pools. Only the first processor group (the first
+// 64 CPUs) can be named in the mask.
+WEAK void set_current_thread_cpu_affinity(const uint64_t *mask, int num_words) {
+    if (num_words > 0 && mask[0] != 0) {
+        SetThreadAffinityMask(GetCurrentThread(), (uintptr_t)mask[0]);
+    }
+}
+
+WEAK void set_current_thread_priority(int priority) {
+    // Map the nice value onto the range from THREAD_PRIORITY_LOWEST (-2)
+    // to THREAD_PRIORITY_HIGHEST (2). Note that Windows priorities go
+    // the other way.
+    int32_t p = -priority / 5;
+    p = p < -2 ? -2 : (p > 2 ? 2 : p);
+    SetThreadPriority(GetCurrentThread(), p);
+}
+
+// Whether the thread pool should stop starting tasks of a job. See
+// halide_cancelled.
+WEAK bool job_cancelled(void *user_context) {
+    return halide_cancelled(user_context) != 0;
+}
+
+}}} // namespace Halide::Runtime::Internal
+
 #include "synchronization_common.h"
 
 #include "thread_pool_common.h"
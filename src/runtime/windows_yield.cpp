@@ -7,6 +7,7 @@
 #endif
 
 extern "C" WIN32API int32_t Sleep(int32_t timeout);
+extern "C" WIN32API uint32_t GetCurrentThreadId();
 
 namespace Halide { namespace Runtime { namespace Internal {
 
@@ -14,4 +15,8 @@ WEAK void halide_thread_yield() {
     Sleep(0);
 }
 
+WEAK uint64_t halide_thread_self() {
+    return GetCurrentThreadId();
+}
+
 }}}
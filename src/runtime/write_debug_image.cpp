@@ -1,4 +1,6 @@
 #include "HalideRuntime.h"
+#include "printer.h"
+#include "scoped_mutex_lock.h"
 
 // We support three formats, tiff, mat, and tmp.
 //
@@ -18,6 +20,16 @@
 //
 // It would be nice to use a format that web browsers read and display
 // directly, but those formats don't tend to satisfy the above goals.
+//
+// Any of the formats can be compressed by adding ".lz4" to the end of
+// the filename (e.g. "foo.tmp.lz4"). The file is then an LZ4 frame,
+// which the lz4 command-line tool can decompress, containing the
+// uncompressed file.
+//
+// Files can also be written asynchronously (see
+// halide_set_debug_to_file_async), in which case the file is
+// assembled in memory and handed to a background thread, which
+// compresses it if needed and writes it out.
 
 namespace Halide { namespace Runtime { namespace Internal {
 
@@ -90,36 +102,433 @@ struct halide_tiff_header {
 
 #pragma pack(pop)
 
-WEAK bool ends_with(const char *filename, const char *suffix) {
-    const char *f = filename, *s = suffix;
-    while (*f) f++;
-    while (*s) s++;
-    while (s != suffix && f != filename) {
-        if (*f != *s) return false;
-        f--;
-        s--;
-    }
-    return *f == *s;
+// Check if the first len characters of filename end with suffix.
+WEAK bool ends_with(const char *filename, size_t len, const char *suffix) {
+    size_t suffix_len = strlen(suffix);
+    return len >= suffix_len && memcmp(filename + len - suffix_len, suffix, suffix_len) == 0;
 }
 
-struct ScopedFile {
+// The destination of a debug file: either a file being written
+// directly, or a block of memory that collects the file contents for
+// compression or a background write.
+struct DebugFile {
     void *f;
-    ScopedFile(const char *filename, const char *mode) {
-        f = fopen(filename, mode);
+    uint8_t *data;
+    size_t size, capacity;
+
+    DebugFile() : f(NULL), data(NULL), size(0), capacity(0) {}
+
+    ~DebugFile() {
+        if (f) {
+            fclose(f);
+        }
+        free(data);
     }
-    ~ScopedFile() {
-        fclose(f);
+
+    bool open_file(const char *filename) {
+        f = fopen(filename, "wb");
+        return f != NULL;
+    }
+
+    bool open_memory(size_t initial_capacity) {
+        data = (uint8_t *)malloc(initial_capacity);
+        capacity = initial_capacity;
+        return data != NULL;
     }
+
     bool write(const void *ptr, size_t bytes) {
-        return fwrite(ptr, bytes, 1, f);
+        if (f) {
+            return fwrite(ptr, bytes, 1, f);
+        }
+        if (size + bytes > capacity) {
+            size_t new_capacity = capacity * 2;
+            if (new_capacity < size + bytes) {
+                new_capacity = size + bytes;
+            }
+            uint8_t *new_data = (uint8_t *)malloc(new_capacity);
+            if (!new_data) {
+                return false;
+            }
+            memcpy(new_data, data, size);
+            free(data);
+            data = new_data;
+            capacity = new_capacity;
+        }
+        memcpy(data + size, ptr, bytes);
+        size += bytes;
+        return true;
+    }
+
+    // Take ownership of the memory written so far.
+    uint8_t *release() {
+        uint8_t *result = data;
+        data = NULL;
+        return result;
+    }
+};
+
+// A minimal LZ4 compressor, producing the LZ4 frame format
+// (https://github.com/lz4/lz4/blob/dev/doc/lz4_Frame_format.md). It
+// does a greedy search for matches using a small hash table, which is
+// fast and does well on the smooth or sparse data typical of
+// intermediate Funcs.
+
+#define LZ4_MAX_BLOCK_SIZE (4 * 1024 * 1024)
+#define LZ4_HASH_BITS 12
+#define LZ4_MIN_MATCH 4
+// The last match must start at least this many bytes before the end
+// of a block, and the last this many bytes must be literals.
+#define LZ4_MATCH_LIMIT 12
+#define LZ4_LAST_LITERALS 5
+
+WEAK uint32_t load_u32(const uint8_t *p) {
+    uint32_t result;
+    memcpy(&result, p, 4);
+    return result;
+}
+
+WEAK void store_u32_le(uint8_t *p, uint32_t x) {
+    p[0] = x & 0xff;
+    p[1] = (x >> 8) & 0xff;
+    p[2] = (x >> 16) & 0xff;
+    p[3] = x >> 24;
+}
+
+// The 32-bit xxHash of a short (under 16 bytes) string, which is all
+// the frame header checksum needs.
+WEAK uint32_t xxhash32_short(const uint8_t *p, size_t len) {
+    const uint32_t prime1 = 2654435761U, prime2 = 2246822519U, prime3 = 3266489917U;
+    const uint32_t prime4 = 668265263U, prime5 = 374761393U;
+    uint32_t h = prime5 + (uint32_t)len;
+    for (; len >= 4; p += 4, len -= 4) {
+        h += load_u32(p) * prime3;
+        h = ((h << 17) | (h >> 15)) * prime4;
+    }
+    for (; len > 0; p++, len--) {
+        h += (*p) * prime5;
+        h = ((h << 11) | (h >> 21)) * prime1;
+    }
+    h ^= h >> 15;
+    h *= prime2;
+    h ^= h >> 13;
+    h *= prime3;
+    h ^= h >> 16;
+    return h;
+}
+
+WEAK uint8_t *lz4_write_length(uint8_t *op, size_t len) {
+    for (; len >= 255; len -= 255) {
+        *op++ = 255;
+    }
+    *op++ = (uint8_t)len;
+    return op;
+}
+
+// Compress one block into dst, which must have room for
+// lz4_max_compressed_size(n) bytes. Returns the compressed size.
+WEAK size_t lz4_compress_block(const uint8_t *src, size_t n, uint8_t *dst, uint32_t *table) {
+    uint8_t *op = dst;
+    const uint8_t *anchor = src;
+    if (n > LZ4_MATCH_LIMIT) {
+        memset(table, 0, sizeof(uint32_t) << LZ4_HASH_BITS);
+        const uint8_t *ip = src;
+        const uint8_t *match_limit = src + n - LZ4_MATCH_LIMIT;
+        const uint8_t *match_end_limit = src + n - LZ4_LAST_LITERALS;
+        while (ip < match_limit) {
+            uint32_t seq = load_u32(ip);
+            uint32_t h = (seq * 2654435761U) >> (32 - LZ4_HASH_BITS);
+            const uint8_t *ref = src + table[h];
+            table[h] = (uint32_t)(ip - src);
+            if (ref >= ip || ip - ref > 65535 || load_u32(ref) != seq) {
+                // Skip ahead faster the longer it has been since the
+                // last match, so incompressible data is cheap.
+                ip += 1 + ((ip - anchor) >> 6);
+                continue;
+            }
+
+            const uint8_t *match_end = ip + LZ4_MIN_MATCH;
+            const uint8_t *r = ref + LZ4_MIN_MATCH;
+            while (match_end < match_end_limit && *match_end == *r) {
+                match_end++;
+                r++;
+            }
+
+            size_t literals = ip - anchor;
+            size_t match_len = match_end - ip - LZ4_MIN_MATCH;
+            uint8_t *token = op++;
+            *token = (uint8_t)(((literals < 15 ? literals : 15) << 4) | (match_len < 15 ? match_len : 15));
+            if (literals >= 15) {
+                op = lz4_write_length(op, literals - 15);
+            }
+            memcpy(op, anchor, literals);
+            op += literals;
+            size_t offset = ip - ref;
+            *op++ = offset & 0xff;
+            *op++ = offset >> 8;
+            if (match_len >= 15) {
+                op = lz4_write_length(op, match_len - 15);
+            }
+            ip = anchor = match_end;
+        }
+    }
+
+    // The remaining bytes are literals.
+    size_t literals = src + n - anchor;
+    *op++ = (uint8_t)((literals < 15 ? literals : 15) << 4);
+    if (literals >= 15) {
+        op = lz4_write_length(op, literals - 15);
+    }
+    memcpy(op, anchor, literals);
+    op += literals;
+    return op - dst;
+}
+
+WEAK size_t lz4_max_compressed_size(size_t n) {
+    return n + n / 255 + 16;
+}
+
+// Compress data into an LZ4 frame in a new allocation. Returns NULL
+// if out of memory.
+WEAK uint8_t *lz4_compress_frame(const uint8_t *data, size_t size, size_t *compressed_size) {
+    size_t blocks = (size + LZ4_MAX_BLOCK_SIZE - 1) / LZ4_MAX_BLOCK_SIZE;
+    size_t max_size = 7 + blocks * (4 + lz4_max_compressed_size(LZ4_MAX_BLOCK_SIZE)) + 4;
+    uint8_t *result = (uint8_t *)malloc(max_size);
+    uint32_t *table = (uint32_t *)malloc(sizeof(uint32_t) << LZ4_HASH_BITS);
+    if (!result || !table) {
+        free(result);
+        free(table);
+        return NULL;
+    }
+
+    // The frame header: the magic number, then flags for version 1
+    // with independent blocks and no checksums, then the maximum
+    // block size (4MB), then a checksum of the flags.
+    uint8_t *op = result;
+    store_u32_le(op, 0x184D2204);
+    op[4] = 0x60;
+    op[5] = 0x70;
+    op[6] = (xxhash32_short(op + 4, 2) >> 8) & 0xff;
+    op += 7;
+
+    for (size_t i = 0; i < size; i += LZ4_MAX_BLOCK_SIZE) {
+        size_t n = size - i < LZ4_MAX_BLOCK_SIZE ? size - i : LZ4_MAX_BLOCK_SIZE;
+        size_t c = lz4_compress_block(data + i, n, op + 4, table);
+        if (c >= n) {
+            // Store incompressible blocks as-is.
+            store_u32_le(op, (uint32_t)n | 0x80000000U);
+            memcpy(op + 4, data + i, n);
+            c = n;
+        } else {
+            store_u32_le(op, (uint32_t)c);
+        }
+        op += 4 + c;
+    }
+    // The end mark.
+    store_u32_le(op, 0);
+    op += 4;
+
+    free(table);
+    *compressed_size = op - result;
+    return result;
+}
+
+// Write out a debug file that has been assembled in memory,
+// compressing it first if requested.
+WEAK int write_debug_file(void *user_context, const char *filename,
+                          const uint8_t *data, size_t size, bool compress) {
+    uint8_t *compressed = NULL;
+    if (compress) {
+        compressed = lz4_compress_frame(data, size, &size);
+        if (!compressed) {
+            return -17;
+        }
+        data = compressed;
     }
-    bool open() const {
-        return f;
+    int result = 0;
+    void *f = fopen(filename, "wb");
+    if (!f) {
+        result = -2;
+    } else {
+        if (!fwrite(data, size, 1, f)) {
+            result = -18;
+        }
+        fclose(f);
     }
+    free(compressed);
+    return result;
+}
+
+// The state for asynchronous debug_to_file calls. A single background
+// thread writes out a queue of files that have been assembled in
+// memory.
+struct debug_file_write {
+    debug_file_write *next;
+    uint8_t *data;
+    size_t size;
+    bool compress;
+    // The filename is stored after the struct, in the same allocation.
+    char filename[1];
+};
+
+// The most memory the queued writes may use before debug_to_file
+// waits for the background thread to catch up.
+#define MAX_PENDING_DEBUG_FILE_BYTES ((size_t)512 * 1024 * 1024)
+
+struct debug_file_writer_state {
+    halide_mutex mutex;
+    // Signalled when a write is queued or finished, or on shutdown.
+    halide_cond cond;
+    debug_file_write *head, *tail;
+    // The writes that are queued or in progress.
+    int pending;
+    size_t pending_bytes;
+    // The number of writes that failed since the last call to
+    // halide_debug_to_file_wait.
+    int failures;
+    halide_thread *thread;
+    bool shutdown;
+    // -1 until set by halide_set_debug_to_file_async or read from
+    // the environment.
+    int async;
 };
 
+WEAK debug_file_writer_state debug_file_writer = {{{0}}, {{0}}, NULL, NULL, 0, 0, 0, NULL, false, -1};
+
+WEAK bool debug_to_file_async(void *user_context) {
+    debug_file_writer_state &s = debug_file_writer;
+    if (s.async < 0) {
+        char *async_str = getenv("HL_DEBUG_TO_FILE_ASYNC");
+        s.async = async_str && atoi(async_str) != 0;
+    }
+    return s.async;
+}
+
+WEAK void debug_file_writer_thread(void *) {
+    debug_file_writer_state &s = debug_file_writer;
+    halide_mutex_lock(&s.mutex);
+    while (true) {
+        while (!s.head && !s.shutdown) {
+            halide_cond_wait(&s.cond, &s.mutex);
+        }
+        if (!s.head) {
+            break;
+        }
+        debug_file_write *w = s.head;
+        s.head = w->next;
+        if (!s.head) {
+            s.tail = NULL;
+        }
+        halide_mutex_unlock(&s.mutex);
+
+        int result = write_debug_file(NULL, w->filename, w->data, w->size, w->compress);
+        if (result != 0) {
+            error(NULL) << "Asynchronous debug_to_file of " << w->filename
+                        << " failed with error " << result << "\n";
+        }
+        size_t bytes = w->size;
+        free(w->data);
+        free(w);
+
+        halide_mutex_lock(&s.mutex);
+        s.pending--;
+        s.pending_bytes -= bytes;
+        if (result != 0) {
+            s.failures++;
+        }
+        halide_cond_broadcast(&s.cond);
+    }
+    halide_mutex_unlock(&s.mutex);
+}
+
+// Hand a file assembled in memory to the background thread, which
+// takes ownership of data. Returns false if it couldn't, in which case
+// the caller still owns data.
+WEAK bool queue_debug_file(void *user_context, const char *filename, uint8_t *data, size_t size, bool compress) {
+    size_t filename_len = strlen(filename);
+    debug_file_write *w = (debug_file_write *)malloc(sizeof(debug_file_write) + filename_len);
+    if (!w) {
+        return false;
+    }
+    w->next = NULL;
+    w->data = data;
+    w->size = size;
+    w->compress = compress;
+    memcpy(w->filename, filename, filename_len + 1);
+
+    debug_file_writer_state &s = debug_file_writer;
+    ScopedMutexLock lock(&s.mutex);
+    if (!s.thread) {
+        s.shutdown = false;
+        s.thread = halide_spawn_thread(debug_file_writer_thread, NULL);
+        if (!s.thread) {
+            free(w);
+            return false;
+        }
+    }
+    // Bound the memory held by queued writes.
+    while (s.pending_bytes > 0 && s.pending_bytes + size > MAX_PENDING_DEBUG_FILE_BYTES) {
+        halide_cond_wait(&s.cond, &s.mutex);
+    }
+    if (s.tail) {
+        s.tail->next = w;
+    } else {
+        s.head = w;
+    }
+    s.tail = w;
+    s.pending++;
+    s.pending_bytes += size;
+    halide_cond_broadcast(&s.cond);
+    return true;
+}
+
 }}} // namespace Halide::Runtime::Internal
 
+extern "C" {
+
+WEAK int halide_set_debug_to_file_async(int async) {
+    debug_file_writer_state &s = debug_file_writer;
+    ScopedMutexLock lock(&s.mutex);
+    int old = debug_to_file_async(NULL);
+    s.async = async != 0;
+    return old;
+}
+
+WEAK int halide_debug_to_file_wait(void *user_context) {
+    debug_file_writer_state &s = debug_file_writer;
+    ScopedMutexLock lock(&s.mutex);
+    while (s.pending > 0) {
+        halide_cond_wait(&s.cond, &s.mutex);
+    }
+    int failures = s.failures;
+    s.failures = 0;
+    return failures ? halide_error_code_debug_to_file_failed : 0;
+}
+
+}  // extern "C"
+
+namespace {
+
+// Finish any asynchronous writes at exit. This isn't safe to do from
+// a static destructor on Windows (see halide_profiler_shutdown), so
+// there halide_debug_to_file_wait must be called before exiting.
+#ifndef WINDOWS
+__attribute__((destructor))
+#endif
+WEAK void halide_debug_to_file_cleanup() {
+    debug_file_writer_state &s = debug_file_writer;
+    halide_mutex_lock(&s.mutex);
+    halide_thread *thread = s.thread;
+    s.shutdown = true;
+    s.thread = NULL;
+    halide_cond_broadcast(&s.cond);
+    halide_mutex_unlock(&s.mutex);
+    if (thread) {
+        halide_join_thread(thread);
+    }
+}
+
+}
+
 WEAK extern "C" int32_t halide_debug_to_file(void *user_context, const char *filename,
                                              int32_t type_code, struct halide_buffer_t *buf) {
 
@@ -130,8 +539,25 @@ WEAK extern "C" int32_t halide_debug_to_file(void *user_context, const char *fil
 
     halide_copy_to_host(user_context, buf);
 
-    ScopedFile f(filename, "wb");
-    if (!f.open()) return -2;
+    // The format is given by the filename without any ".lz4".
+    size_t name_len = strlen(filename);
+    bool compress = ends_with(filename, name_len, ".lz4");
+    if (compress) {
+        name_len -= 4;
+    }
+
+    // Compressed and asynchronous files are assembled in memory
+    // first. Everything else is written directly.
+    bool async = debug_to_file_async(user_context);
+    DebugFile f;
+    if (compress || async) {
+        // Room for the payload plus the largest header.
+        if (!f.open_memory(buf->size_in_bytes() + 512)) {
+            return -17;
+        }
+    } else if (!f.open_file(filename)) {
+        return -2;
+    }
 
     size_t elts = 1;
     halide_dimension_t shape[4];
@@ -148,7 +574,7 @@ WEAK extern "C" int32_t halide_debug_to_file(void *user_context, const char *fil
 
     uint32_t final_padding_bytes = 0;
 
-    if (ends_with(filename, ".tiff") || ends_with(filename, ".tif")) {
+    if (ends_with(filename, name_len, ".tiff") || ends_with(filename, name_len, ".tif")) {
         int32_t channels;
         int32_t width = shape[0].extent;
         int32_t height = shape[1].extent;
@@ -223,11 +649,10 @@ WEAK extern "C" int32_t halide_debug_to_file(void *user_context, const char *fil
                 }
             }
         }
-    } else if (ends_with(filename, ".mat")) {
+    } else if (ends_with(filename, name_len, ".mat")) {
         // Construct a name for the array from the filename
         const char *start, *end;
-        for (end = filename; *end; end++);
-        for (; *end != '.'; end--);
+        for (end = filename + name_len - 1; *end != '.'; end--);
         for (start = end; start != filename && start[-1] != '/'; start--);
         uint32_t name_size = (uint32_t)(end - start);
         char array_name[256];
@@ -319,6 +744,20 @@ WEAK extern "C" int32_t halide_debug_to_file(void *user_context, const char *fil
     for (int32_t dim3 = shape[3].min; dim3 < shape[3].extent + shape[3].min; ++dim3) {
         for (int32_t dim2 = shape[2].min; dim2 < shape[2].extent + shape[2].min; ++dim2) {
             for (int32_t dim1 = shape[1].min; dim1 < shape[1].extent + shape[1].min; ++dim1) {
+                if (shape[0].stride == 1) {
+                    // Rows are dense, so write them directly.
+                    if (counter > 0) {
+                        if (!f.write((void *)temp, counter * bytes_per_element)) {
+                            return -13;
+                        }
+                        counter = 0;
+                    }
+                    int idx[] = {shape[0].min, dim1, dim2, dim3};
+                    if (!f.write(buf->address_of(idx), shape[0].extent * bytes_per_element)) {
+                        return -13;
+                    }
+                    continue;
+                }
                 for (int32_t dim0 = shape[0].min; dim0 < shape[0].extent + shape[0].min; ++dim0) {
                     counter++;
                     int idx[] = {dim0, dim1, dim2, dim3};
@@ -353,5 +792,15 @@ WEAK extern "C" int32_t halide_debug_to_file(void *user_context, const char *fil
         }
     }
 
-    return 0;
+    if (f.f) {
+        return 0;
+    }
+
+    // The file was assembled in memory. Hand it to the background
+    // thread, or write it out now if that's not possible.
+    if (async && queue_debug_file(user_context, filename, f.data, f.size, compress)) {
+        f.release();
+        return 0;
+    }
+    return write_debug_file(user_context, filename, f.data, f.size, compress);
 }
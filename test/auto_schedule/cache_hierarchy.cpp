@@ -0,0 +1,87 @@
+#include "Halide.h"
+#include "halide_benchmark.h"
+
+using namespace Halide;
+using namespace Halide::Tools;
+
+double run_test(const MachineParams &params, Buffer<float> input, Buffer<float> output) {
+    Var x("x"), y("y");
+
+    Func in_b = BoundaryConditions::repeat_edge(input);
+
+    Func blur_x("blur_x"), blur_y("blur_y"), diff("diff"), out("out");
+    blur_x(x, y) = (in_b(x - 2, y) + in_b(x - 1, y) + in_b(x, y) + in_b(x + 1, y) + in_b(x + 2, y)) / 5;
+    blur_y(x, y) = (blur_x(x, y - 2) + blur_x(x, y - 1) + blur_x(x, y) + blur_x(x, y + 1) + blur_x(x, y + 2)) / 5;
+    diff(x, y) = in_b(x, y) - blur_y(x, y);
+    out(x, y) = blur_y(x, y) + 2 * diff(x, y);
+
+    // Provide estimates on the pipeline output
+    out.estimate(x, 0, output.width()).estimate(y, 0, output.height());
+
+    // Auto-schedule the pipeline
+    Target target = get_jit_target_from_environment();
+    Pipeline p(out);
+    p.auto_schedule(target, params);
+
+    // Inspect the schedule
+    out.print_loop_nest();
+
+    // Benchmark the schedule
+    double t = benchmark(3, 10, [&]() {
+        p.realize(output);
+    });
+
+    return t * 1000;
+}
+
+int main(int argc, char **argv) {
+    // Check that the cache hierarchy survives a round trip through the
+    // canonical string form, and that the old three-value form still
+    // parses.
+    MachineParams host = MachineParams::host();
+    MachineParams parsed(host.to_string());
+    if (parsed.to_string() != host.to_string()) {
+        printf("MachineParams round trip failed: %s vs %s\n",
+               host.to_string().c_str(), parsed.to_string().c_str());
+        return -1;
+    }
+    MachineParams generic(MachineParams::generic().to_string());
+    if (!is_zero(generic.l1_cache_size) || !is_zero(generic.l2_cache_size)) {
+        printf("Generic MachineParams should not specify L1/L2 cache sizes\n");
+        return -1;
+    }
+    printf("Host MachineParams: %s\n", host.to_string().c_str());
+
+    const int W = 2048, H = 2048;
+    Buffer<float> input(W, H);
+    for (int y = 0; y < input.height(); y++) {
+        for (int x = 0; x < input.width(); x++) {
+            input(x, y) = rand() & 0xfff;
+        }
+    }
+
+    Buffer<float> generic_out(W, H), host_out(W, H);
+    double generic_time = run_test(MachineParams::generic(), input, generic_out);
+    double host_time = run_test(host, input, host_out);
+
+    for (int y = 0; y < H; y++) {
+        for (int x = 0; x < W; x++) {
+            float a = generic_out(x, y), b = host_out(x, y);
+            if (std::abs(a - b) > 0.01f) {
+                printf("Mismatch at %d %d: %f vs %f\n", x, y, a, b);
+                return -1;
+            }
+        }
+    }
+
+    std::cout << "======================" << std::endl;
+    std::cout << "Generic MachineParams time: " << generic_time << "ms" << std::endl;
+    std::cout << "Host MachineParams time: " << host_time << "ms" << std::endl;
+    std::cout << "======================" << std::endl;
+
+    // The timings are only reported. They vary too much from machine
+    // to machine to be compared here.
+
+    printf("Success!\n");
+    return 0;
+}
@@ -0,0 +1,71 @@
+#include "Halide.h"
+
+using namespace Halide;
+
+int main(int argc, char **argv) {
+    int W = 2000;
+    int H = 2000;
+    Buffer<uint16_t> input(W, H);
+
+    for (int y = 0; y < input.height(); y++) {
+        for (int x = 0; x < input.width(); x++) {
+            input(x, y) = rand() & 0xfff;
+        }
+    }
+
+    Var x("x"), y("y");
+
+    // Two independent consumers of the same large input. Computing them with
+    // each other lets the second one read the input while it is still in cache.
+    Func blur_x("blur_x");
+    blur_x(x, y) = (input(x, y) + input(x + 1, y) + input(x + 2, y)) / 3;
+
+    Func blur_y("blur_y");
+    blur_y(x, y) = (input(x, y) + input(x, y + 1) + input(x, y + 2)) / 3;
+
+    // Provide estimates on the pipeline outputs
+    blur_x.estimate(x, 0, W - 2).estimate(y, 0, H - 2);
+    blur_y.estimate(x, 0, W - 2).estimate(y, 0, H - 2);
+
+    // Auto-schedule the pipeline
+    Pipeline test({blur_x, blur_y});
+
+    Target target = get_jit_target_from_environment();
+    std::string schedule = test.auto_schedule(target);
+
+    // Inspect the schedule
+    std::cout << schedule << "\n";
+    blur_x.print_loop_nest();
+    blur_y.print_loop_nest();
+
+    // Correct output doesn't show that the siblings were fused, so
+    // check the schedule for it.
+    if (schedule.find(".compute_with(blur_x,") == std::string::npos &&
+        schedule.find(".compute_with(blur_y,") == std::string::npos) {
+        printf("The auto-scheduler did not compute blur_x and blur_y with each other\n");
+        return -1;
+    }
+
+    Buffer<uint16_t> out_1(W - 2, H - 2), out_2(W - 2, H - 2);
+
+    // Run the schedule
+    test.realize({out_1, out_2});
+
+    for (int y = 0; y < H - 2; y++) {
+        for (int x = 0; x < W - 2; x++) {
+            uint16_t correct_1 = (input(x, y) + input(x + 1, y) + input(x + 2, y)) / 3;
+            uint16_t correct_2 = (input(x, y) + input(x, y + 1) + input(x, y + 2)) / 3;
+            if (out_1(x, y) != correct_1) {
+                printf("blur_x(%d, %d) = %d instead of %d\n", x, y, out_1(x, y), correct_1);
+                return -1;
+            }
+            if (out_2(x, y) != correct_2) {
+                printf("blur_y(%d, %d) = %d instead of %d\n", x, y, out_2(x, y), correct_2);
+                return -1;
+            }
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
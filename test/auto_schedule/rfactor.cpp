@@ -0,0 +1,86 @@
+#include "Halide.h"
+#include "halide_benchmark.h"
+
+using namespace Halide;
+using namespace Halide::Tools;
+
+// A large dot product and a 2D maximum, neither of which has any pure
+// dimensions to parallelize over unless the reduction is rfactored.
+double run_test(bool auto_schedule, Buffer<float> a, Buffer<float> b, Buffer<float> im,
+                float &dot_result, float &max_result) {
+    RDom r(0, a.width());
+    Func dot("dot");
+    dot() = 0.0f;
+    dot() += a(r) * b(r);
+
+    RDom r2(0, im.width(), 0, im.height());
+    Func max_val("max_val");
+    max_val() = im(0, 0);
+    max_val() = max(max_val(), im(r2.x, r2.y));
+
+    Target target = get_jit_target_from_environment();
+    Pipeline p({dot, max_val});
+
+    if (auto_schedule) {
+        // Auto-schedule the pipeline
+        p.auto_schedule(target);
+    }
+
+    // Inspect the schedule
+    dot.print_loop_nest();
+    max_val.print_loop_nest();
+
+    // Benchmark the schedule
+    Buffer<float> dot_out = Buffer<float>::make_scalar();
+    Buffer<float> max_out = Buffer<float>::make_scalar();
+    double t = benchmark(3, 10, [&]() {
+        p.realize({dot_out, max_out});
+    });
+    dot_result = dot_out();
+    max_result = max_out();
+
+    return t * 1000;
+}
+
+int main(int argc, char **argv) {
+    const int size = 1 << 22;
+    const int W = 4096, H = 4096;
+
+    // Both runs must see the same inputs for their results to match.
+    Buffer<float> a(size), b(size), im(W, H);
+    for (int i = 0; i < size; i++) {
+        a(i) = rand() % 2;
+        b(i) = rand() % 2;
+    }
+    for (int y = 0; y < H; y++) {
+        for (int x = 0; x < W; x++) {
+            im(x, y) = rand() & 0xfff;
+        }
+    }
+
+    float manual_dot, manual_max, auto_dot, auto_max;
+    double manual_time = run_test(false, a, b, im, manual_dot, manual_max);
+    double auto_time = run_test(true, a, b, im, auto_dot, auto_max);
+
+    // The dot product inputs are all 0 or 1, so the sum is exact
+    // regardless of the order of summation.
+    if (manual_dot != auto_dot || manual_max != auto_max) {
+        printf("Mismatch: dot %f vs %f, max %f vs %f\n",
+               manual_dot, auto_dot, manual_max, auto_max);
+        return -1;
+    }
+
+    std::cout << "======================" << std::endl;
+    std::cout << "Serial time: " << manual_time << "ms" << std::endl;
+    std::cout << "Auto time: " << auto_time << "ms" << std::endl;
+    std::cout << "======================" << std::endl;
+
+    if (!get_jit_target_from_environment().has_gpu_feature() &&
+        (auto_time > manual_time * 1.5)) {
+        printf("Auto-scheduler should not be slower than the serial reduction.\n");
+        return -1;
+    }
+
+    printf("Success!\n");
+    return 0;
+}
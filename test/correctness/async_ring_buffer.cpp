@@ -0,0 +1,150 @@
+#include "Halide.h"
+#include <atomic>
+#include <stdio.h>
+
+using namespace Halide;
+
+#ifdef _WIN32
+#define DLLEXPORT __declspec(dllexport)
+#else
+#define DLLEXPORT
+#endif
+
+int ring_depth = 0;
+int frames_decoded = 0;
+std::atomic<int> last_frame_read(-1);
+
+// Imagine that this is a video decoder, which writes the next frame
+// into its output every time it is called.
+extern "C" DLLEXPORT int decode_next_frame(halide_buffer_t *out) {
+    if (out->is_bounds_query()) {
+        // We're ok with any requested output size.
+        return 0;
+    }
+    int frame = frames_decoded++;
+
+    // The producer must not get more than the depth of the ring
+    // ahead of the consumer, or it would be clobbering a frame that
+    // hasn't been read yet.
+    if (frame - ring_depth > last_frame_read) {
+        printf("Decoding frame %d, but the consumer has only read up to frame %d\n",
+               frame, last_frame_read.load());
+        exit(-1);
+    }
+
+    for (int y = 0; y < out->dim[1].extent; y++) {
+        int *dst = (int *)out->host + y * out->dim[1].stride;
+        for (int x = 0; x < out->dim[0].extent; x++) {
+            dst[x] = frame * 1000 + (x + out->dim[0].min) + (y + out->dim[1].min);
+        }
+    }
+    return 0;
+}
+
+extern "C" DLLEXPORT int read_frame(int value, int t) {
+    int last = last_frame_read;
+    while (t > last && !last_frame_read.compare_exchange_weak(last, t)) {
+    }
+
+    // Take a while, so that the decoder has a chance to run ahead.
+    float f = 3.0f;
+    for (int i = 0; i < (1 << 8); i++) {
+        f = sqrtf(sinf(cosf(f)));
+    }
+    if (f < 0) return 3;
+    return value;
+}
+HalideExtern_2(int, read_frame, int, int);
+
+bool error_occurred = false;
+void my_error_handler(void *user_context, const char *msg) {
+    error_occurred = true;
+}
+
+int main(int argc, char **argv) {
+    // An extern producer that writes the same region on every
+    // iteration of the consumer, ring-buffered so it can decode
+    // frames ahead of the consumer.
+    for (int depth : {1, 2, 4}) {
+        Func decoded, consumer;
+        Var x, y, t;
+
+        decoded.define_extern("decode_next_frame", {}, Int(32), 2);
+        consumer(x, y, t) = read_frame(decoded(x, y), t);
+        decoded.compute_at(consumer, t).store_root().async().ring_buffer(depth);
+
+        ring_depth = depth;
+        frames_decoded = 0;
+        last_frame_read = -1;
+        Buffer<int> out = consumer.realize(16, 16, 20);
+
+        out.for_each_element([&](int x, int y, int t) {
+                int correct = t * 1000 + x + y;
+                if (out(x, y, t) != correct) {
+                    printf("depth %d: out(%d, %d, %d) = %d instead of %d\n",
+                           depth, x, y, t, out(x, y, t), correct);
+                    exit(-1);
+                }
+            });
+    }
+
+    // A Halide producer computed per tile, so there are several loops
+    // between the store and compute levels.
+    {
+        Func producer, consumer;
+        Var x, y, xo, yo, xi, yi;
+
+        producer(x, y) = x + y;
+        consumer(x, y) = producer(x - 1, y) + producer(x + 1, y);
+        consumer.compute_root().tile(x, y, xo, yo, xi, yi, 8, 8);
+        producer.compute_at(consumer, xo).store_root().async().ring_buffer(3);
+
+        Buffer<int> out = consumer.realize(40, 40);
+
+        out.for_each_element([&](int x, int y) {
+                int correct = 2 * (x + y);
+                if (out(x, y) != correct) {
+                    printf("out(%d, %d) = %d instead of %d\n",
+                           x, y, out(x, y), correct);
+                    exit(-1);
+                }
+            });
+    }
+
+    // The depth can be a Param. A depth below one is a runtime error.
+    {
+        Func producer, consumer;
+        Var x, y;
+        Param<int> depth;
+
+        producer(x, y) = x + y;
+        consumer(x, y) = producer(x, y - 1) + producer(x, y + 1);
+        producer.compute_at(consumer, y).store_root().async().ring_buffer(depth);
+        consumer.set_error_handler(my_error_handler);
+
+        depth.set(2);
+        Buffer<int> out = consumer.realize(16, 16);
+        out.for_each_element([&](int x, int y) {
+                int correct = 2 * (x + y);
+                if (out(x, y) != correct) {
+                    printf("Param depth: out(%d, %d) = %d instead of %d\n",
+                           x, y, out(x, y), correct);
+                    exit(-1);
+                }
+            });
+        if (error_occurred) {
+            printf("Unexpected error with a ring_buffer depth of 2\n");
+            return -1;
+        }
+
+        depth.set(0);
+        consumer.realize(out);
+        if (!error_occurred) {
+            printf("There should have been an error with a ring_buffer depth of 0\n");
+            return -1;
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
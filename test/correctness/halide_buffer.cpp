@@ -2,9 +2,27 @@
 #include "HalideBuffer.h"
 
 #include <stdio.h>
+#include <atomic>
+#include <thread>
+#include <vector>
 
 using namespace Halide::Runtime;
 
+// A parallel-for executor for the Buffer methods that split their
+// work into tasks, which runs each task on its own thread.
+std::atomic<int> tasks_run(0);
+int spawn_thread_per_task(void *user_context, halide_task_t f, int min, int extent, uint8_t *closure) {
+    std::vector<std::thread> threads;
+    for (int i = min; i < min + extent; i++) {
+        threads.emplace_back([=]() { f(user_context, i, closure); });
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+    tasks_run += extent;
+    return 0;
+}
+
 template<typename T1, typename T2>
 void check_equal_shape(const Buffer<T1> &a, const Buffer<T2> &b) {
     if (a.dimensions() != b.dimensions()) abort();
@@ -355,6 +373,56 @@ int main(int argc, char **argv) {
         assert(d.all_equal(4));
     }
 
+    {
+        // Check the parallel versions of fill, copy_from,
+        // for_each_value, and for_each_element.
+        Buffer<>::set_parallel_for(spawn_thread_per_task);
+
+        Buffer<int> a = Buffer<int>::make_interleaved(1000, 600, 3);
+        a.fill(7);
+        if (tasks_run == 0 || !a.all_equal(7)) {
+            printf("parallel fill failed\n");
+            abort();
+        }
+
+        Buffer<int> b(1000, 600, 3);
+        b.for_each_element_parallel([&](int x, int y, int c) {
+            b(x, y, c) = x + y * 1000 + c * 1000000;
+        });
+        b.for_each_element([&](int x, int y, int c) {
+            if (b(x, y, c) != x + y * 1000 + c * 1000000) {
+                printf("parallel for_each_element failed\n");
+                abort();
+            }
+        });
+
+        a.copy_from(b);
+        check_equal(a, b);
+
+        std::atomic<int> count(0);
+        a.for_each_value_parallel([&](int &a, int b) { a += b; count++; }, b);
+        if (count != 1000 * 600 * 3) {
+            printf("parallel for_each_value visited %d values instead of %d\n", count.load(), 1000 * 600 * 3);
+            abort();
+        }
+        a.for_each_element([&](int x, int y, int c) {
+            if (a(x, y, c) != 2 * b(x, y, c)) {
+                printf("parallel for_each_value failed\n");
+                abort();
+            }
+        });
+
+        // Small buffers are not split.
+        int before = tasks_run;
+        Buffer<int>(10, 10).fill(0);
+        if (tasks_run != before) {
+            printf("small fill was split into tasks\n");
+            abort();
+        }
+
+        Buffer<>::set_parallel_for(nullptr);
+    }
+
     printf("Success!\n");
     return 0;
 }
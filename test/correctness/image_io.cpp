@@ -40,6 +40,45 @@ void test_round_trip(Buffer<T> buf, std::string format) {
     }
 }
 
+// Check that load_mapped() sees the same pixels as load(), and that
+// writing the file in chunks with an ImageStreamWriter produces the
+// same file as save().
+template<typename T>
+void test_mapped_and_streamed(Buffer<T> buf, std::string format) {
+    std::ostringstream o;
+    o << Internal::get_test_tmp_dir() << "test_stream_" << halide_type_of<T>() << "x" << buf.channels() << "." << format;
+    std::string filename = o.str();
+
+    std::vector<int> extents;
+    for (int d = 0; d < buf.dimensions(); ++d) {
+        extents.push_back(buf.dim(d).extent());
+    }
+    {
+        Tools::ImageStreamWriter<Buffer<T>, Tools::Internal::CheckFail> writer(filename, halide_type_of<T>(), extents);
+        const int d = writer.streaming_dimension();
+        const int chunk = std::max(1, buf.dim(d).extent() / 3);
+        for (int i = buf.dim(d).min(); i <= buf.dim(d).max(); i += chunk) {
+            Buffer<T> piece = buf;
+            piece.crop(d, i, std::min(chunk, buf.dim(d).max() - i + 1));
+            writer.write(piece);
+        }
+        writer.close();
+    }
+
+    Buffer<T> loaded = Tools::load_image(filename);
+    Buffer<T> mapped = Tools::load_mapped_image(filename);
+    for (int d = 0; d < buf.dimensions(); ++d) {
+        loaded.translate(d, buf.dim(d).min() - loaded.dim(d).min());
+        mapped.translate(d, buf.dim(d).min() - mapped.dim(d).min());
+    }
+    buf.for_each_element([&](const int *pos) {
+        if (loaded(pos) != buf(pos) || mapped(pos) != buf(pos)) {
+            printf("test_mapped_and_streamed: Mismatch for %s\n", filename.c_str());
+            abort();
+        }
+    });
+}
+
 // static -> static conversion test
 template<typename T>
 void test_convert_image_s2s(Buffer<T> buf) {
@@ -179,7 +218,7 @@ void do_test() {
     luma_buf.copy_from(color_buf);
     luma_buf.slice(2);
 
-    std::vector<std::string> formats = {"ppm","pgm","tmp","mat"};
+    std::vector<std::string> formats = {"ppm","pgm","tmp","mat","npy"};
 #ifndef HALIDE_NO_JPEG
     formats.push_back("jpg");
 #endif
@@ -196,6 +235,7 @@ void do_test() {
             Buffer<T> cb4 = color_buf.embedded(color_buf.dimensions());
             std::cout << "Testing format: " << format << " for " << halide_type_of<T>() << "x4\n";
             test_round_trip(cb4, format);
+            test_mapped_and_streamed(cb4, format);
 
             // Here we test matching strides
             Func f2;
@@ -212,11 +252,17 @@ void do_test() {
             std::cout << "Testing format: " << format << " for " << halide_type_of<T>() << "x3\n";
             // pgm really only supports gray images.
             test_round_trip(color_buf, format);
+            if (format != "jpg" && format != "png") {
+                test_mapped_and_streamed(color_buf, format);
+            }
         }
         if (format != "ppm") {
             std::cout << "Testing format: " << format << " for " << halide_type_of<T>() << "x1\n";
             // ppm really only supports RGB images.
             test_round_trip(luma_buf, format);
+            if (format != "jpg" && format != "png") {
+                test_mapped_and_streamed(luma_buf, format);
+            }
         }
     }
 }
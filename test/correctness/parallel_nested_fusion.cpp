@@ -0,0 +1,148 @@
+#include "Halide.h"
+#include <stdio.h>
+
+using namespace Halide;
+
+int launches = 0;
+int tasks = 0;
+
+// Run everything serially, counting how many parallel loops get
+// launched, and how many tasks they have in total.
+int counting_do_par_for(void *user_context, int (*f)(void *, int, uint8_t *),
+                        int min, int extent, uint8_t *closure) {
+    launches++;
+    for (int i = min; i < min + extent; i++) {
+        tasks++;
+        int result = f(user_context, i, closure);
+        if (result) {
+            return result;
+        }
+    }
+    return 0;
+}
+
+int check(Buffer<int> im, int offset) {
+    for (int z = 0; z < im.channels(); z++) {
+        for (int y = 0; y < im.height(); y++) {
+            for (int x = 0; x < im.width(); x++) {
+                int correct = x + 10 * y + 100 * z + offset;
+                if (im(x, y, z) != correct) {
+                    printf("im(%d, %d, %d) = %d instead of %d\n",
+                           x, y, z, im(x, y, z), correct);
+                    return -1;
+                }
+            }
+        }
+    }
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    Var x, y, z;
+
+    // Directly nested parallel loops become a single parallel loop.
+    {
+        Func f;
+        f(x, y, z) = x + 10 * y + 100 * z;
+        f.bound(y, 0, 7).bound(z, 0, 5).parallel(z).parallel(y);
+        f.set_custom_do_par_for(counting_do_par_for);
+
+        launches = tasks = 0;
+        Buffer<int> im = f.realize(8, 7, 5);
+        if (check(im, 0)) {
+            return -1;
+        }
+        if (launches != 1 || tasks != 7 * 5) {
+            printf("parallel(z).parallel(y): %d launches and %d tasks instead of 1 and %d\n",
+                   launches, tasks, 7 * 5);
+            return -1;
+        }
+    }
+
+    // Three deep, with mins that aren't zero.
+    {
+        Func f;
+        f(x, y, z) = x + 10 * y + 100 * z;
+        f.bound(x, -2, 6).bound(y, 1, 4).bound(z, 3, 3);
+        f.parallel(z).parallel(y).parallel(x);
+        f.set_custom_do_par_for(counting_do_par_for);
+
+        launches = tasks = 0;
+        Buffer<int> im(6, 4, 3);
+        im.set_min(-2, 1, 3);
+        f.realize(im);
+        for (int z = 3; z < 6; z++) {
+            for (int y = 1; y < 5; y++) {
+                for (int x = -2; x < 4; x++) {
+                    if (im(x, y, z) != x + 10 * y + 100 * z) {
+                        printf("im(%d, %d, %d) = %d\n", x, y, z, im(x, y, z));
+                        return -1;
+                    }
+                }
+            }
+        }
+        if (launches != 1 || tasks != 6 * 4 * 3) {
+            printf("parallel(z).parallel(y).parallel(x): %d launches and %d tasks instead of 1 and %d\n",
+                   launches, tasks, 6 * 4 * 3);
+            return -1;
+        }
+    }
+
+    // Loops with extents that aren't known at compile time are fused
+    // too, behind a runtime check that the product of their extents
+    // fits in 32 bits.
+    {
+        Func f;
+        f(x, y, z) = x + 10 * y + 100 * z;
+        f.parallel(z).parallel(y);
+        f.set_custom_do_par_for(counting_do_par_for);
+
+        launches = tasks = 0;
+        Buffer<int> im = f.realize(8, 7, 5);
+        if (check(im, 0)) {
+            return -1;
+        }
+        if (launches != 1 || tasks != 7 * 5) {
+            printf("parallel(z).parallel(y) with unknown extents: %d launches and %d tasks instead of 1 and %d\n",
+                   launches, tasks, 7 * 5);
+            return -1;
+        }
+    }
+
+    // A producer computed between two parallel loops stops them from
+    // being fused.
+    {
+        Func f, g;
+        f(x, y, z) = x + 10 * y + 100 * z;
+        g(x, y, z) = f(x, y, z) + 1;
+        g.parallel(z).parallel(y);
+        f.compute_at(g, z).parallel(y);
+        g.set_custom_do_par_for(counting_do_par_for);
+
+        launches = tasks = 0;
+        Buffer<int> im = g.realize(8, 7, 5);
+        if (check(im, 1)) {
+            return -1;
+        }
+        if (launches != 1 + 2 * 5) {
+            printf("compute_at between parallel loops: %d launches instead of %d\n",
+                   launches, 1 + 2 * 5);
+            return -1;
+        }
+    }
+
+    // The default thread pool gets the same results.
+    {
+        Func f;
+        f(x, y, z) = x + 10 * y + 100 * z;
+        f.parallel(z).parallel(y).vectorize(x, 4);
+
+        Buffer<int> im = f.realize(16, 33, 17);
+        if (check(im, 0)) {
+            return -1;
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
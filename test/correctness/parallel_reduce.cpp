@@ -0,0 +1,102 @@
+#include "Halide.h"
+#include <algorithm>
+#include <limits>
+#include <stdio.h>
+
+using namespace Halide;
+
+int main(int argc, char **argv) {
+    Buffer<int> in_buf(1000);
+    in_buf.for_each_element([&](int x) {
+            in_buf(x) = (x * 7919) % 1013 - 500;
+        });
+    // Bounds inference rounds the domains up to whole slices, so read
+    // the input through a boundary condition.
+    Func in = BoundaryConditions::repeat_edge(in_buf);
+
+    // Sum, with a factor that doesn't divide the extent.
+    for (int factor : {1, 3, 8, 2000}) {
+        RDom r(0, in_buf.width());
+        Func f;
+        f() = 0;
+        f() += in(r);
+
+        f.parallel_reduce(r, factor);
+
+        Buffer<int> result = f.realize();
+
+        int correct = 0;
+        for (int x = 0; x < in_buf.width(); x++) {
+            correct += in_buf(x);
+        }
+        if (result() != correct) {
+            printf("factor %d: sum = %d instead of %d\n", factor, result(), correct);
+            return -1;
+        }
+    }
+
+    // A histogram-style reduction with a pure dimension, using a
+    // maximum instead of a sum, on a 2D RDom.
+    {
+        RDom r(0, 40, 0, 25);
+        Var x;
+        Func f;
+        f(x) = std::numeric_limits<int>::min();
+        f(x) = max(f(x), in(r.x + 40 * r.y) * (x + 1));
+
+        f.update(0).parallel_reduce(r.y, 4);
+
+        Buffer<int> result = f.realize(3);
+
+        for (int i = 0; i < 3; i++) {
+            int correct = std::numeric_limits<int>::min();
+            for (int j = 0; j < in_buf.width(); j++) {
+                correct = std::max(correct, in_buf(j) * (i + 1));
+            }
+            if (result(i) != correct) {
+                printf("max(%d) = %d instead of %d\n", i, result(i), correct);
+                return -1;
+            }
+        }
+    }
+
+    // An argmax, which reduces a Tuple with an operator that isn't
+    // commutative: of several maxima, it finds the last one.
+    for (int ties : {0, 1}) {
+        Buffer<int> vals = ties ? Buffer<int>(in_buf.width()) : in_buf;
+        if (ties) {
+            vals.for_each_element([&](int x) {
+                    vals(x) = (x % 100) / 10;
+                });
+        }
+
+        Func vals_in = BoundaryConditions::repeat_edge(vals);
+
+        RDom r(0, vals.width());
+        Func f;
+        f() = Tuple(std::numeric_limits<int>::min(), 0);
+        f() = Tuple(max(f()[0], vals_in(r)),
+                    select(vals_in(r) < f()[0], f()[1], r));
+
+        f.parallel_reduce(r, 7);
+
+        Realization result = f.realize();
+        Buffer<int> max_val = result[0], max_idx = result[1];
+
+        int correct_val = std::numeric_limits<int>::min(), correct_idx = 0;
+        for (int x = 0; x < vals.width(); x++) {
+            if (vals(x) >= correct_val) {
+                correct_val = vals(x);
+                correct_idx = x;
+            }
+        }
+        if (max_val() != correct_val || max_idx() != correct_idx) {
+            printf("argmax = (%d, %d) instead of (%d, %d)\n",
+                   max_val(), max_idx(), correct_val, correct_idx);
+            return -1;
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
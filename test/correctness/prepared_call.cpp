@@ -0,0 +1,74 @@
+#include "Halide.h"
+#include <stdio.h>
+
+using namespace Halide;
+
+int main(int argc, char **argv) {
+    Param<int32_t> offset;
+    ImageParam input(UInt(8), 2);
+
+    Var x("x"), y("y");
+    Func f("f");
+    f(x, y) = cast<uint8_t>(input(x, y) + offset);
+
+    Buffer<uint8_t> in1(10, 10), in2(10, 10);
+    in1.for_each_element([&](int x, int y) { in1(x, y) = x + y * 10; });
+    in2.for_each_element([&](int x, int y) { in2(x, y) = x * 10 + y; });
+
+    Pipeline p(f);
+    input.set(in1);
+    offset.set(1);
+
+    PreparedCall call = p.prepare({10, 10});
+
+    // Realize into the buffers owned by the PreparedCall.
+    Buffer<uint8_t> result = call.realize()[0];
+    result.for_each_element([&](int x, int y) {
+        if (result(x, y) != x + y * 10 + 1) {
+            printf("result(%d, %d) = %d instead of %d\n", x, y, result(x, y), x + y * 10 + 1);
+            exit(-1);
+        }
+    });
+
+    // Scalar Params are bound by address, and ImageParams are re-read
+    // on every call, so changes made after prepare() must be seen.
+    offset.set(2);
+    input.set(in2);
+    Buffer<uint8_t> out(10, 10);
+    call.realize(out);
+    out.for_each_element([&](int x, int y) {
+        if (out(x, y) != x * 10 + y + 2) {
+            printf("out(%d, %d) = %d instead of %d\n", x, y, out(x, y), x * 10 + y + 2);
+            exit(-1);
+        }
+    });
+
+    // A ParamMap is resolved at prepare time.
+    ParamMap params;
+    params.set(offset, 3);
+    params.set(input, in1);
+    PreparedCall mapped = p.prepare({10, 10}, get_jit_target_from_environment(), params);
+    mapped.realize(out);
+    out.for_each_element([&](int x, int y) {
+        if (out(x, y) != x + y * 10 + 3) {
+            printf("out(%d, %d) = %d instead of %d\n", x, y, out(x, y), x + y * 10 + 3);
+            exit(-1);
+        }
+    });
+
+    // The ParamMap doesn't need to outlive the PreparedCall.
+    PreparedCall temp_mapped = p.prepare({10, 10}, get_jit_target_from_environment(),
+                                         {{offset, 4}, {input, in2}});
+    for (int i = 0; i < 2; i++) {
+        temp_mapped.realize(out);
+        out.for_each_element([&](int x, int y) {
+            if (out(x, y) != x * 10 + y + 4) {
+                printf("out(%d, %d) = %d instead of %d\n", x, y, out(x, y), x * 10 + y + 4);
+                exit(-1);
+            }
+        });
+    }
+
+    printf("Success!\n");
+    return 0;
+}
@@ -0,0 +1,19 @@
+#include <stdio.h>
+#include "Halide.h"
+
+using namespace Halide;
+
+int main(int argc, char **argv) {
+    Var x, y;
+
+    Func f, g;
+
+    f(x, y) = x + y;
+    g(x, y) = f(x, y) + f(x + 1, y);
+    f.store_root().compute_at(g, y).ring_buffer(2);
+
+    Buffer<int> im = g.realize(100, 100);
+
+    printf("Should have gotten an error about a ring buffer without async!\n");
+    return -1;
+}
@@ -0,0 +1,165 @@
+#include "HalideRuntime.h"
+#include "HalideBuffer.h"
+#include "halide_benchmark.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include "cancellation.h"
+#include "cancellation_uncancellable.h"
+
+using namespace Halide::Runtime;
+
+static int context;
+
+// The row on which cancellation_row cancels the pipeline, or -1, and
+// how long each row takes.
+static int cancel_at_row = -1;
+static int row_delay_us = 0;
+static std::atomic<int> rows_started{0};
+
+extern "C" int cancellation_row(void *user_context, int y) {
+    rows_started++;
+    if (y == cancel_at_row) {
+        halide_cancel(user_context);
+    }
+    if (row_delay_us) {
+        std::this_thread::sleep_for(std::chrono::microseconds(row_delay_us));
+    }
+    return 0;
+}
+
+float correct(int x, int y) {
+    float e = (float)(x + y);
+    for (int i = 0; i < 4; i++) {
+        e = sqrtf(e * e + 1.0f);
+    }
+    return e;
+}
+
+bool check(const Buffer<float> &output) {
+    for (int y = 0; y < output.height(); y++) {
+        for (int x = 0; x < output.width(); x++) {
+            float c = correct(x, y);
+            if (fabsf(output(x, y) - c) > 1e-3f * c) {
+                printf("output(%d, %d) = %f instead of %f\n", x, y, output(x, y), c);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Run the cancellable pipeline, and check it returns the expected
+// result having started at most max_rows rows.
+bool run(const char *name, bool parallel, int expected_result, int max_rows) {
+    Buffer<float> output(256, 1000);
+    rows_started = 0;
+    int result = cancellation(&context, parallel, output);
+    if (result != expected_result) {
+        printf("%s: pipeline returned %d instead of %d\n", name, result, expected_result);
+        return false;
+    }
+    if (rows_started > max_rows) {
+        printf("%s: %d rows started, expected at most %d\n", name, (int)rows_started, max_rows);
+        return false;
+    }
+    if (result == 0 && !check(output)) {
+        printf("%s: wrong output\n", name);
+        return false;
+    }
+    return true;
+}
+
+// Report the overhead of the checks when the pipeline isn't
+// cancelled. It's only reported: timings vary too much from machine to
+// machine, and from run to run, to be checked here.
+void report_overhead(const char *name) {
+    Buffer<float> output(1024, 1024);
+    double t_cancellable = Halide::Tools::benchmark(10, 10, [&]() {
+        cancellation(&context, true, output);
+    });
+    double t_uncancellable = Halide::Tools::benchmark(10, 10, [&]() {
+        cancellation_uncancellable(&context, true, output);
+    });
+    printf("%s: Cancellable: %f ms  Uncancellable: %f ms  Overhead: %.2f%%\n",
+           name, t_cancellable * 1e3, t_uncancellable * 1e3,
+           (t_cancellable / t_uncancellable - 1) * 100);
+}
+
+int main(int argc, char **argv) {
+    for (bool parallel : {false, true}) {
+        // Nothing cancelled.
+        if (!run("not cancelled", parallel, 0, 1000)) {
+            return -1;
+        }
+
+        // Cancelled part way through. Serially, the next row notices.
+        // In parallel, tasks that have already started may finish.
+        cancel_at_row = 10;
+        if (!run("cancelled", parallel, halide_error_code_cancelled, parallel ? 100 : 11)) {
+            return -1;
+        }
+        cancel_at_row = -1;
+
+        // Still cancelled, until the cancellation is cleared.
+        if (!run("still cancelled", parallel, halide_error_code_cancelled, 0)) {
+            return -1;
+        }
+        halide_clear_cancellation(&context);
+        if (!run("cleared", parallel, 0, 1000)) {
+            return -1;
+        }
+
+        // A deadline that passes while the pipeline is running.
+        row_delay_us = 1000;
+        halide_set_deadline(&context, 20 * 1000 * 1000);
+        if (!run("deadline", parallel, halide_error_code_cancelled, 500)) {
+            return -1;
+        }
+        row_delay_us = 0;
+        halide_clear_cancellation(&context);
+
+        // A deadline that doesn't pass.
+        halide_set_deadline(&context, 60 * 1000 * 1000 * 1000LL);
+        if (!run("distant deadline", parallel, 0, 1000)) {
+            return -1;
+        }
+        halide_clear_cancellation(&context);
+    }
+
+    report_overhead("no deadlines");
+
+    // Deadlines on other user_contexts shouldn't make polling this
+    // one any slower, and they shouldn't stop it from completing.
+    static char others[256];
+    for (char &c : others) {
+        halide_set_deadline(&c, 60 * 1000 * 1000 * 1000LL);
+    }
+    report_overhead("many deadlines");
+    if (!run("other deadlines", true, 0, 1000)) {
+        return -1;
+    }
+    for (char &c : others) {
+        halide_clear_cancellation(&c);
+    }
+
+    // Deadlines that have passed are forgotten when room is needed,
+    // even if they're never cleared.
+    static char expired[4096];
+    for (char &c : expired) {
+        if (halide_set_deadline(&c, 0) != 0) {
+            printf("Expired deadlines weren't reclaimed\n");
+            return -1;
+        }
+    }
+    for (char &c : expired) {
+        halide_clear_cancellation(&c);
+    }
+
+    printf("Success!\n");
+    return 0;
+}
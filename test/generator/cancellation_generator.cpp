@@ -0,0 +1,36 @@
+#include "Halide.h"
+
+namespace {
+
+// Defined in the aottest. Called once per row, and may cancel the
+// pipeline.
+HalideExtern_2(int, cancellation_row, void *, int);
+
+class Cancellation : public Halide::Generator<Cancellation> {
+public:
+    Input<bool> parallel{"parallel"};
+    Output<Buffer<float>> output{"output", 2};
+
+    void generate() {
+        Var x, y;
+
+        Func row("row");
+        row(y) = cancellation_row(Halide::user_context_value(), y);
+
+        // Some work per pixel, so that the overhead of polling for
+        // cancellation can be measured.
+        Expr e = cast<float>(x + y);
+        for (int i = 0; i < 4; i++) {
+            e = sqrt(e * e + 1.0f);
+        }
+        output(x, y) = e + row(y);
+
+        row.compute_at(output, y);
+        output.vectorize(x, natural_vector_size<float>());
+        output.specialize(parallel).parallel(y);
+    }
+};
+
+}  // namespace
+
+HALIDE_REGISTER_GENERATOR(Cancellation, cancellation)
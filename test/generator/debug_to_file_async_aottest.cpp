@@ -0,0 +1,64 @@
+#include "HalideRuntime.h"
+#include "HalideBuffer.h"
+// Avoid the need to link this test to libjpeg and libpng
+#define HALIDE_NO_JPEG
+#define HALIDE_NO_PNG
+#include "halide_image_io.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "debug_to_file_async.h"
+
+using namespace Halide::Runtime;
+
+int main(int argc, char **argv) {
+    const int W = 1000, H = 800;
+    Buffer<float> input(W, H);
+    input.for_each_value([](float &v) { v = (float)(rand() & 0xfff); });
+    Buffer<float> output(W, H);
+
+    for (int async = 0; async < 2; async++) {
+        remove("debug_to_file_async_f.tmp");
+        remove("debug_to_file_async_g.tmp.lz4");
+
+        halide_set_debug_to_file_async(async);
+        if (debug_to_file_async(input, output) != 0) {
+            printf("Pipeline failed\n");
+            return -1;
+        }
+        // The files are only guaranteed to be complete after waiting.
+        if (halide_debug_to_file_wait(nullptr) != 0) {
+            printf("halide_debug_to_file_wait failed\n");
+            return -1;
+        }
+
+        Buffer<float> f = Halide::Tools::load_image("debug_to_file_async_f.tmp");
+        Buffer<uint16_t> g = Halide::Tools::load_image("debug_to_file_async_g.tmp.lz4");
+        for (int y = 0; y < H; y++) {
+            for (int x = 0; x < W; x++) {
+                if (f(x, y) != input(x, y) * 2.0f) {
+                    printf("async=%d: f(%d, %d) = %f instead of %f\n",
+                           async, x, y, f(x, y), input(x, y) * 2.0f);
+                    return -1;
+                }
+                if (g(x, y) != (uint16_t)(x + y)) {
+                    printf("async=%d: g(%d, %d) = %d instead of %d\n",
+                           async, x, y, g(x, y), (uint16_t)(x + y));
+                    return -1;
+                }
+                if (output(x, y) != f(x, y) + g(x, y)) {
+                    printf("async=%d: output(%d, %d) = %f instead of %f\n",
+                           async, x, y, output(x, y), f(x, y) + g(x, y));
+                    return -1;
+                }
+            }
+        }
+    }
+
+    remove("debug_to_file_async_f.tmp");
+    remove("debug_to_file_async_g.tmp.lz4");
+
+    printf("Success!\n");
+    return 0;
+}
@@ -0,0 +1,26 @@
+#include "Halide.h"
+
+namespace {
+
+class DebugToFileAsync : public Halide::Generator<DebugToFileAsync> {
+public:
+    Input<Buffer<float>> input{"input", 2};
+    Output<Buffer<float>> output{"output", 2};
+
+    void generate() {
+        Var x, y;
+        Func f("f"), g("g");
+        f(x, y) = input(x, y) * 2.0f;
+        g(x, y) = cast<uint16_t>(x + y);
+        output(x, y) = f(x, y) + g(x, y);
+
+        // The files are written to the current directory. One
+        // uncompressed, and one compressed.
+        f.compute_root().debug_to_file("debug_to_file_async_f.tmp");
+        g.compute_root().debug_to_file("debug_to_file_async_g.tmp.lz4");
+    }
+};
+
+}  // namespace
+
+HALIDE_REGISTER_GENERATOR(DebugToFileAsync, debug_to_file_async)
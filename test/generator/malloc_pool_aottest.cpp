@@ -0,0 +1,112 @@
+#include "HalideRuntime.h"
+#include "HalideBuffer.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <chrono>
+
+#include "malloc_pool.h"
+
+using namespace Halide::Runtime;
+
+double time_calls(Buffer<float> &input, Buffer<float> &output, int calls) {
+    auto t1 = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < calls; i++) {
+        int ret = malloc_pool(input, output);
+        if (ret) {
+            printf("Non zero exit code: %d\n", ret);
+            exit(-1);
+        }
+    }
+    auto t2 = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double, std::micro>(t2 - t1).count() / calls;
+}
+
+void check(Buffer<float> &input, Buffer<float> &output) {
+    output.for_each_element([&](int x, int y) {
+        float correct = 0;
+        for (int dy = -1; dy <= 1; dy++) {
+            for (int dx = -1; dx <= 1; dx++) {
+                int cx = std::min(std::max(x + dx, 0), input.width() - 1);
+                int cy = std::min(std::max(y + dy, 0), input.height() - 1);
+                correct += input(cx, cy);
+            }
+        }
+        correct /= 9.0f;
+        if (fabs(output(x, y) - correct) > 1e-3f) {
+            printf("output(%d, %d) = %f instead of %f\n", x, y, output(x, y), correct);
+            exit(-1);
+        }
+    });
+}
+
+int main(int argc, char **argv) {
+    Buffer<float> input(512, 384);
+    input.for_each_element([&](int x, int y) {
+        input(x, y) = (float)((x * 17 + y * 31) % 256);
+    });
+    Buffer<float> output(512, 384);
+
+    const int calls = 200;
+
+    malloc_pool(input, output);
+    double t_default = time_calls(input, output, calls);
+    check(input, output);
+
+    halide_malloc_pool_stats_t stats;
+    halide_enable_malloc_pool(nullptr, 64 * 1024 * 1024);
+    double t_pooled = time_calls(input, output, calls);
+    check(input, output);
+
+    // Both intermediates are reused on every call but the first.
+    halide_malloc_pool_get_stats(nullptr, &stats);
+    printf("%llu allocations, %llu hits, %llu blocks and %llu bytes cached\n",
+           (unsigned long long)stats.allocations, (unsigned long long)stats.hits,
+           (unsigned long long)stats.blocks_cached, (unsigned long long)stats.bytes_cached);
+    if (stats.allocations < 2 * calls || stats.hits < stats.allocations - 2) {
+        printf("Expected at least %d allocations, all but two of which are hits\n", 2 * calls);
+        return -1;
+    }
+    if (stats.blocks_cached != 2 || stats.bytes_cached < 2 * 512 * 384 * sizeof(float)) {
+        printf("Expected the two intermediates to be cached\n");
+        return -1;
+    }
+
+    // A cap smaller than the intermediates means nothing gets cached.
+    halide_enable_malloc_pool(nullptr, 1024);
+    time_calls(input, output, 1);
+    halide_malloc_pool_get_stats(nullptr, &stats);
+    if (stats.blocks_cached != 0 || stats.bytes_cached != 0) {
+        printf("Pool holds %llu bytes with a cap of 1024\n", (unsigned long long)stats.bytes_cached);
+        return -1;
+    }
+
+    halide_enable_malloc_pool(nullptr, 64 * 1024 * 1024);
+    time_calls(input, output, 1);
+    halide_malloc_pool_trim(nullptr, 0);
+    halide_malloc_pool_get_stats(nullptr, &stats);
+    if (stats.blocks_cached != 0 || stats.bytes_cached != 0) {
+        printf("Pool holds %llu bytes after trimming\n", (unsigned long long)stats.bytes_cached);
+        return -1;
+    }
+
+    // Blocks allocated while the pool was enabled can be freed after
+    // it is disabled.
+    void *block = halide_malloc(nullptr, 1000);
+    halide_disable_malloc_pool(nullptr);
+    halide_free(nullptr, block);
+    halide_malloc_pool_get_stats(nullptr, &stats);
+    if (stats.bytes_cached != 0) {
+        printf("Disabled pool holds %llu bytes\n", (unsigned long long)stats.bytes_cached);
+        return -1;
+    }
+    time_calls(input, output, 1);
+    check(input, output);
+
+    printf("Time per call: default allocator %f us, malloc pool %f us\n", t_default, t_pooled);
+
+    printf("Success!\n");
+    return 0;
+}
@@ -0,0 +1,29 @@
+#include "Halide.h"
+
+namespace {
+
+class MallocPool : public Halide::Generator<MallocPool> {
+public:
+    Input<Buffer<float>> input{"input", 2};
+    Output<Buffer<float>> output{"output", 2};
+
+    void generate() {
+        // Two intermediates on the heap, allocated and freed on every
+        // call, as with most pipelines that get run many times.
+        Var x, y;
+
+        Func blur_x, blur_y;
+        Func clamped = Halide::BoundaryConditions::repeat_edge(input);
+        blur_x(x, y) = clamped(x - 1, y) + clamped(x, y) + clamped(x + 1, y);
+        blur_y(x, y) = blur_x(x, y - 1) + blur_x(x, y) + blur_x(x, y + 1);
+        output(x, y) = blur_y(x, y) / 9.0f;
+
+        blur_x.compute_root().vectorize(x, natural_vector_size<float>());
+        blur_y.compute_root().vectorize(x, natural_vector_size<float>());
+        output.vectorize(x, natural_vector_size<float>());
+    }
+};
+
+}  // namespace
+
+HALIDE_REGISTER_GENERATOR(MallocPool, malloc_pool)
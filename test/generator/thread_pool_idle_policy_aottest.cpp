@@ -0,0 +1,65 @@
+#include "HalideRuntime.h"
+#include "HalideBuffer.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+#include "thread_pool_idle_policy.h"
+
+using namespace Halide::Runtime;
+
+// Call a tiny parallel pipeline many times back-to-back, and report
+// the distribution of per-call latencies under each idle policy.
+void run(halide_thread_pool_idle_policy_t policy, const char *name,
+         Buffer<int> &input, Buffer<int> &output) {
+    halide_set_thread_pool_idle_policy(policy);
+
+    const int calls = 10000;
+    std::vector<double> latency(calls);
+    for (int i = 0; i < calls; i++) {
+        auto t1 = std::chrono::high_resolution_clock::now();
+        int ret = thread_pool_idle_policy(input, output);
+        auto t2 = std::chrono::high_resolution_clock::now();
+        if (ret) {
+            printf("Non zero exit code: %d\n", ret);
+            exit(-1);
+        }
+        latency[i] = std::chrono::duration<double, std::micro>(t2 - t1).count();
+    }
+
+    output.for_each_element([&](int x, int y) {
+        if (output(x, y) != input(x, y) * 2 + 1) {
+            printf("%s: output(%d, %d) = %d instead of %d\n",
+                   name, x, y, output(x, y), input(x, y) * 2 + 1);
+            exit(-1);
+        }
+    });
+
+    std::sort(latency.begin(), latency.end());
+    printf("%-8s per-call latency (us): min %7.2f  median %7.2f  p90 %7.2f  p99 %7.2f\n",
+           name, latency[0], latency[calls / 2], latency[calls * 9 / 10], latency[calls * 99 / 100]);
+}
+
+int main(int argc, char **argv) {
+    Buffer<int> input(64, 16);
+    input.for_each_element([&](int x, int y) {
+        input(x, y) = x * 3 + y;
+    });
+    Buffer<int> output(64, 16);
+
+    // Warm up the thread pool.
+    thread_pool_idle_policy(input, output);
+
+    run(halide_thread_pool_idle_power, "power", input, output);
+    run(halide_thread_pool_idle_adaptive, "adaptive", input, output);
+    run(halide_thread_pool_idle_latency, "latency", input, output);
+
+    // Leave the default policy in place.
+    halide_set_thread_pool_idle_policy(halide_thread_pool_idle_adaptive);
+
+    printf("Success!\n");
+    return 0;
+}
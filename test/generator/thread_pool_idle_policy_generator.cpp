@@ -0,0 +1,22 @@
+#include "Halide.h"
+
+namespace {
+
+class ThreadPoolIdlePolicy : public Halide::Generator<ThreadPoolIdlePolicy> {
+public:
+    Input<Buffer<int>> input{"input", 2};
+    Output<Buffer<int>> output{"output", 2};
+
+    void generate() {
+        // A pipeline small enough that the time spent waking up the
+        // thread pool dominates the time spent doing work.
+        Var x, y;
+
+        output(x, y) = input(x, y) * 2 + 1;
+        output.vectorize(x, natural_vector_size<int>()).parallel(y);
+    }
+};
+
+}  // namespace
+
+HALIDE_REGISTER_GENERATOR(ThreadPoolIdlePolicy, thread_pool_idle_policy)
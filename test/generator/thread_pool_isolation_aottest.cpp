@@ -0,0 +1,127 @@
+#include "HalideRuntime.h"
+#include "HalideBuffer.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "thread_pool_isolation.h"
+
+using namespace Halide::Runtime;
+
+static int background_context, latency_context;
+
+static std::atomic<int> isolation_violations{0};
+
+extern "C" int thread_pool_isolation_work(void *user_context, int work) {
+    // A thread may work for the pipeline that called into Halide on
+    // it, or for the pipelines bound to the pool that owns it, but
+    // never for both pools.
+    static thread_local void *worked_for = nullptr;
+    if (worked_for == nullptr) {
+        worked_for = user_context;
+    } else if (worked_for != user_context) {
+        isolation_violations++;
+    }
+
+    float f = 3.0f;
+    for (int i = 0; i < work; i++) {
+        f = sqrtf(sinf(cosf(f)));
+    }
+    return f < 0 ? 1 : 0;
+}
+
+bool check(const Buffer<int> &output, const char *name) {
+    for (int y = 0; y < output.height(); y++) {
+        for (int x = 0; x < output.width(); x++) {
+            if (output(x, y) != x + y) {
+                printf("%s: output(%d, %d) = %d instead of %d\n",
+                       name, x, y, output(x, y), x + y);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+int main(int argc, char **argv) {
+    halide_thread_pool *background = halide_create_thread_pool("background", 2);
+    halide_thread_pool *latency = halide_create_thread_pool("latency", 2);
+    if (!background || !latency) {
+        printf("Failed to create thread pools\n");
+        return -1;
+    }
+    if (halide_find_thread_pool("latency") != latency ||
+        halide_find_thread_pool("nonexistent") != nullptr) {
+        printf("halide_find_thread_pool returned the wrong pool\n");
+        return -1;
+    }
+
+    // Run the background work at a lower priority, on any CPU.
+    uint64_t all_cpus[2] = {~0ULL, ~0ULL};
+    if (halide_thread_pool_set_cpu_affinity(background, all_cpus, 2) != 0 ||
+        halide_thread_pool_set_priority(background, 10) != 0) {
+        printf("Failed to configure the background thread pool\n");
+        return -1;
+    }
+
+    halide_bind_thread_pool(&background_context, background);
+    halide_bind_thread_pool(&latency_context, latency);
+
+    // A heavy pipeline runs continuously in the background...
+    std::atomic<bool> stop{false};
+    std::atomic<bool> background_ok{true};
+    std::thread background_thread([&]() {
+        Buffer<int> output(256, 64);
+        while (!stop) {
+            if (thread_pool_isolation(&background_context, 20000, output) != 0 ||
+                !check(output, "background")) {
+                background_ok = false;
+                return;
+            }
+        }
+    });
+
+    // ...while a latency-sensitive one is called repeatedly on a
+    // separate pool.
+    const int calls = 1000;
+    std::vector<double> latency_us(calls);
+    Buffer<int> output(64, 8);
+    for (int i = 0; i < calls; i++) {
+        auto t1 = std::chrono::high_resolution_clock::now();
+        int ret = thread_pool_isolation(&latency_context, 10, output);
+        auto t2 = std::chrono::high_resolution_clock::now();
+        if (ret != 0 || !check(output, "latency")) {
+            return -1;
+        }
+        latency_us[i] = std::chrono::duration<double, std::micro>(t2 - t1).count();
+    }
+
+    stop = true;
+    background_thread.join();
+    if (!background_ok) {
+        return -1;
+    }
+
+    std::sort(latency_us.begin(), latency_us.end());
+    printf("Latency-sensitive pipeline with a background load (us): median %.2f  p99 %.2f\n",
+           latency_us[calls / 2], latency_us[calls * 99 / 100]);
+
+    if (isolation_violations != 0) {
+        printf("%d rows ran on a thread from the wrong thread pool\n", (int)isolation_violations);
+        return -1;
+    }
+
+    halide_bind_thread_pool(&background_context, nullptr);
+    halide_bind_thread_pool(&latency_context, nullptr);
+    halide_destroy_thread_pool(background);
+    halide_destroy_thread_pool(latency);
+
+    printf("Success!\n");
+    return 0;
+}
@@ -0,0 +1,28 @@
+#include "Halide.h"
+
+namespace {
+
+// Defined in the aottest. Does some busy-work, and notes which
+// user_context the calling thread worked for.
+HalideExtern_2(int, thread_pool_isolation_work, void *, int);
+
+class ThreadPoolIsolation : public Halide::Generator<ThreadPoolIsolation> {
+public:
+    Input<int> work{"work", 1, 0, 1000000};
+    Output<Buffer<int>> output{"output", 2};
+
+    void generate() {
+        Var x, y;
+
+        Func row_work("row_work");
+        row_work(y) = thread_pool_isolation_work(Halide::user_context_value(), work);
+        output(x, y) = x + y + row_work(y);
+
+        row_work.compute_at(output, y);
+        output.parallel(y);
+    }
+};
+
+}  // namespace
+
+HALIDE_REGISTER_GENERATOR(ThreadPoolIsolation, thread_pool_isolation)
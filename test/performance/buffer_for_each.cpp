@@ -0,0 +1,119 @@
+#include "Halide.h"
+#include "halide_benchmark.h"
+#include <atomic>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+using namespace Halide;
+using namespace Halide::Tools;
+
+// Compare the Buffer helpers used for glue code outside of pipelines
+// (fill, copy_from, and for_each_value), serially and in parallel, to
+// the equivalent Halide pipelines.
+
+// A parallel-for executor for the Buffer methods, which runs the
+// tasks on a fixed number of threads.
+int run_tasks_on_threads(void *user_context, halide_task_t f, int min, int extent, uint8_t *closure) {
+    std::atomic<int> next(min);
+    auto worker = [&]() {
+        for (int i = next++; i < min + extent; i = next++) {
+            f(user_context, i, closure);
+        }
+    };
+    std::vector<std::thread> threads;
+    int num_threads = std::max(1u, std::thread::hardware_concurrency());
+    for (int i = 1; i < num_threads; i++) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto &t : threads) {
+        t.join();
+    }
+    return 0;
+}
+
+void report(const char *name, double t_serial, double t_parallel, double t_halide) {
+    printf("%-32s serial %7.3f ms  parallel %7.3f ms  halide %7.3f ms\n",
+           name, t_serial * 1e3, t_parallel * 1e3, t_halide * 1e3);
+}
+
+int main(int argc, char **argv) {
+    const int width = 4000, height = 3000;
+
+    Buffer<float> a(width, height, 3), b(width, height, 3);
+    Buffer<float> interleaved = Buffer<float>::make_interleaved(width, height, 3);
+    b.for_each_element([&](int x, int y, int c) {
+        b(x, y, c) = x + y + c;
+    });
+
+    Var x, y, c;
+
+    // fill
+    {
+        Func f;
+        f(x, y, c) = 1.0f;
+        f.parallel(y).vectorize(x, 8);
+        f.compile_jit();
+
+        double t_serial = benchmark([&]() { a.fill(1.0f); });
+        Buffer<>::set_parallel_for(run_tasks_on_threads);
+        double t_parallel = benchmark([&]() { a.fill(1.0f); });
+        Buffer<>::set_parallel_for(nullptr);
+        double t_halide = benchmark([&]() { f.realize(a); });
+        report("fill", t_serial, t_parallel, t_halide);
+    }
+
+    // copy_from, changing the memory layout
+    {
+        ImageParam in(Float(32), 3);
+        Func f;
+        f(x, y, c) = in(x, y, c);
+        f.output_buffer().dim(0).set_stride(3).dim(2).set_stride(1).set_bounds(0, 3);
+        f.reorder(c, x, y).bound(c, 0, 3).unroll(c).parallel(y).vectorize(x, 8);
+        f.compile_jit();
+        in.set(b);
+
+        double t_serial = benchmark([&]() { interleaved.copy_from(b); });
+        Buffer<>::set_parallel_for(run_tasks_on_threads);
+        double t_parallel = benchmark([&]() { interleaved.copy_from(b); });
+        Buffer<>::set_parallel_for(nullptr);
+        double t_halide = benchmark([&]() { f.realize(interleaved); });
+        report("copy_from planar to interleaved", t_serial, t_parallel, t_halide);
+
+        interleaved.for_each_element([&](int x, int y, int c) {
+            if (interleaved(x, y, c) != b(x, y, c)) {
+                printf("copy_from error at %d %d %d\n", x, y, c);
+                exit(-1);
+            }
+        });
+    }
+
+    // for_each_value over two dense buffers
+    {
+        ImageParam in(Float(32), 3);
+        Func f;
+        f(x, y, c) = in(x, y, c) * 2.0f + 1.0f;
+        f.parallel(y).vectorize(x, 8);
+        f.compile_jit();
+        in.set(b);
+
+        auto op = [](float &a, float b) { a = b * 2.0f + 1.0f; };
+        double t_serial = benchmark([&]() { a.for_each_value(op, b); });
+        Buffer<>::set_parallel_for(run_tasks_on_threads);
+        double t_parallel = benchmark([&]() { a.for_each_value_parallel(op, b); });
+        Buffer<>::set_parallel_for(nullptr);
+        double t_halide = benchmark([&]() { f.realize(a); });
+        report("for_each_value", t_serial, t_parallel, t_halide);
+
+        a.for_each_element([&](int x, int y, int c) {
+            if (a(x, y, c) != b(x, y, c) * 2.0f + 1.0f) {
+                printf("for_each_value error at %d %d %d\n", x, y, c);
+                exit(-1);
+            }
+        });
+    }
+
+    printf("Success!\n");
+    return 0;
+}
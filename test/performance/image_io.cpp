@@ -0,0 +1,81 @@
+#include "Halide.h"
+#include <cstdio>
+#include "halide_benchmark.h"
+#include "halide_image_io.h"
+#include "test/common/halide_test_dirs.h"
+
+using namespace Halide;
+using namespace Halide::Tools;
+
+// Measure how long it takes to load a large image in each format, and
+// to convert it to float, to keep image loading from dominating the
+// runtime of apps and RunGen benchmarks.
+
+template<typename T>
+void test_load(const std::string &format, int channels) {
+    const int width = 6000, height = 4000;
+
+    Buffer<T> im = channels > 1 ? Buffer<T>(width, height, channels) : Buffer<T>(width, height);
+    uint32_t seed = 0;
+    im.for_each_value([&](T &v) {
+        seed = seed * 1664525 + 1013904223;
+        v = (T) (seed >> 16);
+    });
+
+    const std::string filename = Halide::Internal::get_test_tmp_dir() + "image_io_perf_" +
+        std::to_string(sizeof(T) * 8) + "x" + std::to_string(channels) + "." + format;
+    save_image(im, filename);
+
+    Buffer<T> loaded;
+    double t_load = benchmark(3, 1, [&]() {
+        loaded = load_image(filename);
+    });
+
+    double t_mapped = 0;
+    if (format == "tmp" || format == "npy" || format == "pgm" || format == "ppm") {
+        Buffer<T> mapped;
+        t_mapped = benchmark(3, 1, [&]() {
+            mapped = load_mapped_image(filename);
+        });
+    }
+
+    Buffer<float> converted;
+    double t_convert = benchmark(3, 1, [&]() {
+        converted = ImageTypeConversion::convert_image<float>(loaded);
+    });
+
+    if (format != "jpg") {
+        loaded.for_each_element([&](const int *pos) {
+            if (loaded(pos) != im(pos)) {
+                printf("Mismatch loading %s\n", filename.c_str());
+                abort();
+            }
+        });
+    }
+
+    const double mp = width * height / 1e6;
+    printf("%4s %2d-bit x%d: load %7.2f ms (%6.1f MP/s)", format.c_str(), (int) sizeof(T) * 8, channels,
+           t_load * 1e3, mp / t_load);
+    if (t_mapped > 0) {
+        printf("  mapped %7.3f ms", t_mapped * 1e3);
+    }
+    printf("  convert to float %7.2f ms\n", t_convert * 1e3);
+}
+
+int main(int argc, char **argv) {
+    test_load<uint8_t>("pgm", 1);
+    test_load<uint8_t>("ppm", 3);
+    test_load<uint16_t>("ppm", 3);
+#ifndef HALIDE_NO_PNG
+    test_load<uint8_t>("png", 3);
+    test_load<uint16_t>("png", 3);
+#endif
+#ifndef HALIDE_NO_JPEG
+    test_load<uint8_t>("jpg", 3);
+#endif
+    test_load<uint16_t>("npy", 3);
+    test_load<float>("mat", 1);
+
+    printf("Success!\n");
+    return 0;
+}
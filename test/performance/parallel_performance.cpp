@@ -8,6 +8,14 @@ using namespace Halide::Tools;
 #define W 1024
 #define H 160
 
+// Runs each task as it comes. Setting this makes parallel loops fall
+// back to running one iteration per task, instead of slices of the
+// loop at a time.
+int per_iteration_do_task(void *user_context, int (*f)(void *, int, uint8_t *),
+                          int idx, uint8_t *closure) {
+    return f(user_context, idx, closure);
+}
+
 int main(int argc, char **argv) {
     Var x, y;
     Func f, g;
@@ -48,6 +56,40 @@ int main(int argc, char **argv) {
         return 0;
     }
 
+    // A tall narrow image with very cheap rows, where the cost of
+    // scheduling each row as its own task would dominate.
+    {
+        Func h;
+        h(x, y) = x + y;
+        h.parallel(y);
+
+        const int tall_h = 1 << 20;
+        Buffer<int> imh(4, tall_h);
+        h.realize(imh);
+        double sliced_time = benchmark([&]() { h.realize(imh); });
+
+        h.set_custom_do_task(per_iteration_do_task);
+        h.realize(imh);
+        double per_iteration_time = benchmark([&]() { h.realize(imh); });
+
+        for (int y = 0; y < tall_h; y++) {
+            for (int x = 0; x < 4; x++) {
+                if (imh(x, y) != x + y) {
+                    printf("imh(%d, %d) = %d instead of %d\n", x, y, imh(x, y), x + y);
+                    return -1;
+                }
+            }
+        }
+
+        printf("Tall narrow image: one row per task %f, slices of rows %f\n",
+               per_iteration_time, sliced_time);
+
+        if (sliced_time > per_iteration_time) {
+            fprintf(stderr, "WARNING: Running slices of a parallel loop should be faster than one iteration at a time\n");
+            return 0;
+        }
+    }
+
     printf("Success!\n");
     return 0;
 }
@@ -96,6 +96,29 @@ int main(int argc, char **argv) {
         std::cout << "No argument Pipeline realize reusing Realization/Target/ParamMap with no_asserts and no_bounds_query time " << t * 1e6 << "us.\n";
     }
 
+    {
+        Func f;
+        f() = 42;
+
+        Pipeline p(f);
+        PreparedCall call = p.prepare();
+
+        double t = benchmark([&]() { call.realize(); });
+        std::cout << "No argument PreparedCall realize time " << t * 1e6 << "us.\n";
+    }
+
+    {
+        Func f;
+        f() = 42;
+
+        Pipeline p(f);
+        PreparedCall call = p.prepare({}, Target("host-no_asserts-no_bounds_query"));
+
+        auto buf = Buffer<int32_t>::make_scalar();
+        double t = benchmark([&]() { call.realize(buf); });
+        std::cout << "No argument PreparedCall realize to Buffer with no_asserts and no_bounds_query time " << t * 1e6 << "us.\n";
+    }
+
     {
         Func f;
         Param<int> in;
@@ -145,6 +168,10 @@ int main(int argc, char **argv) {
         auto buf = Buffer<int32_t>::make_scalar();
         double t = benchmark([&]() { f.realize(buf); });
         std::cout << std::to_string(i) << "-argument Func realize to Buffer time " << t * 1e6 << "us.\n";
+
+        PreparedCall call = Pipeline(f).prepare();
+        t = benchmark([&]() { call.realize(buf); });
+        std::cout << std::to_string(i) << "-argument PreparedCall realize to Buffer time " << t * 1e6 << "us.\n";
     }
 
     std::cout << "Success!\n";
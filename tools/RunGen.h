@@ -3,8 +3,13 @@
 #include "halide_benchmark.h"
 #include "halide_image_io.h"
 
+#include <algorithm>
+#include <atomic>
+#include <cmath>
 #include <cstdio>
 #include <cstdlib>
+#include <ctime>
+#include <fstream>
 #include <iomanip>
 #include <iostream>
 #include <map>
@@ -13,6 +18,7 @@
 #include <set>
 #include  <sstream>
 #include <string>
+#include <thread>
 #include <vector>
 
 namespace Halide {
@@ -410,7 +416,7 @@ inline Buffer<> load_input_from_file(const std::string &pathname,
                               const halide_filter_argument_t &metadata) {
     Buffer<> b = Buffer<>(metadata.type, 0);
     info() << "Loading input " << metadata.name << " from " << pathname << " ...";
-    if (!Halide::Tools::load<Buffer<>, IOCheckFail>(pathname, &b)) {
+    if (!Halide::Tools::load_mapped<Buffer<>, IOCheckFail>(pathname, &b)) {
         fail() << "Unable to load input: " << pathname;
     }
     if (b.dimensions() != metadata.dimensions) {
@@ -482,8 +488,11 @@ inline Halide::Tools::FormatInfo best_save_format(const Buffer<> &b, const std::
         int score = 0;
         // If format has too-few dimensions, that's very bad.
         score += std::abs(f.dimensions - dimensions) * 128;
-        // If format has too-few bits, that's pretty bad.
-        score += std::abs(f.type.bits - type.bits);
+        // If format has too-few bits, that's pretty bad; too many is
+        // merely wasteful. (Formats like .npy that can hold any type
+        // exactly will always win here.)
+        score += std::max(0, type.bits - f.type.bits) * 2;
+        score += std::max(0, f.type.bits - type.bits);
         // If format has different code, that's a little bad.
         score += (f.type.code != type.code) ? 1 : 0;
         if (score < best_score) {
@@ -1024,6 +1033,178 @@ public:
               << "Best output throughput is " << (megapixels_out() / result.wall_time) << " mpix/sec.\n";
     }
 
+    // Run the filter from several caller threads at once for (roughly)
+    // the given duration. Each caller has its own copies of the input and
+    // output buffers, so calls never share memory. If threads_per_caller
+    // is nonzero, the Halide thread pool is limited to that many threads
+    // for each caller. (There is a single pool shared by all callers, so
+    // this is a limit on the total, not a partition.) Reports the
+    // distribution of per-call latencies, the aggregate throughput and
+    // the CPU utilization as JSON, written to json_path (or stdout if
+    // json_path is empty).
+    void run_for_concurrent_benchmark(int callers,
+                                      int threads_per_caller,
+                                      double duration,
+                                      const std::string &json_path) {
+        using Clock = Halide::Tools::SteadyClock<>::type;
+
+        struct Caller {
+            std::vector<Buffer<>> buffers;
+            std::vector<void*> filter_argv;
+            std::vector<double> latencies;
+        };
+
+        // Set up each caller's private buffers.
+        std::vector<Caller> caller_state(callers);
+        for (auto &c : caller_state) {
+            c.buffers.resize(args.size());
+            c.filter_argv.resize(args.size(), nullptr);
+            for (auto &arg_pair : args) {
+                auto &arg = arg_pair.second;
+                switch (arg.metadata->kind) {
+                case halide_argument_kind_input_scalar:
+                    c.filter_argv[arg.index] = &arg.scalar_value;
+                    break;
+                case halide_argument_kind_input_buffer:
+                    c.buffers[arg.index] = arg.buffer_value.copy();
+                    c.filter_argv[arg.index] = c.buffers[arg.index].raw_buffer();
+                    break;
+                case halide_argument_kind_output_buffer:
+                    c.buffers[arg.index] = Buffer<>::make_with_shape_of(arg.buffer_value);
+                    c.filter_argv[arg.index] = c.buffers[arg.index].raw_buffer();
+                    break;
+                }
+            }
+        }
+
+        int old_num_threads = 0;
+        if (threads_per_caller > 0) {
+            old_num_threads = halide_set_num_threads(callers * threads_per_caller);
+        }
+
+        info() << "Benchmarking filter with " << callers << " concurrent callers...";
+
+        std::atomic<int> ready(0);
+        std::atomic<bool> go(false);
+        Clock::time_point start, deadline;
+        const auto run_caller = [&](Caller *c) {
+            const auto call = [&]() {
+                // Ignore result since our halide_error() should catch everything.
+                (void) halide_argv_call(&c->filter_argv[0]);
+                for (auto &arg_pair : args) {
+                    if (arg_pair.second.metadata->kind == halide_argument_kind_output_buffer) {
+                        c->buffers[arg_pair.second.index].device_sync();
+                    }
+                }
+            };
+            // One untimed call to warm up caches, the thread pool, etc.
+            call();
+            // The last caller to finish warming up starts the clock.
+            if (++ready == callers) {
+                start = Clock::now();
+                deadline = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(duration));
+                go = true;
+            }
+            while (!go) {
+                std::this_thread::yield();
+            }
+            do {
+                auto t0 = Clock::now();
+                call();
+                auto t1 = Clock::now();
+                c->latencies.push_back(std::chrono::duration<double>(t1 - t0).count());
+            } while (Clock::now() < deadline);
+        };
+
+        std::vector<std::thread> threads;
+        // The main thread acts as caller zero.
+        for (int i = 1; i < callers; i++) {
+            threads.emplace_back(run_caller, &caller_state[i]);
+        }
+        const std::clock_t cpu_start = std::clock();
+        run_caller(&caller_state[0]);
+        for (auto &t : threads) {
+            t.join();
+        }
+        const double wall_time = std::chrono::duration<double>(Clock::now() - start).count();
+        // Warm-up calls are included in the CPU time, which slightly
+        // overestimates utilization for very short runs.
+        const double cpu_time = (double) (std::clock() - cpu_start) / CLOCKS_PER_SEC;
+
+        if (threads_per_caller > 0) {
+            halide_set_num_threads(old_num_threads);
+        }
+
+        std::vector<double> latencies;
+        for (auto &c : caller_state) {
+            latencies.insert(latencies.end(), c.latencies.begin(), c.latencies.end());
+        }
+        std::sort(latencies.begin(), latencies.end());
+        const size_t n = latencies.size();
+        double sum = 0, sum_sq = 0;
+        for (double l : latencies) {
+            sum += l;
+            sum_sq += l * l;
+        }
+        const double mean = sum / n;
+        const double stddev = std::sqrt(std::max(0.0, sum_sq / n - mean * mean));
+        const auto percentile = [&](double p) {
+            size_t i = (size_t) std::ceil(p / 100.0 * n);
+            return latencies[std::min(n - 1, i > 0 ? i - 1 : 0)];
+        };
+
+        // Latency histogram with four log-spaced buckets per octave.
+        std::map<int, uint64_t> histogram;
+        for (double l : latencies) {
+            histogram[(int) std::floor(4.0 * std::log2(std::max(l, 1e-9)))]++;
+        }
+
+        const unsigned hardware_threads = std::max(1u, std::thread::hardware_concurrency());
+        std::ostringstream o;
+        o << std::setprecision(6);
+        o << "{\n"
+          << "  \"name\": \"" << md->name << "\",\n"
+          << "  \"callers\": " << callers << ",\n"
+          << "  \"threads_per_caller\": " << threads_per_caller << ",\n"
+          << "  \"hardware_threads\": " << hardware_threads << ",\n"
+          << "  \"wall_time_sec\": " << wall_time << ",\n"
+          << "  \"calls\": " << n << ",\n"
+          << "  \"throughput_calls_per_sec\": " << n / wall_time << ",\n"
+          << "  \"throughput_mpix_per_sec\": " << n * megapixels_out() / wall_time << ",\n"
+          << "  \"cpu_time_sec\": " << cpu_time << ",\n"
+          << "  \"cpu_utilization\": " << cpu_time / (wall_time * hardware_threads) << ",\n"
+          << "  \"latency_sec\": {\n"
+          << "    \"min\": " << latencies.front() << ",\n"
+          << "    \"mean\": " << mean << ",\n"
+          << "    \"stddev\": " << stddev << ",\n"
+          << "    \"p50\": " << percentile(50) << ",\n"
+          << "    \"p90\": " << percentile(90) << ",\n"
+          << "    \"p99\": " << percentile(99) << ",\n"
+          << "    \"p999\": " << percentile(99.9) << ",\n"
+          << "    \"max\": " << latencies.back() << "\n"
+          << "  },\n"
+          << "  \"latency_histogram\": [";
+        bool need_comma = false;
+        for (const auto &bucket : histogram) {
+            o << (need_comma ? ",\n" : "\n")
+              << "    {\"upper_bound_sec\": " << std::exp2((bucket.first + 1) / 4.0)
+              << ", \"count\": " << bucket.second << "}";
+            need_comma = true;
+        }
+        o << "\n  ]\n}\n";
+
+        if (json_path.empty()) {
+            out() << o.str();
+        } else {
+            std::ofstream f(json_path);
+            f << o.str();
+            if (!f) {
+                fail() << "Unable to write benchmark results to " << json_path;
+            }
+            info() << "Wrote benchmark results to " << json_path;
+        }
+    }
+
     void run_for_output() {
         std::vector<void*> filter_argv = build_filter_argv();
 
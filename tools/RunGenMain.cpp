@@ -37,13 +37,21 @@ Arguments:
         some_input_buffer=/path/to/existing/file.png
         some_output_buffer=/path/to/create/output/file.png
 
-    We currently support JPG, PGM, PNG, PPM format. If the type or dimensions
-    of the input or output file type can't support the data (e.g., your filter
-    uses float32 input and output, and you load/save to PNG), we'll use the most
-    robust approximation within the format and issue a warning to stdout.
+    We currently support JPG, MAT, NPY, PGM, PNG, PPM and TMP format. If the
+    type or dimensions of the input or output file type can't support the data
+    (e.g., your filter uses float32 input and output, and you load/save to PNG),
+    we'll use the most robust approximation within the format and issue a
+    warning to stdout.
+
+    NPY (NumPy) files can hold any scalar type (including float16 and bool) in
+    any number of dimensions, so they are the best choice for real tensor
+    data: they are loaded and saved without conversion. C-order arrays have
+    their axes reversed, so the last numpy axis becomes dimension 0. Inputs in
+    uncompressed formats (MAT, NPY, PGM, PPM, TMP) are memory-mapped rather
+    than copied when possible.
 
     (We anticipate adding other image formats in the future, in particular,
-    TIFF and TMP.)
+    TIFF.)
 
     For inputs, there are also "pseudo-file" specifiers you can use; currently
     supported are
@@ -122,6 +130,27 @@ Flags:
         Override the default maximum number of benchmarking iterations; ignored
         if --benchmarks is not also specified.
 
+    --benchmark_callers=NUM [default = 0]:
+        If nonzero, benchmark throughput and latency under concurrent load
+        instead: run the filter from NUM caller threads at once (each with
+        its own copies of the inputs and outputs) for --benchmark_duration
+        seconds, and report the distribution of per-call latencies (min,
+        mean, p50, p90, p99, p99.9, max and a log-spaced histogram), the
+        aggregate throughput and the CPU utilization as JSON. Ignored if
+        --benchmarks is not also specified.
+
+    --benchmark_threads_per_caller=NUM [default = 0]:
+        Limit the Halide thread pool to NUM threads per concurrent caller
+        (i.e. NUM * benchmark_callers threads in total, since the pool is
+        shared by all callers). If zero, the pool size is left alone.
+
+    --benchmark_duration=DURATION_SECONDS [default = 1.0]:
+        How long to run the concurrent-caller benchmark.
+
+    --benchmark_json=PATH:
+        Write the concurrent-caller benchmark results to PATH instead of
+        stdout.
+
     --track_memory:
         Override Halide memory allocator to track high-water mark of memory
         allocation during run; note that this may slow down execution, so
@@ -279,6 +308,10 @@ int main(int argc, char **argv) {
     double benchmark_min_time = BenchmarkConfig().min_time;
     uint64_t benchmark_min_iters = BenchmarkConfig().min_iters;
     uint64_t benchmark_max_iters = BenchmarkConfig().max_iters;
+    int benchmark_callers = 0;
+    int benchmark_threads_per_caller = 0;
+    double benchmark_duration = 1.0;
+    std::string benchmark_json;
     for (int i = 1; i < argc; ++i) {
         if (argv[i][0] == '-') {
             const char *p = argv[i] + 1; // skip -
@@ -345,6 +378,20 @@ int main(int argc, char **argv) {
                 if (!parse_scalar(flag_value, &benchmark_max_iters)) {
                     fail() << "Invalid value for flag: " << flag_name;
                 }
+            } else if (flag_name == "benchmark_callers") {
+                if (!parse_scalar(flag_value, &benchmark_callers) || benchmark_callers < 0) {
+                    fail() << "Invalid value for flag: " << flag_name;
+                }
+            } else if (flag_name == "benchmark_threads_per_caller") {
+                if (!parse_scalar(flag_value, &benchmark_threads_per_caller) || benchmark_threads_per_caller < 0) {
+                    fail() << "Invalid value for flag: " << flag_name;
+                }
+            } else if (flag_name == "benchmark_duration") {
+                if (!parse_scalar(flag_value, &benchmark_duration) || benchmark_duration <= 0) {
+                    fail() << "Invalid value for flag: " << flag_name;
+                }
+            } else if (flag_name == "benchmark_json") {
+                benchmark_json = flag_value;
             } else if (flag_name == "output_extents") {
                 explicit_default_output_shape = parse_extents(flag_value);
             } else {
@@ -398,7 +445,10 @@ int main(int argc, char **argv) {
         tracker.install();
     }
 
-    if (benchmark) {
+    if (benchmark && benchmark_callers > 0) {
+        r.run_for_concurrent_benchmark(benchmark_callers, benchmark_threads_per_caller,
+                                       benchmark_duration, benchmark_json);
+    } else if (benchmark) {
         r.run_for_benchmark(benchmark_min_time, benchmark_min_iters, benchmark_max_iters);
     } else {
         r.run_for_output();
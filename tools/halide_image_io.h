@@ -12,8 +12,21 @@
 #include <map>
 #include <set>
 #include <string>
+#include <memory>
 #include <vector>
 #include <cctype>
+#include <cstring>
+
+#ifndef HALIDE_NO_IMAGE_IO_THREADS
+#include <thread>
+#endif
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 #ifndef HALIDE_NO_PNG
 #include "png.h"
@@ -324,27 +337,138 @@ struct FileOpener {
     FILE * const f;
 };
 
+// Call body(begin, end) over disjoint subranges of [begin, end), in
+// parallel when the range holds enough work to be worth it. grain is
+// the smallest subrange worth handing to a thread of its own.
+template<typename Fn>
+void parallel_for_ranges(int64_t begin, int64_t end, int64_t grain, Fn body) {
+#ifndef HALIDE_NO_IMAGE_IO_THREADS
+    const int64_t n = end - begin;
+    const int64_t max_threads = std::max(1u, std::thread::hardware_concurrency());
+    const int64_t threads = std::min(max_threads, n / std::max<int64_t>(grain, 1));
+    if (threads > 1) {
+        std::vector<std::thread> workers;
+        for (int64_t i = 1; i < threads; i++) {
+            workers.emplace_back(body, begin + n * i / threads, begin + n * (i + 1) / threads);
+        }
+        body(begin, begin + n / threads);
+        for (auto &t : workers) {
+            t.join();
+        }
+        return;
+    }
+#endif
+    body(begin, end);
+}
+
+// Scatter a row of interleaved big-endian samples into an image row with
+// arbitrary x and channel strides. The channel count is a template
+// parameter for the common cases (zero means use the runtime count) so
+// that the compiler can turn the strided gathers into vector shuffles.
+template<typename ElemType, int kChannels>
+void deinterleave_big_endian_row(const uint8_t *src, int width, int channels,
+                                 ElemType *dst, int x_stride, int c_stride) {
+    if (kChannels) {
+        channels = kChannels;
+    }
+    if (sizeof(ElemType) == 1 && x_stride == channels && (c_stride == 1 || channels == 1)) {
+        // Already in the right layout.
+        memcpy(dst, src, (size_t) width * channels);
+        return;
+    }
+    const int src_stride = channels * sizeof(ElemType);
+    for (int c = 0; c < channels; c++) {
+        const uint8_t *s = src + c * sizeof(ElemType);
+        ElemType *d = dst + (ptrdiff_t) c * c_stride;
+        if (x_stride == 1) {
+            for (int x = 0; x < width; x++) {
+                d[x] = read_big_endian<ElemType>(s + x * src_stride);
+            }
+        } else {
+            for (int x = 0; x < width; x++) {
+                d[(ptrdiff_t) x * x_stride] = read_big_endian<ElemType>(s + x * src_stride);
+            }
+        }
+    }
+}
+
+// The inverse of deinterleave_big_endian_row.
+template<typename ElemType, int kChannels>
+void interleave_big_endian_row(const ElemType *src, int x_stride, int c_stride,
+                               int width, int channels, uint8_t *dst) {
+    if (kChannels) {
+        channels = kChannels;
+    }
+    if (sizeof(ElemType) == 1 && x_stride == channels && (c_stride == 1 || channels == 1)) {
+        memcpy(dst, src, (size_t) width * channels);
+        return;
+    }
+    const int dst_stride = channels * sizeof(ElemType);
+    for (int c = 0; c < channels; c++) {
+        const ElemType *s = src + (ptrdiff_t) c * c_stride;
+        uint8_t *d = dst + c * sizeof(ElemType);
+        if (x_stride == 1) {
+            for (int x = 0; x < width; x++) {
+                write_big_endian<ElemType>(s[x], d + x * dst_stride);
+            }
+        } else {
+            for (int x = 0; x < width; x++) {
+                write_big_endian<ElemType>(s[(ptrdiff_t) x * x_stride], d + x * dst_stride);
+            }
+        }
+    }
+}
+
+// Read rows [y_begin, y_end) of ElemTypes from a byte buffer holding
+// consecutive interleaved rows, and copy them into the image.
+// Multibyte elements are assumed to be big-endian.
+template<typename ElemType, typename ImageType>
+void read_big_endian_rows(const uint8_t *src, int y_begin, int y_end, ImageType *im) {
+    auto im_typed = im->template as<ElemType>();
+    const int xmin = im_typed.dim(0).min();
+    const int width = im_typed.dim(0).extent();
+    const int x_stride = im_typed.dim(0).stride();
+    const bool has_channels = im_typed.dimensions() > 2;
+    const int channels = has_channels ? im_typed.dim(2).extent() : 1;
+    const int c_stride = has_channels ? im_typed.dim(2).stride() : 0;
+    const size_t row_bytes = (size_t) width * channels * sizeof(ElemType);
+    auto deinterleave = channels == 1 ? deinterleave_big_endian_row<ElemType, 1> :
+                        channels == 3 ? deinterleave_big_endian_row<ElemType, 3> :
+                        channels == 4 ? deinterleave_big_endian_row<ElemType, 4> :
+                                        deinterleave_big_endian_row<ElemType, 0>;
+    for (int y = y_begin; y < y_end; y++, src += row_bytes) {
+        ElemType *dst = has_channels ? &im_typed(xmin, y, im_typed.dim(2).min()) : &im_typed(xmin, y);
+        deinterleave(src, width, channels, dst, x_stride, c_stride);
+    }
+}
+
 // Read a row of ElemTypes from a byte buffer and copy them into a specific image row.
 // Multibyte elements are assumed to be big-endian.
 template<typename ElemType, typename ImageType>
 void read_big_endian_row(const uint8_t *src, int y, ImageType *im) {
-    auto im_typed = im->template as<ElemType>();
+    read_big_endian_rows<ElemType>(src, y, y + 1, im);
+}
+
+// Copy rows [y_begin, y_end) from an image into a byte buffer, as
+// consecutive interleaved rows. Multibyte elements are written in
+// big-endian layout.
+template<typename ElemType, typename ImageType>
+void write_big_endian_rows(const ImageType &im, int y_begin, int y_end, uint8_t *dst) {
+    auto im_typed = im.template as<ElemType>();
     const int xmin = im_typed.dim(0).min();
-    const int xmax = im_typed.dim(0).max();
-    if (im_typed.dimensions() > 2) {
-        const int cmin = im_typed.dim(2).min();
-        const int cmax = im_typed.dim(2).max();
-        for (int x = xmin; x <= xmax; x++) {
-            for (int c = cmin; c <= cmax; c++) {
-                im_typed(x, y, c+cmin) = read_big_endian<ElemType>(src);
-                src += sizeof(ElemType);
-            }
-        }
-    } else {
-        for (int x = xmin; x <= xmax; x++) {
-            im_typed(x, y) = read_big_endian<ElemType>(src);
-            src += sizeof(ElemType);
-        }
+    const int width = im_typed.dim(0).extent();
+    const int x_stride = im_typed.dim(0).stride();
+    const bool has_channels = im_typed.dimensions() > 2;
+    const int channels = has_channels ? im_typed.dim(2).extent() : 1;
+    const int c_stride = has_channels ? im_typed.dim(2).stride() : 0;
+    const size_t row_bytes = (size_t) width * channels * sizeof(ElemType);
+    auto interleave = channels == 1 ? interleave_big_endian_row<ElemType, 1> :
+                      channels == 3 ? interleave_big_endian_row<ElemType, 3> :
+                      channels == 4 ? interleave_big_endian_row<ElemType, 4> :
+                                      interleave_big_endian_row<ElemType, 0>;
+    for (int y = y_begin; y < y_end; y++, dst += row_bytes) {
+        const ElemType *src = has_channels ? &im_typed(xmin, y, im_typed.dim(2).min()) : &im_typed(xmin, y);
+        interleave(src, x_stride, c_stride, width, channels, dst);
     }
 }
 
@@ -352,24 +476,39 @@ void read_big_endian_row(const uint8_t *src, int y, ImageType *im) {
 // Multibyte elements are written in big-endian layout.
 template<typename ElemType, typename ImageType>
 void write_big_endian_row(const ImageType &im, int y, uint8_t *dst) {
-    auto im_typed = im.template as<ElemType>();
-    const int xmin = im_typed.dim(0).min();
-    const int xmax = im_typed.dim(0).max();
-    if (im_typed.dimensions() > 2) {
-        const int cmin = im_typed.dim(2).min();
-        const int cmax = im_typed.dim(2).max();
-        for (int x = xmin; x <= xmax; x++) {
-            for (int c = cmin; c <= cmax; c++) {
-                write_big_endian<ElemType>(im_typed(x, y, c), dst);
-                dst += sizeof(ElemType);
+    write_big_endian_rows<ElemType>(im, y, y + 1, dst);
+}
+
+// Loaders decode a block of rows at a time into a staging buffer of
+// about this size, then convert the block into the image in parallel.
+// (None of the codecs we use can decode rows of one image concurrently.)
+constexpr size_t kRowBlockBytes = 8 << 20;
+
+// Decode all the rows of an image, serially, with decode_row(uint8_t *dst),
+// which should return false on failure, and copy them into the image with
+// the given block converter (e.g. read_big_endian_rows).
+template<typename ImageType, typename DecodeFn>
+bool decode_rows(ImageType *im, size_t row_bytes,
+                 void (*copy_to_image)(const uint8_t *, int, int, ImageType *),
+                 DecodeFn decode_row) {
+    const int ymin = im->dim(1).min();
+    const int ymax = im->dim(1).max();
+    const int block_rows = (int) std::max<size_t>(1, kRowBlockBytes / std::max<size_t>(row_bytes, 1));
+    std::vector<uint8_t> block((size_t) std::min(block_rows, ymax - ymin + 1) * row_bytes);
+    for (int y0 = ymin; y0 <= ymax; y0 += block_rows) {
+        const int y1 = std::min(y0 + block_rows, ymax + 1);
+        for (int y = y0; y < y1; y++) {
+            if (!decode_row(block.data() + (size_t) (y - y0) * row_bytes)) {
+                return false;
             }
         }
-    } else {
-        for (int x = xmin; x <= xmax; x++) {
-            write_big_endian<ElemType>(im_typed(x, y), dst);
-            dst += sizeof(ElemType);
-        }
+        // Aim for at least 256k per thread.
+        const int64_t grain = std::max<int64_t>(1, (256 << 10) / std::max<size_t>(row_bytes, 1));
+        parallel_for_ranges(y0, y1, grain, [&](int64_t b, int64_t e) {
+            copy_to_image(block.data() + (size_t) (b - y0) * row_bytes, (int) b, (int) e, im);
+        });
     }
+    return true;
 }
 
 #ifndef HALIDE_NO_PNG
@@ -427,16 +566,13 @@ bool load_png(const std::string &filename, ImageType *im) {
     png_read_update_info(png_ptr, info_ptr);
 
     auto copy_to_image = bit_depth == 8 ?
-        Internal::read_big_endian_row<uint8_t, ImageType> :
-        Internal::read_big_endian_row<uint16_t, ImageType>;
+        Internal::read_big_endian_rows<uint8_t, ImageType> :
+        Internal::read_big_endian_rows<uint16_t, ImageType>;
 
-    std::vector<uint8_t> row(png_get_rowbytes(png_ptr, info_ptr));
-    const int ymin = im->dim(1).min();
-    const int ymax = im->dim(1).max();
-    for (int y = ymin; y <= ymax; ++y) {
-        png_read_row(png_ptr, row.data(), nullptr);
-        copy_to_image(row.data(), y, im);
-    }
+    Internal::decode_rows(im, png_get_rowbytes(png_ptr, info_ptr), copy_to_image, [&](uint8_t *row) {
+        png_read_row(png_ptr, row, nullptr);
+        return true;
+    });
 
     png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
 
@@ -583,20 +719,24 @@ bool load_pnm(const std::string &filename, int channels, ImageType *im) {
     *im = ImageType(im_type, im_dimensions);
 
     auto copy_to_image = bit_depth == 8 ?
-        Internal::read_big_endian_row<uint8_t, ImageType> :
-        Internal::read_big_endian_row<uint16_t, ImageType>;
+        Internal::read_big_endian_rows<uint8_t, ImageType> :
+        Internal::read_big_endian_rows<uint16_t, ImageType>;
+
+    const size_t row_bytes = (size_t) width * channels * (bit_depth / 8);
+    bool ok = Internal::decode_rows(im, row_bytes, copy_to_image, [&](uint8_t *row) {
+        return f.read_bytes(row, row_bytes);
+    });
+    return check(ok, "Could not read data");
+}
 
-    std::vector<uint8_t> row(width * channels * (bit_depth / 8));
-    const int ymin = im->dim(1).min();
-    const int ymax = im->dim(1).max();
-    for (int y = ymin; y <= ymax; ++y) {
-        if (!check(f.read_vector(&row), "Could not read data")) {
-            return false;
-        }
-        copy_to_image(row.data(), y, im);
+template<Internal::CheckFunc check>
+bool write_pnm_header(Internal::FileOpener &f, int channels, int width, int height, int bit_depth) {
+    if (!check(f.f != nullptr, "File could not be opened for writing")) {
+        return false;
     }
-
-    return true;
+    const char *hdr_fmt = channels == 3 ? "P6" : "P5";
+    return check(fprintf(f.f, "%s\n%d %d\n%d\n", hdr_fmt, width, height, (1<<bit_depth)-1) > 0,
+                 "Could not write header");
 }
 
 template<typename ImageType, Internal::CheckFunc check = Internal::CheckReturn>
@@ -615,11 +755,9 @@ bool save_pnm(ImageType &im, const int channels, const std::string &filename) {
     const int bit_depth = im_type.bits;
 
     Internal::FileOpener f(filename, "wb");
-    if (!check(f.f != nullptr, "File could not be opened for writing")) {
+    if (!Internal::write_pnm_header<check>(f, channels, width, height, bit_depth)) {
         return false;
     }
-    const char *hdr_fmt = channels == 3 ? "P6" : "P5";
-    fprintf(f.f, "%s\n%d %d\n%d\n", hdr_fmt, width, height, (1<<bit_depth)-1);
 
     auto copy_from_image = bit_depth == 8 ?
         Internal::write_big_endian_row<uint8_t, ImageType> :
@@ -706,16 +844,11 @@ bool load_jpg(const std::string &filename, ImageType *im) {
     }
     *im = ImageType(im_type, im_dimensions);
 
-    auto copy_to_image = Internal::read_big_endian_row<uint8_t, ImageType>;
+    auto copy_to_image = Internal::read_big_endian_rows<uint8_t, ImageType>;
 
-    std::vector<uint8_t> row(width * channels);
-    const int ymin = im->dim(1).min();
-    const int ymax = im->dim(1).max();
-    for (int y = ymin; y <= ymax; ++y) {
-        uint8_t *src = row.data();
-        jpeg_read_scanlines(&cinfo, &src, 1);
-        copy_to_image(row.data(), y, im);
-    }
+    Internal::decode_rows(im, (size_t) width * channels, copy_to_image, [&](uint8_t *row) {
+        return jpeg_read_scanlines(&cinfo, &row, 1) == 1;
+    });
 
     jpeg_finish_decompress(&cinfo);
     jpeg_destroy_decompress(&cinfo);
@@ -807,7 +940,7 @@ inline const halide_type_t *tmp_code_to_halide_type() {
 template<typename ImageType>
 bool buffer_is_compact_planar(ImageType &im) {
     const halide_type_t im_type = im.type();
-    const size_t elem_size = (im_type.bits / 8);
+    const size_t elem_size = im_type.bytes();
     if (((uint8_t*)im.begin() + (im.number_of_elements() * elem_size)) != (uint8_t*) im.end()) {
         return false;
     }
@@ -825,12 +958,8 @@ bool buffer_is_compact_planar(ImageType &im) {
     return true;
 }
 
-// ".tmp" is a file format used by the ImageStack tool (see https://github.com/abadams/ImageStack)
-template<typename ImageType, CheckFunc check = CheckReturn>
-bool load_tmp(const std::string &filename, ImageType *im) {
-    static_assert(!ImageType::has_static_halide_type, "");
-
-    FileOpener f(filename, "rb");
+template<CheckFunc check>
+bool read_tmp_header(FileOpener &f, halide_type_t *im_type, std::vector<int> *im_dimensions) {
     if (!check(f.f != nullptr, "File could not be opened for reading")) {
         return false;
     }
@@ -845,8 +974,22 @@ bool load_tmp(const std::string &filename, ImageType *im) {
         return false;
     }
 
-    const halide_type_t im_type = tmp_code_to_halide_type()[header[4]];
-    std::vector<int> im_dimensions = { header[0], header[1], header[2], header[3] };
+    *im_type = tmp_code_to_halide_type()[header[4]];
+    *im_dimensions = { header[0], header[1], header[2], header[3] };
+    return true;
+}
+
+// ".tmp" is a file format used by the ImageStack tool (see https://github.com/abadams/ImageStack)
+template<typename ImageType, CheckFunc check = CheckReturn>
+bool load_tmp(const std::string &filename, ImageType *im) {
+    static_assert(!ImageType::has_static_halide_type, "");
+
+    FileOpener f(filename, "rb");
+    halide_type_t im_type;
+    std::vector<int> im_dimensions;
+    if (!read_tmp_header<check>(f, &im_type, &im_dimensions)) {
+        return false;
+    }
     *im = ImageType(im_type, im_dimensions);
 
     // This should never fail unless the default Buffer<> constructor behavior changes.
@@ -899,20 +1042,18 @@ bool write_planar_payload(ImageType &im, FileOpener &f) {
     return true;
 }
 
-// ".tmp" is a file format used by the ImageStack tool (see https://github.com/abadams/ImageStack)
-template<typename ImageType, CheckFunc check = CheckReturn>
-bool save_tmp(ImageType &im, const std::string &filename) {
-    static_assert(!ImageType::has_static_halide_type, "");
-
-    im.copy_to_host();
-
+template<CheckFunc check>
+bool write_tmp_header(FileOpener &f, halide_type_t im_type, const std::vector<int> &extents) {
+    if (!check(extents.size() <= 4, "Too many dimensions for .tmp file")) {
+        return false;
+    }
     int32_t header[5] = { 1, 1, 1, 1, -1 };
-    for (int i = 0; i < im.dimensions(); ++i) {
-        header[i] = im.dim(i).extent();
+    for (size_t i = 0; i < extents.size(); ++i) {
+        header[i] = extents[i];
     }
     auto *table = tmp_code_to_halide_type();
     for (int i = 0; i < kNumTmpCodes; i++) {
-        if (im.type() == table[i]) {
+        if (im_type == table[i]) {
             header[4] = i;
             break;
         }
@@ -921,11 +1062,26 @@ bool save_tmp(ImageType &im, const std::string &filename) {
         return false;
     }
 
-    FileOpener f(filename, "wb");
     if (!check(f.f != nullptr, "File could not be opened for writing")) {
         return false;
     }
-    if (!check(f.write_array(header), "Could not write .tmp header")) {
+    return check(f.write_array(header), "Could not write .tmp header");
+}
+
+// ".tmp" is a file format used by the ImageStack tool (see https://github.com/abadams/ImageStack)
+template<typename ImageType, CheckFunc check = CheckReturn>
+bool save_tmp(ImageType &im, const std::string &filename) {
+    static_assert(!ImageType::has_static_halide_type, "");
+
+    im.copy_to_host();
+
+    std::vector<int> extents(im.dimensions());
+    for (int i = 0; i < im.dimensions(); ++i) {
+        extents[i] = im.dim(i).extent();
+    }
+
+    FileOpener f(filename, "wb");
+    if (!write_tmp_header<check>(f, im.type(), extents)) {
         return false;
     }
 
@@ -973,11 +1129,8 @@ enum MatlabClassCode {
     mxUINT64_CLASS = 15
 };
 
-template<typename ImageType, CheckFunc check = CheckReturn>
-bool load_mat(const std::string &filename, ImageType *im) {
-    static_assert(!ImageType::has_static_halide_type, "");
-
-    FileOpener f(filename, "rb");
+template<CheckFunc check>
+bool read_mat_header(FileOpener &f, halide_type_t *type, std::vector<int> *extents) {
     if (!check(f.f != nullptr, "File could not be opened for reading")) {
         return false;
     }
@@ -1014,8 +1167,8 @@ bool load_mat(const std::string &filename, ImageType *im) {
         return false;
     }
     int dims = shape_header[1]/4;
-    std::vector<int> extents(dims);
-    if (!check(f.read_vector(&extents), "Could not read .mat header\n")) {
+    extents->resize(dims);
+    if (!check(f.read_vector(extents), "Could not read .mat header\n")) {
         return false;
     }
     if (dims & 1) {
@@ -1049,38 +1202,53 @@ bool load_mat(const std::string &filename, ImageType *im) {
     if (!check(f.read_array(payload_header), "Could not read .mat header\n")) {
         return false;
     }
-    halide_type_t type;
     switch (payload_header[0]) {
     case miINT8:
-        type = halide_type_of<int8_t>();
+        *type = halide_type_of<int8_t>();
         break;
     case miINT16:
-        type = halide_type_of<int16_t>();
+        *type = halide_type_of<int16_t>();
         break;
     case miINT32:
-        type = halide_type_of<int32_t>();
+        *type = halide_type_of<int32_t>();
         break;
     case miINT64:
-        type = halide_type_of<int64_t>();
+        *type = halide_type_of<int64_t>();
         break;
     case miUINT8:
-        type = halide_type_of<uint8_t>();
+        *type = halide_type_of<uint8_t>();
         break;
     case miUINT16:
-        type = halide_type_of<uint16_t>();
+        *type = halide_type_of<uint16_t>();
         break;
     case miUINT32:
-        type = halide_type_of<uint32_t>();
+        *type = halide_type_of<uint32_t>();
         break;
     case miUINT64:
-        type = halide_type_of<uint64_t>();
+        *type = halide_type_of<uint64_t>();
         break;
     case miSINGLE:
-        type = halide_type_of<float>();
+        *type = halide_type_of<float>();
         break;
     case miDOUBLE:
-        type = halide_type_of<double>();
+        *type = halide_type_of<double>();
         break;
+    default:
+        return check(false, "Could not parse this .mat file: unsupported payload type\n");
+    }
+
+    return true;
+}
+
+template<typename ImageType, CheckFunc check = CheckReturn>
+bool load_mat(const std::string &filename, ImageType *im) {
+    static_assert(!ImageType::has_static_halide_type, "");
+
+    FileOpener f(filename, "rb");
+    halide_type_t type;
+    std::vector<int> extents;
+    if (!read_mat_header<check>(f, &type, &extents)) {
+        return false;
     }
 
     *im = ImageType(type, extents);
@@ -1120,16 +1288,13 @@ inline const std::set<FormatInfo> &query_mat() {
     return info;
 }
 
-template<typename ImageType, CheckFunc check = CheckReturn>
-bool save_mat(ImageType &im, const std::string &filename) {
-    static_assert(!ImageType::has_static_halide_type, "");
-
-    im.copy_to_host();
-
+template<CheckFunc check>
+bool write_mat_header(FileOpener &f, const std::string &filename, halide_type_t im_type,
+                      const std::vector<int> &im_extents, uint32_t *padding_bytes) {
     uint32_t class_code = 0, type_code = 0;
-    switch (im.raw_buffer()->type.code) {
+    switch (im_type.code) {
     case halide_type_int:
-        switch (im.raw_buffer()->type.bits) {
+        switch (im_type.bits) {
         case 8:
             class_code = mxINT8_CLASS;
             type_code = miINT8;
@@ -1151,7 +1316,7 @@ bool save_mat(ImageType &im, const std::string &filename) {
         };
         break;
     case halide_type_uint:
-        switch (im.raw_buffer()->type.bits) {
+        switch (im_type.bits) {
         case 8:
             class_code = mxUINT8_CLASS;
             type_code = miUINT8;
@@ -1173,7 +1338,7 @@ bool save_mat(ImageType &im, const std::string &filename) {
         };
         break;
     case halide_type_float:
-        switch (im.raw_buffer()->type.bits) {
+        switch (im_type.bits) {
         case 32:
             class_code = mxSINGLE_CLASS;
             type_code = miSINGLE;
@@ -1190,7 +1355,6 @@ bool save_mat(ImageType &im, const std::string &filename) {
         check(false, "unreachable");
     }
 
-    FileOpener f(filename, "wb");
     if (!check(f.f != nullptr, "File could not be opened for writing")) {
         return false;
     }
@@ -1227,13 +1391,16 @@ bool save_mat(ImageType &im, const std::string &filename) {
     header[126] = 'I';
     header[127] = 'M';
 
-    uint64_t payload_bytes = im.size_in_bytes();
+    uint64_t payload_bytes = im_type.bytes();
+    for (int e : im_extents) {
+        payload_bytes *= e;
+    }
 
     if (!check((payload_bytes >> 32) == 0, "Buffer too large to save as .mat")) {
         return false;
     }
 
-    int dims = im.dimensions();
+    int dims = (int)im_extents.size();
     if (dims < 2) {
         dims = 2;
     }
@@ -1251,12 +1418,9 @@ bool save_mat(ImageType &im, const std::string &filename) {
 
     // Shape
     int32_t shape[2] = {
-        miINT32, im.dimensions() * 4,
+        miINT32, (int32_t)im_extents.size() * 4,
     };
-    std::vector<int> extents(im.dimensions());
-    for (int d = 0; d < im.dimensions(); d++) {
-        extents[d] = im.dim(d).extent();
-    }
+    std::vector<int> extents(im_extents);
     while ((int)extents.size() < dims) {
         extents.push_back(1);
     }
@@ -1269,7 +1433,7 @@ bool save_mat(ImageType &im, const std::string &filename) {
         miINT8, name_size
     };
 
-    uint32_t padding_bytes = 7 - ((payload_bytes - 1) & 7);
+    *padding_bytes = 7 - ((payload_bytes - 1) & 7);
 
     // Payload header
     uint32_t payload_header[2] = {
@@ -1286,7 +1450,22 @@ bool save_mat(ImageType &im, const std::string &filename) {
         f.write_bytes(&name[0], name.size()) &&
         f.write_array(payload_header);
 
-    if (!check(success, "Could not write .mat header")) {
+    return check(success, "Could not write .mat header");
+}
+
+template<typename ImageType, CheckFunc check = CheckReturn>
+bool save_mat(ImageType &im, const std::string &filename) {
+    static_assert(!ImageType::has_static_halide_type, "");
+
+    im.copy_to_host();
+
+    FileOpener f(filename, "wb");
+    std::vector<int> extents(im.dimensions());
+    for (int d = 0; d < im.dimensions(); d++) {
+        extents[d] = im.dim(d).extent();
+    }
+    uint32_t padding_bytes = 0;
+    if (!write_mat_header<check>(f, filename, im.type(), extents, &padding_bytes)) {
         return false;
     }
 
@@ -1306,6 +1485,440 @@ bool save_mat(ImageType &im, const std::string &filename) {
     return true;
 }
 
+// ".npy" is the NumPy array format documented here:
+// https://numpy.org/doc/stable/reference/generated/numpy.lib.format.html
+// The payload is always dense. A C-order array has its last axis varying
+// fastest, so its axes are reversed to become Halide dimensions; a
+// Fortran-order array maps onto Halide dimensions in order. Either way
+// the result is a compact planar Halide buffer, so no reshuffling of the
+// payload is ever needed. (Note that this differs from the Python
+// bindings, which keep numpy's axis order and use its strides as they
+// are, so a C-order array seen through them has its innermost
+// dimension last.)
+
+inline bool host_is_big_endian() {
+    const uint16_t one = 1;
+    return *(const uint8_t *) &one == 0;
+}
+
+inline void swap_bytes_in_place(void *data, size_t count, int elem_size) {
+    uint8_t *p = (uint8_t *) data;
+    for (size_t i = 0; i < count; i++, p += elem_size) {
+        std::reverse(p, p + elem_size);
+    }
+}
+
+inline std::string npy_descr(halide_type_t type) {
+    std::string descr;
+    if (type.bytes() == 1) {
+        descr += '|';
+    } else {
+        descr += host_is_big_endian() ? '>' : '<';
+    }
+    if (type.code == halide_type_uint && type.bits == 1) {
+        descr += 'b';
+    } else if (type.code == halide_type_int) {
+        descr += 'i';
+    } else if (type.code == halide_type_uint) {
+        descr += 'u';
+    } else {
+        descr += 'f';
+    }
+    descr += std::to_string(type.bytes());
+    return descr;
+}
+
+// Find the value following 'key': in the python dict literal that makes
+// up a .npy header. Returns std::string::npos if the key isn't present.
+inline size_t find_npy_header_value(const std::string &header, const std::string &key) {
+    size_t pos = header.find("'" + key + "'");
+    if (pos == std::string::npos) {
+        return pos;
+    }
+    pos = header.find(':', pos);
+    if (pos == std::string::npos) {
+        return pos;
+    }
+    return header.find_first_not_of(" ", pos + 1);
+}
+
+template<CheckFunc check>
+bool read_npy_header(FileOpener &f, halide_type_t *type, bool *swap_bytes, std::vector<int> *extents) {
+    if (!check(f.f != nullptr, "File could not be opened for reading")) {
+        return false;
+    }
+
+    uint8_t preamble[8];
+    if (!check(f.read_array(preamble), "Could not read .npy header\n")) {
+        return false;
+    }
+    if (!check(memcmp(preamble, "\x93NUMPY", 6) == 0, "Could not parse this .npy file: bad magic\n")) {
+        return false;
+    }
+    const int major_version = preamble[6];
+    uint32_t header_len = 0;
+    if (major_version == 1) {
+        uint8_t len[2];
+        if (!check(f.read_array(len), "Could not read .npy header\n")) {
+            return false;
+        }
+        header_len = len[0] | (len[1] << 8);
+    } else if (major_version == 2 || major_version == 3) {
+        uint8_t len[4];
+        if (!check(f.read_array(len), "Could not read .npy header\n")) {
+            return false;
+        }
+        header_len = len[0] | (len[1] << 8) | (len[2] << 16) | ((uint32_t) len[3] << 24);
+    } else {
+        return check(false, "Could not parse this .npy file: unknown version\n");
+    }
+
+    std::string header(header_len, ' ');
+    if (!check(f.read_bytes(&header[0], header_len), "Could not read .npy header\n")) {
+        return false;
+    }
+
+    // Element type
+    size_t pos = find_npy_header_value(header, "descr");
+    if (!check(pos != std::string::npos && header[pos] == '\'',
+               "Could not parse this .npy file: structured arrays are not supported\n")) {
+        return false;
+    }
+    size_t end = header.find('\'', pos + 1);
+    const std::string descr = header.substr(pos + 1, end == std::string::npos ? 0 : end - pos - 1);
+    if (!check(descr.size() >= 3, "Could not parse this .npy file: bad descr\n")) {
+        return false;
+    }
+    const char byte_order = descr[0];
+    const char kind = descr[1];
+    const int bytes = atoi(descr.c_str() + 2);
+    if (kind == 'b' && bytes == 1) {
+        *type = halide_type_t(halide_type_uint, 1);
+    } else if (kind == 'i' && (bytes == 1 || bytes == 2 || bytes == 4 || bytes == 8)) {
+        *type = halide_type_t(halide_type_int, bytes * 8);
+    } else if (kind == 'u' && (bytes == 1 || bytes == 2 || bytes == 4 || bytes == 8)) {
+        *type = halide_type_t(halide_type_uint, bytes * 8);
+    } else if (kind == 'f' && (bytes == 2 || bytes == 4 || bytes == 8)) {
+        *type = halide_type_t(halide_type_float, bytes * 8);
+    } else {
+        return check(false, "Could not parse this .npy file: unsupported element type\n");
+    }
+    *swap_bytes = bytes > 1 &&
+        ((byte_order == '>' && !host_is_big_endian()) ||
+         (byte_order == '<' && host_is_big_endian()));
+
+    // Memory order
+    pos = find_npy_header_value(header, "fortran_order");
+    if (!check(pos != std::string::npos, "Could not parse this .npy file: missing fortran_order\n")) {
+        return false;
+    }
+    const bool fortran_order = header.compare(pos, 4, "True") == 0;
+
+    // Shape
+    pos = find_npy_header_value(header, "shape");
+    if (!check(pos != std::string::npos && header[pos] == '(', "Could not parse this .npy file: bad shape\n")) {
+        return false;
+    }
+    std::vector<int> shape;
+    const char *p = header.c_str() + pos + 1;
+    while (true) {
+        while (*p == ' ' || *p == ',') {
+            p++;
+        }
+        if (*p == ')') {
+            break;
+        }
+        char *next;
+        const long long e = strtoll(p, &next, 10);
+        if (!check(next != p && e >= 0 && e <= 0x7fffffff,
+                   "Could not parse this .npy file: bad shape\n")) {
+            return false;
+        }
+        shape.push_back((int) e);
+        p = next;
+    }
+    if (fortran_order) {
+        *extents = shape;
+    } else {
+        extents->assign(shape.rbegin(), shape.rend());
+    }
+    return true;
+}
+
+template<typename ImageType, CheckFunc check = CheckReturn>
+bool load_npy(const std::string &filename, ImageType *im) {
+    static_assert(!ImageType::has_static_halide_type, "");
+
+    FileOpener f(filename, "rb");
+    halide_type_t type;
+    bool swap_bytes;
+    std::vector<int> extents;
+    if (!read_npy_header<check>(f, &type, &swap_bytes, &extents)) {
+        return false;
+    }
+
+    *im = ImageType(type, extents);
+    if (im->number_of_elements() == 0) {
+        // Arrays with a zero extent have no payload.
+        return true;
+    }
+
+    // This should never fail unless the default Buffer<> constructor behavior changes.
+    if (!check(buffer_is_compact_planar(*im), "load_npy() requires compact planar images")) {
+        return false;
+    }
+
+    if (!check(f.read_bytes(im->begin(), im->size_in_bytes()), "Could not read .npy payload")) {
+        return false;
+    }
+    if (swap_bytes) {
+        swap_bytes_in_place(im->begin(), im->number_of_elements(), type.bytes());
+    }
+
+    im->set_host_dirty();
+    return true;
+}
+
+inline const std::set<FormatInfo> &query_npy() {
+    // Our support arbitrarily stops at 16 dimensions.
+    static std::set<FormatInfo> info = []() {
+        std::set<FormatInfo> s;
+        for (int i = 0; i < 16; i++) {
+            s.insert({ halide_type_t(halide_type_float, 16), i });
+            s.insert({ halide_type_t(halide_type_float, 32), i });
+            s.insert({ halide_type_t(halide_type_float, 64), i });
+            s.insert({ halide_type_t(halide_type_uint, 1), i });
+            s.insert({ halide_type_t(halide_type_uint, 8), i });
+            s.insert({ halide_type_t(halide_type_int, 8), i });
+            s.insert({ halide_type_t(halide_type_uint, 16), i });
+            s.insert({ halide_type_t(halide_type_int, 16), i });
+            s.insert({ halide_type_t(halide_type_uint, 32), i });
+            s.insert({ halide_type_t(halide_type_int, 32), i });
+            s.insert({ halide_type_t(halide_type_uint, 64), i });
+            s.insert({ halide_type_t(halide_type_int, 64), i });
+        }
+        return s;
+    }();
+    return info;
+}
+
+// Always writes C order, with the Halide dimensions reversed, so that
+// load_npy() round-trips and numpy sees the innermost dimension last.
+template<CheckFunc check>
+bool write_npy_header(FileOpener &f, halide_type_t type, const std::vector<int> &extents) {
+    if (!check(f.f != nullptr, "File could not be opened for writing")) {
+        return false;
+    }
+
+    const int dims = (int) extents.size();
+    std::string header = "{'descr': '" + npy_descr(type) + "', 'fortran_order': False, 'shape': (";
+    for (int d = dims - 1; d >= 0; d--) {
+        header += std::to_string(extents[d]);
+        if (d > 0 || dims == 1) {
+            header += ",";
+        }
+        if (d > 0) {
+            header += " ";
+        }
+    }
+    header += "), }";
+
+    // Pad with spaces so the payload starts on a 64-byte boundary, then
+    // terminate with a newline.
+    const size_t preamble_size = header.size() + 64 < 65536 ? 10 : 12;
+    while ((preamble_size + header.size() + 1) % 64 != 0) {
+        header += ' ';
+    }
+    header += '\n';
+
+    std::vector<uint8_t> preamble = { 0x93, 'N', 'U', 'M', 'P', 'Y' };
+    const uint32_t header_len = (uint32_t) header.size();
+    if (preamble_size == 10) {
+        preamble.insert(preamble.end(), { 1, 0, (uint8_t) header_len, (uint8_t) (header_len >> 8) });
+    } else {
+        preamble.insert(preamble.end(), { 2, 0, (uint8_t) header_len, (uint8_t) (header_len >> 8),
+                                          (uint8_t) (header_len >> 16), (uint8_t) (header_len >> 24) });
+    }
+
+    return check(f.write_vector(preamble) && f.write_bytes(header.data(), header.size()),
+                 "Could not write .npy header");
+}
+
+template<typename ImageType, CheckFunc check = CheckReturn>
+bool save_npy(ImageType &im, const std::string &filename) {
+    static_assert(!ImageType::has_static_halide_type, "");
+
+    im.copy_to_host();
+
+    std::vector<int> extents(im.dimensions());
+    for (int d = 0; d < im.dimensions(); d++) {
+        extents[d] = im.dim(d).extent();
+    }
+
+    FileOpener f(filename, "wb");
+    if (!write_npy_header<check>(f, im.type(), extents)) {
+        return false;
+    }
+
+    return write_planar_payload<ImageType, check>(im, f);
+}
+
+
+// Decompress an LZ4 frame (https://github.com/lz4/lz4/blob/dev/doc/lz4_Frame_format.md),
+// such as those written by debug_to_file for filenames ending in ".lz4".
+template<CheckFunc check>
+bool decompress_lz4_frame(const std::vector<uint8_t> &in, std::vector<uint8_t> *out) {
+    const char *corrupt = "Corrupt .lz4 file";
+    auto read_u32 = [&](size_t pos) {
+        return (uint32_t)in[pos] | ((uint32_t)in[pos + 1] << 8) |
+            ((uint32_t)in[pos + 2] << 16) | ((uint32_t)in[pos + 3] << 24);
+    };
+    if (!check(in.size() >= 7 && read_u32(0) == 0x184D2204 && (in[4] >> 6) == 1,
+               "Not an .lz4 file")) {
+        return false;
+    }
+    const uint8_t flags = in[4];
+    const bool block_checksums = flags & 0x10;
+    const bool content_size = flags & 0x08;
+    const bool content_checksum = flags & 0x04;
+    const bool dictionary_id = flags & 0x01;
+    size_t ip = 6 + (content_size ? 8 : 0) + (dictionary_id ? 4 : 0) + 1;
+
+    out->clear();
+    while (true) {
+        if (!check(ip + 4 <= in.size(), corrupt)) {
+            return false;
+        }
+        uint32_t block_size = read_u32(ip);
+        ip += 4;
+        if (block_size == 0) {
+            break;
+        }
+        const bool stored = block_size & 0x80000000U;
+        block_size &= 0x7fffffffU;
+        if (!check(ip + block_size + (block_checksums ? 4 : 0) <= in.size(), corrupt)) {
+            return false;
+        }
+        const uint8_t *src = &in[ip];
+        const uint8_t *src_end = src + block_size;
+        ip += block_size + (block_checksums ? 4 : 0);
+        if (stored) {
+            out->insert(out->end(), src, src_end);
+            continue;
+        }
+        while (src < src_end) {
+            const uint8_t token = *src++;
+            size_t literals = token >> 4;
+            if (literals == 15) {
+                uint8_t b;
+                do {
+                    if (!check(src < src_end, corrupt)) {
+                        return false;
+                    }
+                    b = *src++;
+                    literals += b;
+                } while (b == 255);
+            }
+            if (!check((size_t)(src_end - src) >= literals, corrupt)) {
+                return false;
+            }
+            out->insert(out->end(), src, src + literals);
+            src += literals;
+            if (src == src_end) {
+                // The last sequence has no match.
+                break;
+            }
+            if (!check(src_end - src >= 2, corrupt)) {
+                return false;
+            }
+            const size_t offset = src[0] | (src[1] << 8);
+            src += 2;
+            size_t match_len = token & 15;
+            if (match_len == 15) {
+                uint8_t b;
+                do {
+                    if (!check(src < src_end, corrupt)) {
+                        return false;
+                    }
+                    b = *src++;
+                    match_len += b;
+                } while (b == 255);
+            }
+            match_len += 4;
+            if (!check(offset > 0 && offset <= out->size(), corrupt)) {
+                return false;
+            }
+            // Matches may overlap the bytes they produce, so copy
+            // byte by byte.
+            size_t from = out->size() - offset;
+            out->resize(out->size() + match_len);
+            uint8_t *dst = out->data();
+            for (size_t i = 0; i < match_len; i++) {
+                dst[from + offset + i] = dst[from + i];
+            }
+        }
+    }
+    return check(!content_checksum || ip + 4 <= in.size(), corrupt);
+}
+
+// A compressed .tmp file, as written by debug_to_file for filenames
+// ending in ".tmp.lz4": an LZ4 frame containing a .tmp file.
+template<typename ImageType, CheckFunc check = CheckReturn>
+bool load_lz4(const std::string &filename, ImageType *im) {
+    static_assert(!ImageType::has_static_halide_type, "");
+
+    const std::string inner = filename.substr(0, filename.size() - 4);
+    if (!check(get_lowercase_extension(inner) == "tmp", "Only .tmp.lz4 files can be loaded")) {
+        return false;
+    }
+
+    std::vector<uint8_t> compressed, data;
+    {
+        FileOpener f(filename, "rb");
+        if (!check(f.f != nullptr, "File could not be opened for reading")) {
+            return false;
+        }
+        uint8_t chunk[64 * 1024];
+        size_t n;
+        while ((n = fread(chunk, 1, sizeof(chunk), f.f)) > 0) {
+            compressed.insert(compressed.end(), chunk, chunk + n);
+        }
+    }
+    if (!decompress_lz4_frame<check>(compressed, &data)) {
+        return false;
+    }
+
+    int32_t header[5];
+    if (!check(data.size() >= sizeof(header), "Count not read .tmp header")) {
+        return false;
+    }
+    memcpy(header, data.data(), sizeof(header));
+    if (!check(header[0] > 0 && header[1] > 0 && header[2] > 0 && header[3] > 0 &&
+               header[4] >= 0 && header[4] < kNumTmpCodes, "Bad header on .tmp file")) {
+        return false;
+    }
+    *im = ImageType(tmp_code_to_halide_type()[header[4]], {header[0], header[1], header[2], header[3]});
+    if (!check(buffer_is_compact_planar(*im), "load_lz4() requires compact planar images")) {
+        return false;
+    }
+    if (!check(data.size() - sizeof(header) >= im->size_in_bytes(), "Count not read .tmp payload")) {
+        return false;
+    }
+    memcpy(im->begin(), data.data() + sizeof(header), im->size_in_bytes());
+    im->set_host_dirty();
+    return true;
+}
+
+template<typename ImageType, CheckFunc check = CheckReturn>
+bool save_lz4(ImageType &im, const std::string &filename) {
+    return check(false, "Saving .lz4 files is not supported");
+}
+
+inline const std::set<FormatInfo> &query_lz4() {
+    // Only loading is supported.
+    static std::set<FormatInfo> info;
+    return info;
+}
 
 template<typename ImageType, Internal::CheckFunc check>
 struct ImageIO {
@@ -1329,7 +1942,9 @@ bool find_imageio(const std::string &filename, ImageIO<ImageType, check> *result
 #endif
         {"ppm", {load_ppm<ImageType, check>, save_ppm<ImageType, check>, query_ppm}},
         {"tmp", {load_tmp<ImageType, check>, save_tmp<ImageType, check>, query_tmp}},
-        {"mat", {load_mat<ImageType, check>, save_mat<ImageType, check>, query_mat}}
+        {"mat", {load_mat<ImageType, check>, save_mat<ImageType, check>, query_mat}},
+        {"npy", {load_npy<ImageType, check>, save_npy<ImageType, check>, query_npy}},
+        {"lz4", {load_lz4<ImageType, check>, save_lz4<ImageType, check>, query_lz4}}
     };
     std::string ext = Internal::get_lowercase_extension(filename);
     auto it = m.find(ext);
@@ -1385,6 +2000,194 @@ FormatInfo best_save_format(const ImageType &im, const std::set<FormatInfo> &inf
     return best;
 }
 
+// A whole file mapped into memory. The mapping is private
+// (copy-on-write), so modifying a Buffer that wraps it never changes
+// the file on disk.
+struct MappedFile {
+    void *addr;
+    size_t size;
+
+    // Map the named file, returning nullptr if the file can't be
+    // mapped (including on platforms without mmap).
+    static MappedFile *map(const std::string &filename) {
+#ifdef _WIN32
+        return nullptr;
+#else
+        int fd = ::open(filename.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return nullptr;
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+            ::close(fd);
+            return nullptr;
+        }
+        void *addr = mmap(nullptr, (size_t) st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        // The mapping keeps the file alive; we don't need the descriptor.
+        ::close(fd);
+        if (addr == MAP_FAILED) {
+            return nullptr;
+        }
+        return new MappedFile{addr, (size_t) st.st_size};
+#endif
+    }
+
+    // Suitable for use as the release function of Buffer::adopt_host.
+    static void release(void *ctx) {
+        MappedFile *m = (MappedFile *) ctx;
+#ifndef _WIN32
+        munmap(m->addr, m->size);
+#endif
+        delete m;
+    }
+};
+
+// Wrap the bytes at the given offset of a file in an image of the given
+// type and shape, without copying. On success the image owns the
+// mapping. Returns false without touching *im if the payload can't be
+// used in-place (the file can't be mapped, or the payload is
+// misaligned for its element type); the caller should fall back to a
+// regular load in that case.
+template<typename ImageType>
+bool try_map_payload(const std::string &filename, size_t offset, halide_type_t type,
+                     const std::vector<halide_dimension_t> &shape, ImageType *im) {
+    if (offset % type.bytes() != 0) {
+        return false;
+    }
+    size_t payload_bytes = type.bytes();
+    for (const halide_dimension_t &d : shape) {
+        payload_bytes += (size_t) (d.extent - 1) * d.stride * type.bytes();
+    }
+    MappedFile *m = MappedFile::map(filename);
+    if (m == nullptr) {
+        return false;
+    }
+    if (offset + payload_bytes > m->size) {
+        // Truncated file: let the regular loader report the error.
+        MappedFile::release(m);
+        return false;
+    }
+    *im = ImageType(type, (uint8_t *) m->addr + offset, (int) shape.size(), shape.data());
+    im->adopt_host(MappedFile::release, m);
+    im->set_host_dirty();
+    return true;
+}
+
+// The dense planar layout used by .tmp and .mat payloads.
+inline std::vector<halide_dimension_t> planar_shape(const std::vector<int> &extents) {
+    std::vector<halide_dimension_t> shape;
+    int32_t stride = 1;
+    for (int e : extents) {
+        shape.emplace_back(0, e, stride);
+        stride *= e;
+    }
+    return shape;
+}
+
+template<typename ImageType, CheckFunc check = CheckReturn>
+bool load_mapped_tmp(const std::string &filename, ImageType *im) {
+    static_assert(!ImageType::has_static_halide_type, "");
+
+    halide_type_t im_type;
+    std::vector<int> im_dimensions;
+    long offset;
+    {
+        FileOpener f(filename, "rb");
+        if (!read_tmp_header<check>(f, &im_type, &im_dimensions)) {
+            return false;
+        }
+        offset = ftell(f.f);
+    }
+    if (try_map_payload(filename, offset, im_type, planar_shape(im_dimensions), im)) {
+        return true;
+    }
+    return load_tmp<ImageType, check>(filename, im);
+}
+
+template<typename ImageType, CheckFunc check = CheckReturn>
+bool load_mapped_npy(const std::string &filename, ImageType *im) {
+    static_assert(!ImageType::has_static_halide_type, "");
+
+    halide_type_t im_type;
+    bool swap_bytes;
+    std::vector<int> extents;
+    long offset;
+    {
+        FileOpener f(filename, "rb");
+        if (!read_npy_header<check>(f, &im_type, &swap_bytes, &extents)) {
+            return false;
+        }
+        offset = ftell(f.f);
+    }
+    // Foreign-endian payloads have to be swapped, which needs a copy,
+    // and empty arrays have nothing to map.
+    const bool empty = std::find(extents.begin(), extents.end(), 0) != extents.end();
+    if (!swap_bytes && !empty && try_map_payload(filename, offset, im_type, planar_shape(extents), im)) {
+        return true;
+    }
+    return load_npy<ImageType, check>(filename, im);
+}
+
+template<typename ImageType, CheckFunc check = CheckReturn>
+bool load_mapped_mat(const std::string &filename, ImageType *im) {
+    static_assert(!ImageType::has_static_halide_type, "");
+
+    halide_type_t im_type;
+    std::vector<int> extents;
+    long offset;
+    {
+        FileOpener f(filename, "rb");
+        if (!read_mat_header<check>(f, &im_type, &extents)) {
+            return false;
+        }
+        offset = ftell(f.f);
+    }
+    if (try_map_payload(filename, offset, im_type, planar_shape(extents), im)) {
+        return true;
+    }
+    return load_mat<ImageType, check>(filename, im);
+}
+
+// PNM payloads are interleaved and big-endian, so 16-bit files can only
+// be used in-place on big-endian hosts.
+template<typename ImageType, CheckFunc check = CheckReturn>
+bool load_mapped_pnm(const std::string &filename, int channels, ImageType *im) {
+    static_assert(!ImageType::has_static_halide_type, "");
+
+    int width, height, bit_depth;
+    long offset;
+    {
+        FileOpener f(filename, "rb");
+        if (!read_pnm_header<check>(f, channels == 3 ? "P6" : "P5", &width, &height, &bit_depth)) {
+            return false;
+        }
+        offset = ftell(f.f);
+    }
+    if (bit_depth == 8 || host_is_big_endian()) {
+        std::vector<halide_dimension_t> shape = {
+            {0, width, channels},
+            {0, height, width * channels}
+        };
+        if (channels > 1) {
+            shape.emplace_back(0, channels, 1);
+        }
+        if (try_map_payload(filename, offset, halide_type_t(halide_type_uint, bit_depth), shape, im)) {
+            return true;
+        }
+    }
+    return load_pnm<ImageType, check>(filename, channels, im);
+}
+
+template<typename ImageType, CheckFunc check = CheckReturn>
+bool load_mapped_pgm(const std::string &filename, ImageType *im) {
+    return load_mapped_pnm<ImageType, check>(filename, 1, im);
+}
+
+template<typename ImageType, CheckFunc check = CheckReturn>
+bool load_mapped_ppm(const std::string &filename, ImageType *im) {
+    return load_mapped_pnm<ImageType, check>(filename, 3, im);
+}
+
 }  // namespace Internal
 
 struct ImageTypeConversion {
@@ -1412,11 +2215,30 @@ struct ImageTypeConversion {
         using DstImageType = typename Internal::ImageTypeWithElemType<ImageType, DstElemType>::type;
 
         DstImageType dst = DstImageType::make_with_shape_of(src);
-        const auto converter = [](DstElemType &dst_elem, SrcElemType src_elem) {
-            dst_elem = Internal::convert<DstElemType>(src_elem);
-        };
-        // TODO: do we need src.copy_to_host() here?
-        dst.for_each_value(converter, src);
+
+        // If src is dense, dst has exactly the same layout, so the
+        // conversion is a flat loop over memory that the compiler can
+        // vectorize and that we can split across threads.
+        bool same_layout = (size_t) ((const uint8_t *) src.end() - (const uint8_t *) src.begin()) ==
+                           src.number_of_elements() * sizeof(SrcElemType);
+        for (int d = 0; d < src.dimensions() && same_layout; d++) {
+            same_layout = src.dim(d).stride() == dst.dim(d).stride();
+        }
+        if (same_layout) {
+            const SrcElemType *src_elems = (const SrcElemType *) src.begin();
+            DstElemType *dst_elems = (DstElemType *) dst.begin();
+            Internal::parallel_for_ranges(0, (int64_t) src.number_of_elements(), 1 << 18, [=](int64_t b, int64_t e) {
+                for (int64_t i = b; i < e; i++) {
+                    dst_elems[i] = Internal::convert<DstElemType>(src_elems[i]);
+                }
+            });
+        } else {
+            const auto converter = [](DstElemType &dst_elem, SrcElemType src_elem) {
+                dst_elem = Internal::convert<DstElemType>(src_elem);
+            };
+            // TODO: do we need src.copy_to_host() here?
+            dst.for_each_value(converter, src);
+        }
         dst.set_host_dirty();
 
         return dst;
@@ -1589,6 +2411,45 @@ bool load(const std::string &filename, ImageType *im) {
     return true;
 }
 
+// Like load(), but for uncompressed formats (.tmp, .mat, .npy, .pgm,
+// .ppm) the returned Image refers directly to a private memory mapping
+// of the file rather than to a copy of its contents; the mapping is
+// released when the last Image sharing it is destroyed. Pages are read lazily, so
+// touching a small region of a very large file is cheap. Writes to the
+// Image are never written back to the file. Formats (or files) that
+// can't be used in-place, e.g. 16-bit PNM on little-endian hosts, are
+// quietly loaded with a regular copy instead. ImageType must support
+// adopt_host(), as Halide::Buffer and Halide::Runtime::Buffer do.
+// Returns false upon failure.
+template<typename ImageType, Internal::CheckFunc check = Internal::CheckReturn>
+bool load_mapped(const std::string &filename, ImageType *im) {
+    using DynamicImageType = typename Internal::ImageTypeWithElemType<ImageType, void>::type;
+    using MappedLoader = bool (*)(const std::string &, DynamicImageType *);
+    const std::map<std::string, MappedLoader> m = {
+        {"mat", Internal::load_mapped_mat<DynamicImageType, check>},
+        {"npy", Internal::load_mapped_npy<DynamicImageType, check>},
+        {"pgm", Internal::load_mapped_pgm<DynamicImageType, check>},
+        {"ppm", Internal::load_mapped_ppm<DynamicImageType, check>},
+        {"tmp", Internal::load_mapped_tmp<DynamicImageType, check>}
+    };
+    auto it = m.find(Internal::get_lowercase_extension(filename));
+    if (it == m.end()) {
+        return load<ImageType, check>(filename, im);
+    }
+    DynamicImageType im_d;
+    if (!it->second(filename, &im_d)) {
+        return false;
+    }
+    if (ImageType::has_static_halide_type) {
+        const halide_type_t expected_type = ImageType::static_halide_type();
+        if (!check(im_d.type() == expected_type, "Image loaded did not match the expected type")) {
+            return false;
+        }
+    }
+    *im = im_d.template as<typename ImageType::ElemType>();
+    return true;
+}
+
 // Save the Image in the format associated with the filename's extension.
 // If the format can't represent the Image without losing data, fail.
 // Returns false upon failure.
@@ -1648,6 +2509,24 @@ private:
   const std::string filename;
 };
 
+// Fancy wrapper to call load_mapped() with CheckFail, inferring the
+// return type, in the same manner as load_image.
+class load_mapped_image {
+public:
+    load_mapped_image(const std::string &f) : filename(f) {}
+
+    template<typename ImageType>
+    operator ImageType() {
+        using DynamicImageType = typename Internal::ImageTypeWithElemType<ImageType, void>::type;
+        DynamicImageType im_d;
+        (void) load_mapped<DynamicImageType, Internal::CheckFail>(filename, &im_d);
+        return im_d.template as<typename ImageType::ElemType>();
+    }
+
+private:
+  const std::string filename;
+};
+
 // Like load_image, but quietly convert the loaded image to the type of the LHS
 // if necessary, discarding information if necessary.
 class load_and_convert_image {
@@ -1706,6 +2585,147 @@ void convert_and_save_image(ImageType &im, const std::string &filename) {
     }
 }
 
+// Writes an image to a .tmp, .mat, .npy, .pgm, or .ppm file
+// incrementally, so that the whole image never needs to be resident in
+// memory at once.
+// The type and extents of the full image are given up front; the data
+// is then appended in order as a sequence of chunks along the streaming
+// dimension. That's rows (dimension 1) for the interleaved PNM formats,
+// and the outermost dimension for the planar .tmp, .mat and .npy formats.
+// Each chunk must span the full extent of every other dimension, e.g.
+//
+//    ImageStreamWriter<Buffer<uint16_t>> out("big.tmp", halide_type_of<uint16_t>(), {w, h, 3, frames});
+//    for (int i = 0; i < frames; i++) {
+//        Buffer<uint16_t> frame = render_frame(i);  // w x h x 3 x 1
+//        out.write(frame);
+//    }
+//    out.close();
+//
+// Errors are reported through the check function, as in save().
+template<typename ImageType, Internal::CheckFunc check = Internal::CheckReturn>
+class ImageStreamWriter {
+public:
+    ImageStreamWriter(const std::string &filename, halide_type_t type, const std::vector<int> &extents)
+        : type(type), extents(extents) {
+        const std::string ext = Internal::get_lowercase_extension(filename);
+        f.reset(new Internal::FileOpener(filename, "wb"));
+        // Accept the same images as save() does.
+        if (ext == "tmp") {
+            streaming_dim = (int)extents.size() - 1;
+            ok = check(Internal::query_tmp().count({type, (int)extents.size()}) > 0,
+                       "Image cannot be saved in this format") &&
+                Internal::write_tmp_header<check>(*f, type, extents);
+        } else if (ext == "mat") {
+            streaming_dim = (int)extents.size() - 1;
+            ok = check(Internal::query_mat().count({type, (int)extents.size()}) > 0,
+                       "Image cannot be saved in this format") &&
+                Internal::write_mat_header<check>(*f, filename, type, extents, &padding_bytes);
+        } else if (ext == "npy") {
+            streaming_dim = (int)extents.size() - 1;
+            ok = check(Internal::query_npy().count({type, (int)extents.size()}) > 0,
+                       "Image cannot be saved in this format") &&
+                Internal::write_npy_header<check>(*f, type, extents);
+        } else if (ext == "pgm" || ext == "ppm") {
+            interleaved = true;
+            streaming_dim = 1;
+            const int channels = ext == "ppm" ? 3 : 1;
+            const std::set<FormatInfo> &info = ext == "ppm" ? Internal::query_ppm() : Internal::query_pgm();
+            ok = check(info.count({type, (int)extents.size()}) > 0 &&
+                       (channels == 1 || extents[2] == channels),
+                       "Image cannot be saved in this format") &&
+                Internal::write_pnm_header<check>(*f, channels, extents[0], extents[1], type.bits);
+        } else {
+            ok = check(false, "Streaming writes are only supported for .tmp, .mat, .npy, .pgm and .ppm files\n");
+        }
+        ok = ok && check(streaming_dim >= 0, "Cannot stream a zero-dimensional image");
+    }
+
+    ~ImageStreamWriter() {
+        if (f) {
+            (void) close();
+        }
+    }
+
+    // The dimension along which chunks are appended.
+    int streaming_dimension() const {
+        return streaming_dim;
+    }
+
+    // How much of the streaming dimension has been written so far.
+    int written() const {
+        return rows_written;
+    }
+
+    // Append the next chunk of the image.
+    bool write(ImageType &chunk) {
+        if (!check(ok && f, "Writing to a stream that failed or was already closed")) {
+            return false;
+        }
+        if (!check(chunk.type() == type && chunk.dimensions() == (int)extents.size(),
+                   "Chunk does not match the type and dimensionality of the stream")) {
+            return false;
+        }
+        for (int d = 0; d < chunk.dimensions(); d++) {
+            if (d != streaming_dim && !check(chunk.dim(d).extent() == extents[d],
+                                             "Chunk must span the full extent of all but the streaming dimension")) {
+                return false;
+            }
+        }
+        const int rows = chunk.dim(streaming_dim).extent();
+        if (!check(rows_written + rows <= extents[streaming_dim], "Too much data written to stream")) {
+            return false;
+        }
+
+        chunk.copy_to_host();
+        using DynamicImageType = typename Internal::ImageTypeWithElemType<ImageType, void>::type;
+        DynamicImageType chunk_d = chunk.template as<void>();
+        if (interleaved) {
+            auto copy_from_image = type.bits == 8 ?
+                Internal::write_big_endian_row<uint8_t, DynamicImageType> :
+                Internal::write_big_endian_row<uint16_t, DynamicImageType>;
+            const int channels = chunk_d.dimensions() > 2 ? chunk_d.dim(2).extent() : 1;
+            std::vector<uint8_t> row(chunk_d.dim(0).extent() * channels * (type.bits / 8));
+            for (int y = chunk_d.dim(1).min(); y <= chunk_d.dim(1).max(); y++) {
+                copy_from_image(chunk_d, y, row.data());
+                if (!check(f->write_vector(row), "Could not write data")) {
+                    return false;
+                }
+            }
+        } else if (!Internal::write_planar_payload<DynamicImageType, check>(chunk_d, *f)) {
+            return false;
+        }
+        rows_written += rows;
+        return true;
+    }
+
+    // Finish the file. Fails if less data was written than the header
+    // promised. Called by the destructor if necessary.
+    bool close() {
+        if (!f) {
+            return ok;
+        }
+        if (ok) {
+            ok = check(rows_written == extents[streaming_dim], "Stream closed before all data was written");
+        }
+        if (ok && padding_bytes) {
+            uint64_t padding = 0;
+            ok = check(f->write_bytes(&padding, padding_bytes), "Could not write .mat padding");
+        }
+        f.reset();
+        return ok;
+    }
+
+private:
+    std::unique_ptr<Internal::FileOpener> f;
+    const halide_type_t type;
+    const std::vector<int> extents;
+    int streaming_dim = -1;
+    int rows_written = 0;
+    uint32_t padding_bytes = 0;
+    bool interleaved = false;
+    bool ok = false;
+};
+
 }  // namespace Tools
 }  // namespace Halide
 
@@ -118,7 +118,7 @@ public:
             //      MachineParams machine_params(kParallelism, kLastLevelCacheSize, kBalance);
             //
             // The arguments to MachineParams are the maximum level of parallelism
-            // available, the size of the last-level cache (in KB), and the ratio
+            // available, the size of the last-level cache (in bytes), and the ratio
             // between the cost of a miss at the last level cache and the cost
             // of arithmetic on the target architecture, in that order.
 
@@ -5,6 +5,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
+#include <algorithm>
 #include <vector>
 #include <map>
 #include <string>
@@ -17,6 +18,10 @@
  * containing the final pixel values recorded for each traced Func.
  *
  * Currently dumps into supported Halide image formats.
+ *
+ * Alternatively, summarizes where the time went in a trace whose
+ * packets carry timestamps and thread ids, or replays the loads and
+ * stores in a trace through a simulated cache hierarchy.
  */
 
 using namespace Halide;
@@ -268,15 +273,648 @@ void finish_dump(map<string, FuncInfo> &func_info, BufferOutputOpts output_opts)
     printf("Done.\n");
 }
 
+// A production of a Func (or a whole pipeline), from the produce (or
+// begin_pipeline) event to the matching end event.
+struct Production {
+    string func;
+    int thread;
+    uint64_t start, end;
+    bool ended;
+    // The production this one ran within, or -1.
+    int parent;
+    vector<int> children;
+};
+
+struct TraceSummary {
+    vector<Production> productions;
+    vector<int> pipelines;
+
+    // Productions that haven't ended yet, by the id of the event that
+    // began them.
+    map<int, int> open;
+
+    // The productions open on each thread, innermost last.
+    map<int, vector<int>> open_on_thread;
+
+    int packets_without_ext = 0;
+
+    void add(const Packet &p) {
+        if (p.event != halide_trace_produce && p.event != halide_trace_end_produce &&
+            p.event != halide_trace_begin_pipeline && p.event != halide_trace_end_pipeline) {
+            return;
+        }
+        if (!p.has_ext()) {
+            packets_without_ext++;
+            return;
+        }
+        if (p.event == halide_trace_produce || p.event == halide_trace_begin_pipeline) {
+            begin(p);
+        } else {
+            end(p);
+        }
+    }
+
+    void begin(const Packet &p) {
+        Production prod;
+        prod.func = p.func();
+        prod.thread = p.thread_id();
+        prod.start = prod.end = p.time_ns();
+        prod.ended = false;
+
+        // The parent is the innermost production open on this thread. If
+        // there is none, this production is running on a worker thread on
+        // behalf of the most recently begun production still open.
+        prod.parent = -1;
+        vector<int> &stack = open_on_thread[prod.thread];
+        if (!stack.empty()) {
+            prod.parent = stack.back();
+        } else {
+            for (const auto &o : open) {
+                if (prod.parent < 0 || productions[o.second].start > productions[prod.parent].start) {
+                    prod.parent = o.second;
+                }
+            }
+        }
+
+        int idx = (int)productions.size();
+        if (prod.parent >= 0) {
+            productions[prod.parent].children.push_back(idx);
+        }
+        if (p.event == halide_trace_begin_pipeline) {
+            pipelines.push_back(idx);
+        }
+        productions.push_back(prod);
+        stack.push_back(idx);
+        open[p.id] = idx;
+    }
+
+    void end(const Packet &p) {
+        // End events have the begin event as their parent.
+        auto it = open.find(p.parent_id);
+        if (it == open.end()) {
+            return;
+        }
+        Production &prod = productions[it->second];
+        prod.end = std::max(prod.start, p.time_ns());
+        prod.ended = true;
+        vector<int> &stack = open_on_thread[prod.thread];
+        stack.erase(std::remove(stack.begin(), stack.end(), it->second), stack.end());
+        open.erase(it);
+    }
+
+    static uint64_t duration(const Production &p) {
+        return p.end - p.start;
+    }
+
+    // The length of the critical path through each production. The
+    // trace doesn't record dependencies, so we take one production to
+    // depend on another if it began after the other ended. The critical
+    // path through a production is then the time during which none of
+    // its children were running, plus the longest chain of its
+    // children in which each began after the one before it ended,
+    // counting the critical path through each.
+    vector<uint64_t> critical_paths() const {
+        vector<uint64_t> span(productions.size(), 0);
+        // Children always come after their parents.
+        for (int i = (int)productions.size() - 1; i >= 0; i--) {
+            const Production &p = productions[i];
+            if (!p.ended) continue;
+
+            vector<int> children;
+            for (int c : p.children) {
+                if (productions[c].ended) {
+                    children.push_back(c);
+                }
+            }
+
+            // Find the time covered by any child.
+            vector<std::pair<uint64_t, uint64_t>> intervals;
+            for (int c : children) {
+                intervals.push_back({productions[c].start, productions[c].end});
+            }
+            std::sort(intervals.begin(), intervals.end());
+            uint64_t covered = 0, cursor = p.start;
+            for (const auto &in : intervals) {
+                uint64_t lo = std::max(in.first, cursor);
+                uint64_t hi = std::min(in.second, p.end);
+                if (hi > lo) {
+                    covered += hi - lo;
+                    cursor = hi;
+                }
+            }
+
+            // Find the longest chain, considering the children in the
+            // order they ended. longest[k] is the longest chain among
+            // the first k of them.
+            std::sort(children.begin(), children.end(), [&](int a, int b) {
+                return productions[a].end < productions[b].end;
+            });
+            vector<uint64_t> ends, longest(children.size() + 1, 0);
+            for (int c : children) {
+                ends.push_back(productions[c].end);
+            }
+            for (size_t k = 0; k < children.size(); k++) {
+                const Production &child = productions[children[k]];
+                size_t before = std::upper_bound(ends.begin(), ends.begin() + k, child.start) - ends.begin();
+                longest[k + 1] = std::max(longest[k], longest[before] + span[children[k]]);
+            }
+
+            span[i] = (duration(p) - covered) + longest[children.size()];
+        }
+        return span;
+    }
+
+    void report() const {
+        if (packets_without_ext) {
+            printf("[WARNING] %d production packets have no timestamps and were ignored.\n",
+                   packets_without_ext);
+        }
+        if (productions.empty()) {
+            fprintf(stderr, "Error: no timestamped productions found. Trace the realizations of\n"
+                    "the pipeline (e.g. with the trace_realizations target feature) and\n"
+                    "write the trace with halide_default_trace, with HL_TRACE_TIMING=1.\n"
+                    "Aborting.\n");
+            exit(-1);
+        }
+
+        struct FuncStats {
+            int count = 0;
+            uint64_t total = 0, first_start = UINT64_MAX, last_end = 0;
+        };
+        map<string, FuncStats> funcs;
+        map<int, uint64_t> busy;
+        int unfinished = 0;
+        for (const Production &p : productions) {
+            if (!p.ended) {
+                unfinished++;
+                continue;
+            }
+            bool is_pipeline = std::find(pipelines.begin(), pipelines.end(), &p - &productions[0]) != pipelines.end();
+            if (!is_pipeline) {
+                FuncStats &f = funcs[p.func];
+                f.count++;
+                f.total += duration(p);
+                f.first_start = std::min(f.first_start, p.start);
+                f.last_end = std::max(f.last_end, p.end);
+                // Time in a production nested within another one on the
+                // same thread is already counted by the outer one.
+                if (p.parent < 0 || productions[p.parent].thread != p.thread ||
+                    std::find(pipelines.begin(), pipelines.end(), p.parent) != pipelines.end()) {
+                    busy[p.thread] += duration(p);
+                }
+            }
+        }
+        if (unfinished) {
+            printf("[WARNING] %d productions never ended and were ignored.\n", unfinished);
+        }
+
+        printf("\nTrace summary:\n");
+        printf("  Funcs (time in milliseconds):\n");
+        printf("    %-32s %10s %12s %12s\n", "Func", "Count", "Total", "Wall");
+        for (const auto &f : funcs) {
+            printf("    %-32s %10d %12.3f %12.3f\n", f.first.c_str(), f.second.count,
+                   f.second.total / 1e6, (f.second.last_end - f.second.first_start) / 1e6);
+        }
+
+        printf("  Threads (time in milliseconds):\n");
+        for (const auto &t : busy) {
+            printf("    %-6d busy %12.3f\n", t.first, t.second / 1e6);
+        }
+
+        vector<uint64_t> span = critical_paths();
+        printf("  Pipelines (time in milliseconds):\n");
+        for (int i : pipelines) {
+            const Production &p = productions[i];
+            if (!p.ended) continue;
+            uint64_t work = 0;
+            vector<int> pending = p.children;
+            while (!pending.empty()) {
+                int c = pending.back();
+                pending.pop_back();
+                const Production &child = productions[c];
+                if (productions[child.parent].thread != child.thread || child.parent == i) {
+                    work += duration(child);
+                }
+                pending.insert(pending.end(), child.children.begin(), child.children.end());
+            }
+            // Parallelism is the most speedup the critical path allows,
+            // and concurrency is how many threads were busy on average.
+            printf("    %s: wall %.3f, critical path %.3f, busy %.3f, parallelism %.2f, "
+                   "concurrency %.2f\n",
+                   p.func.c_str(), duration(p) / 1e6, span[i] / 1e6, work / 1e6,
+                   span[i] ? (double)work / span[i] : 0.0,
+                   duration(p) ? (double)work / duration(p) : 0.0);
+        }
+    }
+};
+
+// One level of a set-associative cache with LRU replacement.
+struct CacheLevel {
+    uint64_t size;
+    int ways, line_size, sets;
+
+    // The line address (plus one, so that zero means empty) held by each
+    // way of each set, and when it was last used.
+    vector<uint64_t> lines, last_used;
+    uint64_t clock = 0;
+
+    CacheLevel(uint64_t size, int ways, int line_size) :
+        size(size), ways(ways), line_size(line_size) {
+        sets = std::max<int>(1, (int)(size / ((uint64_t)ways * line_size)));
+        lines.resize((size_t)sets * ways, 0);
+        last_used.resize((size_t)sets * ways, 0);
+    }
+
+    // Access the byte at the given address. Returns true on a hit. On a
+    // miss, the line is brought in, evicting the least recently used
+    // line in its set.
+    bool access(uint64_t addr) {
+        uint64_t line = addr / line_size + 1;
+        size_t set = (size_t)(line % sets) * ways;
+        clock++;
+        size_t victim = set;
+        for (size_t w = set; w < set + ways; w++) {
+            if (lines[w] == line) {
+                last_used[w] = clock;
+                return true;
+            }
+            if (last_used[w] < last_used[victim]) {
+                victim = w;
+            }
+        }
+        lines[victim] = line;
+        last_used[victim] = clock;
+        return false;
+    }
+};
+
+// Parse a cache hierarchy of the form size:ways:line_size,... from the
+// fastest level outwards. Sizes may have a K or M suffix.
+vector<CacheLevel> parse_cache_config(const string &config) {
+    vector<CacheLevel> levels;
+    size_t start = 0;
+    while (start < config.size()) {
+        size_t end = config.find(',', start);
+        if (end == string::npos) {
+            end = config.size();
+        }
+        string level = config.substr(start, end - start);
+        char suffix = 0;
+        unsigned long long size = 0;
+        int ways = 0, line_size = 0;
+        if (sscanf(level.c_str(), "%llu%c:%d:%d", &size, &suffix, &ways, &line_size) == 4 &&
+            (suffix == 'K' || suffix == 'k' || suffix == 'M' || suffix == 'm')) {
+            size <<= (suffix == 'K' || suffix == 'k') ? 10 : 20;
+        } else if (sscanf(level.c_str(), "%llu:%d:%d", &size, &ways, &line_size) != 3) {
+            fprintf(stderr, "Error: can't parse cache level \"%s\". Expected size:ways:line_size.\n",
+                    level.c_str());
+            exit(-1);
+        }
+        if (size == 0 || ways <= 0 || line_size <= 0) {
+            fprintf(stderr, "Error: bad cache level \"%s\".\n", level.c_str());
+            exit(-1);
+        }
+        levels.emplace_back(size, ways, line_size);
+        start = end + 1;
+    }
+    if (levels.empty()) {
+        fprintf(stderr, "Error: empty cache configuration.\n");
+        exit(-1);
+    }
+    return levels;
+}
+
+// Replays the loads and stores in a trace through a cache hierarchy.
+// Traces record coordinates rather than addresses, so each Func is laid
+// out densely, with the innermost dimension first. Each realization of
+// a Func is placed at the same address, if the realizations were
+// traced, so that reusing a buffer looks like it does at runtime.
+struct MemorySimulator {
+    struct Box {
+        vector<int> min, extent;
+
+        int64_t elements() const {
+            int64_t n = 1;
+            for (int e : extent) n *= std::max(e, 0);
+            return n;
+        }
+
+        // The index of the given coordinates within the box, or -1 if
+        // they are outside of it.
+        int64_t index_of(const int *coords, int stride) const {
+            int64_t idx = 0, s = 1;
+            for (size_t i = 0; i < min.size(); i++) {
+                int c = coords[i * stride] - min[i];
+                if (c < 0 || c >= extent[i]) {
+                    return -1;
+                }
+                idx += c * s;
+                s *= extent[i];
+            }
+            return idx;
+        }
+    };
+
+    struct Realization {
+        int thread;
+        Box box;
+    };
+
+    struct FuncLayout {
+        // The bounding box of all accesses to the Func.
+        vector<int> min_coords, max_coords;
+        int64_t max_realization_elements = 0;
+        uint64_t base = 0;
+        int bytes = 0;
+        vector<std::pair<int, Realization>> open;  // by begin id
+    };
+
+    struct FuncStats {
+        uint64_t loads = 0, stores = 0, outside_realization = 0;
+        vector<uint64_t> hits;
+        uint64_t memory_bytes = 0;
+        // Counts of reuse distances in cache lines, bucketed by powers of
+        // two. The last bucket counts the first touch of each line.
+        vector<uint64_t> reuse;
+    };
+
+    vector<CacheLevel> levels;
+    map<string, FuncLayout> layouts;
+    map<string, FuncStats> stats;
+
+    // For computing reuse distances: when each line was last accessed,
+    // and a Fenwick tree over time that has a one at the last access of
+    // each line, so that the number of distinct lines accessed since a
+    // given time is a suffix sum.
+    map<uint64_t, uint64_t> last_access;
+    vector<int32_t> fenwick;
+    uint64_t now = 0;
+    static const int reuse_buckets = 40;
+
+    MemorySimulator(const vector<CacheLevel> &levels) : levels(levels) {}
+
+    // First pass: find how much space each Func needs.
+    void prepass(const Packet &p) {
+        if (p.event == halide_trace_begin_realization) {
+            Box box = realization_box(p);
+            FuncLayout &l = layouts[p.func()];
+            l.max_realization_elements = std::max(l.max_realization_elements, box.elements());
+        } else if (p.event == halide_trace_load || p.event == halide_trace_store) {
+            FuncLayout &l = layouts[p.func()];
+            int lanes = p.type.lanes;
+            int dims = p.dimensions / lanes;
+            if (l.min_coords.empty()) {
+                l.min_coords.resize(dims, INT32_MAX);
+                l.max_coords.resize(dims, INT32_MIN);
+            }
+            if ((int)l.min_coords.size() != dims) {
+                return;
+            }
+            l.bytes = std::max(l.bytes, (int)p.type.bytes());
+            for (int lane = 0; lane < lanes; lane++) {
+                for (int i = 0; i < dims; i++) {
+                    int c = p.coordinates()[lanes * i + lane];
+                    l.min_coords[i] = std::min(l.min_coords[i], c);
+                    l.max_coords[i] = std::max(l.max_coords[i], c);
+                }
+            }
+        }
+    }
+
+    // Lay out the Funcs one after the other, page-aligned.
+    void allocate() {
+        uint64_t next = 4096;
+        for (auto &it : layouts) {
+            FuncLayout &l = it.second;
+            // The bounding box of the accesses is used for accesses
+            // outside of any realization.
+            int64_t bbox = 1;
+            for (size_t i = 0; i < l.min_coords.size(); i++) {
+                bbox *= (int64_t)l.max_coords[i] - l.min_coords[i] + 1;
+            }
+            int64_t elements = std::max(l.max_realization_elements, bbox);
+            l.base = next;
+            next += ((uint64_t)elements * std::max(l.bytes, 1) + 4095) & ~(uint64_t)4095;
+        }
+    }
+
+    static Box realization_box(const Packet &p) {
+        Box box;
+        for (int i = 0; i + 1 < p.dimensions; i += 2) {
+            box.min.push_back(p.coordinates()[i]);
+            box.extent.push_back(p.coordinates()[i + 1]);
+        }
+        return box;
+    }
+
+    // Return the number of distinct lines accessed since the last access
+    // to 'line', or -1 if it hasn't been accessed before.
+    int64_t reuse_distance(uint64_t line) {
+        now++;
+        if (fenwick.size() <= now) {
+            fenwick.resize(std::max<size_t>(1024, fenwick.size() * 2), 0);
+            // Rebuild, since the tree structure depends on its size.
+            std::fill(fenwick.begin(), fenwick.end(), 0);
+            for (const auto &a : last_access) {
+                fenwick_add(a.second, 1);
+            }
+        }
+        int64_t distance = -1;
+        auto it = last_access.find(line);
+        if (it != last_access.end()) {
+            distance = fenwick_sum(now - 1) - fenwick_sum(it->second);
+            fenwick_add(it->second, -1);
+            it->second = now;
+        } else {
+            last_access[line] = now;
+        }
+        fenwick_add(now, 1);
+        return distance;
+    }
+
+    void fenwick_add(uint64_t i, int32_t v) {
+        for (; i < fenwick.size(); i += i & (~i + 1)) {
+            fenwick[i] += v;
+        }
+    }
+
+    int64_t fenwick_sum(uint64_t i) const {
+        int64_t sum = 0;
+        for (; i > 0; i -= i & (~i + 1)) {
+            sum += fenwick[i];
+        }
+        return sum;
+    }
+
+    // Second pass: replay the accesses.
+    void replay(const Packet &p) {
+        if (p.event == halide_trace_begin_realization) {
+            layouts[p.func()].open.push_back({p.id, Realization{p.thread_id(), realization_box(p)}});
+            return;
+        } else if (p.event == halide_trace_end_realization) {
+            auto &open = layouts[p.func()].open;
+            for (size_t i = 0; i < open.size(); i++) {
+                if (open[i].first == p.parent_id) {
+                    open.erase(open.begin() + i);
+                    break;
+                }
+            }
+            return;
+        } else if (p.event != halide_trace_load && p.event != halide_trace_store) {
+            return;
+        }
+
+        FuncLayout &l = layouts[p.func()];
+        FuncStats &st = stats[p.func()];
+        if (st.hits.empty()) {
+            st.hits.resize(levels.size(), 0);
+            st.reuse.resize(reuse_buckets + 1, 0);
+        }
+        int lanes = p.type.lanes;
+        int dims = p.dimensions / lanes;
+        int bytes = p.type.bytes();
+
+        // Find the realization being accessed: preferably one on the
+        // same thread, otherwise the innermost one.
+        const Realization *r = nullptr;
+        for (const auto &o : l.open) {
+            if (o.second.thread == p.thread_id()) {
+                r = &o.second;
+            }
+        }
+        if (!r && !l.open.empty()) {
+            r = &l.open.back().second;
+        }
+
+        for (int lane = 0; lane < lanes; lane++) {
+            const int *coords = p.coordinates() + lane;
+            int64_t idx = -1;
+            if (r && (int)r->box.min.size() == dims) {
+                idx = r->box.index_of(coords, lanes);
+            }
+            if (idx < 0 && (int)l.min_coords.size() == dims) {
+                Box bbox;
+                bbox.min = l.min_coords;
+                for (int i = 0; i < dims; i++) {
+                    bbox.extent.push_back(l.max_coords[i] - l.min_coords[i] + 1);
+                }
+                idx = bbox.index_of(coords, lanes);
+                if (r) {
+                    st.outside_realization++;
+                }
+            }
+            if (idx < 0) {
+                continue;
+            }
+            uint64_t addr = l.base + (uint64_t)idx * bytes;
+
+            if (p.event == halide_trace_load) {
+                st.loads++;
+            } else {
+                st.stores++;
+            }
+
+            int64_t distance = reuse_distance(addr / levels[0].line_size);
+            if (distance < 0) {
+                st.reuse[reuse_buckets]++;
+            } else {
+                int bucket = 0;
+                while (bucket < reuse_buckets - 1 && ((int64_t)1 << bucket) <= distance) {
+                    bucket++;
+                }
+                st.reuse[bucket]++;
+            }
+
+            size_t level = 0;
+            for (; level < levels.size(); level++) {
+                if (levels[level].access(addr)) {
+                    st.hits[level]++;
+                    break;
+                }
+            }
+            if (level == levels.size()) {
+                st.memory_bytes += levels.back().line_size;
+            }
+        }
+    }
+
+    void report() const {
+        printf("\nCache simulation:\n");
+        printf("  Levels:\n");
+        for (size_t i = 0; i < levels.size(); i++) {
+            printf("    L%d: %llu bytes, %d-way, %d byte lines\n", (int)i + 1,
+                   (unsigned long long)levels[i].size, levels[i].ways, levels[i].line_size);
+        }
+
+        uint64_t total_accesses = 0, total_bytes = 0;
+        printf("  Funcs:\n");
+        for (const auto &it : stats) {
+            const FuncStats &st = it.second;
+            uint64_t accesses = st.loads + st.stores;
+            total_accesses += accesses;
+            total_bytes += st.memory_bytes;
+            printf("    %s:\n", it.first.c_str());
+            printf("      Loads: %llu, stores: %llu\n",
+                   (unsigned long long)st.loads, (unsigned long long)st.stores);
+            if (st.outside_realization) {
+                printf("      Accesses outside their realization: %llu\n",
+                       (unsigned long long)st.outside_realization);
+            }
+            uint64_t reaching = accesses;
+            for (size_t i = 0; i < levels.size(); i++) {
+                printf("      L%d hit rate: %.2f%% (%llu of %llu)\n", (int)i + 1,
+                       reaching ? 100.0 * st.hits[i] / reaching : 0.0,
+                       (unsigned long long)st.hits[i], (unsigned long long)reaching);
+                reaching -= st.hits[i];
+            }
+            printf("      Bytes fetched from memory: %llu\n", (unsigned long long)st.memory_bytes);
+
+            // Report the median reuse distance, and the histogram.
+            uint64_t reused = accesses - st.reuse[reuse_buckets];
+            printf("      First touches of a line: %llu\n", (unsigned long long)st.reuse[reuse_buckets]);
+            if (reused) {
+                uint64_t seen = 0;
+                int median = 0;
+                for (; median < reuse_buckets; median++) {
+                    seen += st.reuse[median];
+                    if (seen * 2 >= reused) break;
+                }
+                printf("      Median reuse distance: < %llu lines\n", 1ULL << median);
+                printf("      Reuse distance histogram (lines: accesses):\n");
+                for (int b = 0; b < reuse_buckets; b++) {
+                    if (st.reuse[b]) {
+                        printf("        < %-12llu %llu\n", 1ULL << b, (unsigned long long)st.reuse[b]);
+                    }
+                }
+            }
+        }
+        printf("  Total accesses: %llu\n", (unsigned long long)total_accesses);
+        printf("  Total bytes fetched from memory: %llu\n", (unsigned long long)total_bytes);
+    }
+};
+
 void usage(char * const *argv) {
     const string usage =
         "Usage: " + string(argv[0]) + " -i trace_file -t {png,jpg,pgm,tmp,mat}\n"
+        "       " + string(argv[0]) + " -i trace_file -s\n"
+        "       " + string(argv[0]) + " -i trace_file -m [-c size:ways:line_size,...]\n"
         "\n"
         "This tool reads a binary trace produced by Halide, and dumps all\n"
         "Funcs into individual image files in the current directory.\n"
         "To generate a suitable binary trace, use Func::trace_stores(), or the\n"
         "target features trace_stores and trace_realizations, and run with\n"
-        "HL_TRACE_FILE=<filename>.\n";
+        "HL_TRACE_FILE=<filename>.\n"
+        "\n"
+        "With -s, it instead summarizes the time spent producing each Func,\n"
+        "the time each thread was busy, and the critical path of each\n"
+        "pipeline. This needs a trace of the realizations, with timestamps,\n"
+        "which are recorded if HL_TRACE_TIMING=1 is also set.\n"
+        "\n"
+        "With -m, it replays the traced loads and stores through a simulated\n"
+        "cache hierarchy, and reports the hit rates, the bytes fetched from\n"
+        "memory and the reuse distances of the accesses to each Func. Use -c\n"
+        "to describe the cache levels, fastest first. Sizes may be given in\n"
+        "K or M. The default is 32K:8:64,256K:8:64,8M:16:64.\n";
     fprintf(stderr, "%s\n", usage.c_str());
     exit(1);
 }
@@ -284,21 +922,81 @@ void usage(char * const *argv) {
 int main(int argc, char * const *argv) {
     char *buf_filename = nullptr;
     char *buf_imagetype = nullptr;
+    bool summarize = false, simulate = false;
+    string cache_config = "32K:8:64,256K:8:64,8M:16:64";
     BufferOutputOpts outputopts;
-    for (int i = 1; i < argc - 1; i++) {
+    for (int i = 1; i < argc; i++) {
         string arg = argv[i];
-        if (arg == "-t") {
+        if (arg == "-s") {
+            summarize = true;
+        } else if (arg == "-m") {
+            simulate = true;
+        } else if (i == argc - 1) {
+            break;
+        } else if (arg == "-t") {
             i++;
             buf_imagetype = argv[i];
         } else if (arg == "-i") {
             i++;
             buf_filename = argv[i];
+        } else if (arg == "-c") {
+            i++;
+            cache_config = argv[i];
         }
     }
 
     if (buf_filename == nullptr) {
         usage(argv);
     }
+    if (summarize) {
+        FILE *file_desc = fopen(buf_filename, "r");
+        if (file_desc == nullptr) {
+            fprintf(stderr, "[Error opening file: %s. Exiting.\n", buf_filename);
+            exit(1);
+        }
+        TraceSummary summary;
+        for (;;) {
+            Packet p;
+            if (!p.read_from_filedesc(file_desc)) {
+                break;
+            }
+            summary.add(p);
+        }
+        fclose(file_desc);
+        summary.report();
+        return 0;
+    }
+
+    if (simulate) {
+        MemorySimulator sim(parse_cache_config(cache_config));
+        FILE *file_desc = fopen(buf_filename, "r");
+        if (file_desc == nullptr) {
+            fprintf(stderr, "[Error opening file: %s. Exiting.\n", buf_filename);
+            exit(1);
+        }
+        printf("[INFO] Laying out Funcs...\n");
+        for (;;) {
+            Packet p;
+            if (!p.read_from_filedesc(file_desc)) {
+                break;
+            }
+            sim.prepass(p);
+        }
+        sim.allocate();
+        fseek(file_desc, 0, SEEK_SET);
+        printf("[INFO] Replaying accesses...\n");
+        for (;;) {
+            Packet p;
+            if (!p.read_from_filedesc(file_desc)) {
+                break;
+            }
+            sim.replay(p);
+        }
+        fclose(file_desc);
+        sim.report();
+        return 0;
+    }
+
     if (buf_imagetype == nullptr) {
         usage(argv);
     }
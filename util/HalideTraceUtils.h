@@ -83,6 +83,24 @@ struct Packet : public halide_trace_packet_t {
         return value_as<T>(type, aligned_value);
     }
 
+    // Whether this packet records when and on which thread the event
+    // happened. Packets from older traces don't.
+    bool has_ext() const {
+        return ext() != nullptr;
+    }
+
+    // The time of the event in nanoseconds, or zero if unknown.
+    uint64_t time_ns() const {
+        const halide_trace_packet_ext_t *e = ext();
+        return e ? e->time_ns() : 0;
+    }
+
+    // The id of the thread that emitted the event, or -1 if unknown.
+    int thread_id() const {
+        const halide_trace_packet_ext_t *e = ext();
+        return e ? e->thread_id : -1;
+    }
+
     // Grab a packet from stdin. Returns false when stdin closes.
     bool read_from_stdin();
 